@@ -0,0 +1,46 @@
+#include "AllocationCounter.h"
+
+#if LUSION_COUNT_ALLOCATIONS
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local juce::int64 threadAllocations = 0;
+}
+
+juce::int64 AllocationCounter::getThreadCount() noexcept
+{
+    return threadAllocations;
+}
+
+// The nothrow and array forms call these by default
+void* operator new (std::size_t size)
+{
+    ++threadAllocations;
+
+    if (auto* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete (void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete (void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+#else
+
+juce::int64 AllocationCounter::getThreadCount() noexcept
+{
+    return 0;
+}
+
+#endif
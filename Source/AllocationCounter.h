@@ -0,0 +1,44 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Counting replaces the global operator new, so it is only compiled into
+// debug builds unless asked for explicitly
+#ifndef LUSION_COUNT_ALLOCATIONS
+ #define LUSION_COUNT_ALLOCATIONS JUCE_DEBUG
+#endif
+
+//==============================================================================
+// Debug check that a hot path makes no heap allocations.
+//
+// Counts operator new calls per thread. A ScopedCheck asserts in its
+// destructor that the calling thread allocated nothing during its lifetime,
+// unless allow() said this pass legitimately had to. In builds without
+// counting everything here compiles to nothing.
+//==============================================================================
+namespace AllocationCounter
+{
+    // Allocations made so far by the calling thread (0 without counting)
+    juce::int64 getThreadCount() noexcept;
+
+    class ScopedCheck
+    {
+    public:
+        ScopedCheck() noexcept : start(getThreadCount()) {}
+
+        ~ScopedCheck()
+        {
+            jassert(allowed || getThreadCount() == start);
+        }
+
+        // Allocations in this scope are expected this time round
+        void allow() noexcept { allowed = true; }
+
+        juce::int64 getAllocations() const noexcept { return getThreadCount() - start; }
+
+    private:
+        const juce::int64 start;
+        bool allowed = false;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedCheck)
+    };
+}
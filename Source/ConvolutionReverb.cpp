@@ -0,0 +1,663 @@
+#include "ConvolutionReverb.h"
+
+namespace
+{
+    // Same wet/dry law as the algorithmic engines, so switching modes keeps levels
+    constexpr float wetScaleFactor = 3.0f;
+    constexpr float dryScaleFactor = 2.0f;
+
+    // The body sums its partitions once per block, so longer ones mean fewer
+    // of them. Below this size a long IR costs more in partitions to sum than
+    // the head saves, whatever size the calls are.
+    constexpr int minPartitionSize = 512;
+    constexpr int maxPartitionSize = 8192;
+
+    // The head transforms its partial block on every call, so it follows the
+    // call size; below this, FFTs this small stop paying for themselves
+    constexpr int minHeadSize = 32;
+}
+
+//==============================================================================
+// PARTITIONED CONVOLVER
+//==============================================================================
+void PartitionedConvolver::Stage::allocate(int partitionSize, int numPartitions)
+{
+    size = partitionSize;
+    numParts = juce::jmax(1, numPartitions);
+    spectrumSize = getSpectrumSize(partitionSize);
+
+    window.calloc((size_t)(2 * size));
+    fdl.calloc((size_t)(numParts * spectrumSize));
+    sum.calloc((size_t)spectrumSize);
+}
+
+void PartitionedConvolver::Stage::clear()
+{
+    juce::FloatVectorOperations::clear(window.get(), 2 * size);
+    juce::FloatVectorOperations::clear(fdl.get(), numParts * spectrumSize);
+    juce::FloatVectorOperations::clear(sum.get(), spectrumSize);
+
+    inputPos = 0;
+    fdlHead = 0;
+}
+
+void PartitionedConvolver::Stage::sumPastBlocks(const float* impulseSpectra) noexcept
+{
+    const auto multiplyAccumulate = DspKernels::get().multiplyAccumulate;
+
+    juce::FloatVectorOperations::clear(sum.get(), spectrumSize);
+
+    for (int p = 1; p < numParts; ++p)
+    {
+        const int slot = (fdlHead - p + numParts) % numParts;
+        multiplyAccumulate(fdl + slot * spectrumSize, impulseSpectra + p * spectrumSize, sum, size);
+    }
+}
+
+void PartitionedConvolver::Stage::advance() noexcept
+{
+    fdlHead = (fdlHead + 1) % numParts;
+
+    juce::FloatVectorOperations::copy(window.get(), window + size, size);
+    juce::FloatVectorOperations::clear(window + size, size);
+    inputPos = 0;
+}
+
+void PartitionedConvolver::Stage::saveState(juce::OutputStream& out) const
+{
+    SnapshotIO::write(out, size);
+    SnapshotIO::write(out, numParts);
+    SnapshotIO::write(out, inputPos);
+    SnapshotIO::write(out, fdlHead);
+
+    SnapshotIO::writeArray(out, window.get(), (size_t)(2 * size));
+    SnapshotIO::writeArray(out, fdl.get(), (size_t)(numParts * spectrumSize));
+    SnapshotIO::writeArray(out, sum.get(), (size_t)spectrumSize);
+}
+
+bool PartitionedConvolver::Stage::restoreState(juce::InputStream& in)
+{
+    int savedSize = 0, savedNumParts = 0;
+
+    if (!SnapshotIO::read(in, savedSize) || !SnapshotIO::read(in, savedNumParts)
+        || savedSize != size || savedNumParts != numParts)
+        return false;
+
+    if (!SnapshotIO::read(in, inputPos) || inputPos < 0 || inputPos >= size
+        || !SnapshotIO::read(in, fdlHead) || fdlHead < 0 || fdlHead >= numParts)
+        return false;
+
+    return SnapshotIO::readArray(in, window.get(), (size_t)(2 * size))
+        && SnapshotIO::readArray(in, fdl.get(), (size_t)(numParts * spectrumSize))
+        && SnapshotIO::readArray(in, sum.get(), (size_t)spectrumSize);
+}
+
+//==============================================================================
+void PartitionedConvolver::prepare(int partitionSize, int numPartitions, int headSize)
+{
+    jassert(headSize > 0 && headSize <= partitionSize && partitionSize % headSize == 0);
+
+    body.allocate(partitionSize, numPartitions);
+    head.allocate(headSize, partitionSize / headSize);
+
+    bodyOutput.calloc((size_t)partitionSize);
+    accumulated.calloc((size_t)head.spectrumSize);
+    work.calloc((size_t)(4 * partitionSize));
+
+    reset();
+}
+
+void PartitionedConvolver::reset()
+{
+    if (work == nullptr)
+        return;
+
+    body.clear();
+    head.clear();
+    juce::FloatVectorOperations::clear(bodyOutput.get(), body.size);
+}
+
+void PartitionedConvolver::saveState(juce::OutputStream& out) const
+{
+    body.saveState(out);
+    head.saveState(out);
+    SnapshotIO::writeArray(out, bodyOutput.get(), (size_t)body.size);
+}
+
+bool PartitionedConvolver::restoreState(juce::InputStream& in)
+{
+    return body.restoreState(in)
+        && head.restoreState(in)
+        && body.inputPos % head.size == head.inputPos
+        && SnapshotIO::readArray(in, bodyOutput.get(), (size_t)body.size);
+}
+
+void PartitionedConvolver::packSpectrum(const float* interleaved, float* split, int partitionSize) noexcept
+{
+    float* re = split;
+    float* im = split + partitionSize;
+
+    for (int k = 0; k < partitionSize; ++k)
+    {
+        re[k] = interleaved[2 * k];
+        im[k] = interleaved[2 * k + 1];
+    }
+
+    // DC and Nyquist are both real; keep Nyquist in DC's imaginary slot
+    im[0] = interleaved[2 * partitionSize];
+}
+
+void PartitionedConvolver::unpackSpectrum(const float* split, float* interleaved, int partitionSize) noexcept
+{
+    const float* re = split;
+    const float* im = split + partitionSize;
+
+    for (int k = 0; k < partitionSize; ++k)
+    {
+        interleaved[2 * k] = re[k];
+        interleaved[2 * k + 1] = im[k];
+    }
+
+    interleaved[1] = 0.0f;
+    interleaved[2 * partitionSize] = im[0];
+    interleaved[2 * partitionSize + 1] = 0.0f;
+}
+
+void PartitionedConvolver::createHeadSpectra(const juce::dsp::FFT& fft, const float* impulseSpectra, int partitionSize,
+                                             const juce::dsp::FFT& headFft, float* headSpectra, int headSize)
+{
+    // The first partition's samples, back from its spectrum
+    juce::HeapBlock<float> impulse((size_t)(4 * partitionSize), true);
+    unpackSpectrum(impulseSpectra, impulse, partitionSize);
+    fft.performRealOnlyInverseTransform(impulse);
+
+    juce::HeapBlock<float> work((size_t)(4 * headSize));
+    const int spectrumSize = getSpectrumSize(headSize);
+
+    for (int p = 0; p < partitionSize / headSize; ++p)
+    {
+        juce::FloatVectorOperations::clear(work.get(), 4 * headSize);
+        juce::FloatVectorOperations::copy(work.get(), impulse + p * headSize, headSize);
+
+        headFft.performRealOnlyForwardTransform(work, true);
+        packSpectrum(work, headSpectra + p * spectrumSize, headSize);
+    }
+}
+
+template <typename SampleType>
+void PartitionedConvolver::process(const juce::dsp::FFT& fft, const float* impulseSpectra,
+                                   const juce::dsp::FFT& headFft, const float* headSpectra,
+                                   const SampleType* input, float* output, int numSamples) noexcept
+{
+    const int B = body.size, H = head.size;
+    const auto multiplyAccumulate = DspKernels::get().multiplyAccumulate;
+    int done = 0;
+
+    while (done < numSamples)
+    {
+        // H divides B, so a head block never straddles two body blocks
+        const int numToProcess = juce::jmin(numSamples - done, H - head.inputPos);
+
+        float* bodyInput = body.window + B + body.inputPos;
+        SampleConversion::toFloat(bodyInput, input + done, numToProcess);
+        juce::FloatVectorOperations::copy(head.window + H + head.inputPos, bodyInput, numToProcess);
+
+        // The head's partitions 1..P-1 only see its complete past blocks
+        if (head.inputPos == 0)
+            head.sumPastBlocks(headSpectra);
+
+        // The head's current window holds the samples received so far
+        // followed by zeros, which is exactly what the outputs up to
+        // inputPos depend on. Its spectrum goes straight into the newest
+        // slot, which is only read once the block is complete.
+        float* current = head.fdl + head.fdlHead * head.spectrumSize;
+
+        juce::FloatVectorOperations::copy(work.get(), head.window.get(), 2 * H);
+        headFft.performRealOnlyForwardTransform(work, true);
+        packSpectrum(work, current, H);
+
+        juce::FloatVectorOperations::copy(accumulated.get(), head.sum.get(), head.spectrumSize);
+        multiplyAccumulate(current, headSpectra, accumulated, H);
+
+        unpackSpectrum(accumulated, work, H);
+        headFft.performRealOnlyInverseTransform(work);
+
+        juce::FloatVectorOperations::add(output + done, work + H + head.inputPos, bodyOutput + body.inputPos, numToProcess);
+
+        head.inputPos += numToProcess;
+        body.inputPos += numToProcess;
+        done += numToProcess;
+
+        if (head.inputPos == H)
+            head.advance();
+
+        if (body.inputPos == B)
+        {
+            juce::FloatVectorOperations::copy(work.get(), body.window.get(), 2 * B);
+            fft.performRealOnlyForwardTransform(work, true);
+            packSpectrum(work, body.fdl + body.fdlHead * body.spectrumSize, B);
+
+            body.advance();
+
+            // Everything the body adds to the next block is known now
+            if (body.numParts > 1)
+            {
+                body.sumPastBlocks(impulseSpectra);
+                unpackSpectrum(body.sum, work, B);
+                fft.performRealOnlyInverseTransform(work);
+                juce::FloatVectorOperations::copy(bodyOutput.get(), work + B, B);
+            }
+        }
+    }
+}
+
+//==============================================================================
+// IMPULSE RESPONSE LOADER
+//==============================================================================
+class ConvolutionReverb::Loader : public juce::Thread
+{
+public:
+    explicit Loader(ConvolutionReverb& o)
+        : juce::Thread("IR Loader"), owner(o)
+    {
+        formatManager.registerBasicFormats();
+    }
+
+    ~Loader() override
+    {
+        stopThread(4000);
+    }
+
+    void request(const juce::File& newFile, double newSampleRate, int newPartitionSize, int newHeadSize)
+    {
+        {
+            const juce::ScopedLock sl(lock);
+            job = { newFile, newSampleRate, newPartitionSize, newHeadSize };
+            hasJob = newFile.existsAsFile() && newPartitionSize > 0;
+
+            if (!hasJob)
+                return;
+        }
+
+        if (!isThreadRunning())
+            startThread();
+
+        notify();
+    }
+
+    juce::File getFile() const
+    {
+        const juce::ScopedLock sl(lock);
+        return job.file;
+    }
+
+    bool isBusy() const
+    {
+        const juce::ScopedLock sl(lock);
+        return hasJob || building;
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            Job next;
+            bool hasNext;
+
+            {
+                const juce::ScopedLock sl(lock);
+                next = job;
+                hasNext = hasJob;
+                building = hasJob;
+                hasJob = false;
+            }
+
+            if (hasNext)
+            {
+                if (auto kernel = createKernel(next))
+                    publish(kernel);
+
+                const juce::ScopedLock sl(lock);
+                building = false;
+            }
+
+            collectGarbage();
+            wait(500);
+        }
+    }
+
+private:
+    struct Job
+    {
+        juce::File file;
+        double sampleRate = 0.0;
+        int partitionSize = 0, headSize = 0;
+    };
+
+    Kernel::Ptr createKernel(const Job& j)
+    {
+        // Decoding, resampling and partitioning are shared by every instance
+        // that loads the same file at the same rate and partition size
+        auto impulse = cache->getOrCreate(j.file, j.sampleRate, j.partitionSize, formatManager);
+
+        if (impulse == nullptr)
+            return nullptr;
+
+        Kernel::Ptr kernel = new Kernel();
+        kernel->impulse = impulse;
+        kernel->fft = std::make_unique<juce::dsp::FFT>(juce::roundToInt(std::log2(2 * j.partitionSize)));
+        kernel->headSize = j.headSize;
+        kernel->headFft = std::make_unique<juce::dsp::FFT>(juce::roundToInt(std::log2(2 * j.headSize)));
+
+        // Per instance, as the head size follows this instance's blocks; it
+        // is only the first partition, so small
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            kernel->headSpectra[ch].malloc((size_t)PartitionedConvolver::getSpectrumSize(j.partitionSize));
+            PartitionedConvolver::createHeadSpectra(*kernel->fft, impulse->getSpectra(ch), j.partitionSize,
+                                                    *kernel->headFft, kernel->headSpectra[ch], j.headSize);
+        }
+
+        for (auto& convolver : kernel->convolvers)
+            convolver.prepare(j.partitionSize, impulse->getNumPartitions(), j.headSize);
+
+        return kernel;
+    }
+
+    void publish(const Kernel::Ptr& kernel)
+    {
+        releasePool.add(kernel);
+
+        // The pending slot owns one reference, which the audio thread takes over
+        kernel->incReferenceCount();
+
+        if (auto* superseded = owner.pending.exchange(kernel.get(), std::memory_order_acq_rel))
+            superseded->decReferenceCountWithoutDeleting();
+
+        owner.impulseSeconds = kernel->impulse->getNumPartitions() * kernel->impulse->getPartitionSize()
+                                 / kernel->impulse->getKey().sampleRate;
+    }
+
+    void collectGarbage()
+    {
+        // Anything only the pool still references can no longer reach the audio thread
+        for (int i = releasePool.size(); --i >= 0;)
+            if (releasePool.getObjectPointerUnchecked(i)->getReferenceCount() == 1)
+                releasePool.remove(i);
+
+        cache->purgeUnused();
+    }
+
+    ConvolutionReverb& owner;
+    juce::AudioFormatManager formatManager;
+    juce::SharedResourcePointer<ImpulseResponseCache> cache;
+
+    juce::CriticalSection lock;
+    Job job;
+    bool hasJob = false, building = false;
+
+    juce::ReferenceCountedArray<Kernel> releasePool;
+};
+
+//==============================================================================
+// CONVOLUTION REVERB
+//==============================================================================
+ConvolutionReverb::ConvolutionReverb()
+    : loader(std::make_unique<Loader>(*this))
+{
+}
+
+ConvolutionReverb::~ConvolutionReverb()
+{
+    loader->stopThread(4000);
+
+    if (auto* k = pending.exchange(nullptr))
+        k->decReferenceCount();
+
+    active = nullptr;
+    loader.reset();
+}
+
+void ConvolutionReverb::prepare(double newSampleRate, int samplesPerBlock)
+{
+    sampleRate = newSampleRate;
+    partitionSize = juce::jlimit(minPartitionSize, maxPartitionSize, juce::nextPowerOfTwo(samplesPerBlock));
+    headSize = juce::jlimit(minHeadSize, partitionSize, juce::nextPowerOfTwo(samplesPerBlock));
+
+    wetBufferSize = juce::jmax(1, samplesPerBlock);
+    wetBuffer.calloc((size_t)(2 * wetBufferSize));
+
+    // Kernels are built for one rate and partition size, so drop the old ones
+    if (auto* k = pending.exchange(nullptr))
+        k->decReferenceCountWithoutDeleting();
+
+    active = nullptr;
+    impulseSeconds = 0.0;
+
+    const double smoothTime = 0.01;
+    dryGain.reset(sampleRate, smoothTime);
+    wetGain1.reset(sampleRate, smoothTime);
+    wetGain2.reset(sampleRate, smoothTime);
+
+    updateMixGains();
+    requestLoad();
+}
+
+void ConvolutionReverb::reset()
+{
+    if (active != nullptr)
+        for (auto& convolver : active->convolvers)
+            convolver.reset();
+
+    dryGain.setCurrentAndTargetValue(dryGain.getTargetValue());
+    wetGain1.setCurrentAndTargetValue(wetGain1.getTargetValue());
+    wetGain2.setCurrentAndTargetValue(wetGain2.getTargetValue());
+}
+
+void ConvolutionReverb::loadImpulseResponse(const juce::File& file)
+{
+    loader->request(file, sampleRate, partitionSize, headSize);
+}
+
+juce::File ConvolutionReverb::getImpulseResponseFile() const
+{
+    return loader->getFile();
+}
+
+bool ConvolutionReverb::isLoading() const
+{
+    return loader->isBusy();
+}
+
+double ConvolutionReverb::getTailSeconds() const
+{
+    return impulseSeconds.load();
+}
+
+void ConvolutionReverb::requestLoad()
+{
+    loader->request(loader->getFile(), sampleRate, partitionSize, headSize);
+}
+
+//==============================================================================
+void ConvolutionReverb::saveState(juce::OutputStream& out, bool includeBuffers) const
+{
+    SnapshotIO::write(out, wetLevel);
+    SnapshotIO::write(out, width);
+
+    for (const auto* s : { &dryGain, &wetGain1, &wetGain2 })
+        SnapshotIO::write(out, *s);
+
+    // The IR itself isn't stored, only which one the state belongs to
+    const bool hasKernel = includeBuffers && active != nullptr;
+    SnapshotIO::write(out, hasKernel);
+
+    if (!hasKernel)
+        return;
+
+    SnapshotIO::write(out, active->impulse->getKey());
+
+    for (const auto& convolver : active->convolvers)
+        convolver.saveState(out);
+}
+
+bool ConvolutionReverb::restoreState(juce::InputStream& in)
+{
+    if (!(SnapshotIO::read(in, wetLevel) && SnapshotIO::read(in, width)))
+        return false;
+
+    for (auto* s : { &dryGain, &wetGain1, &wetGain2 })
+        if (!SnapshotIO::read(in, *s))
+            return false;
+
+    bool hasKernel = false;
+
+    if (!SnapshotIO::read(in, hasKernel))
+        return false;
+
+    // A finished load that hasn't been picked up yet is what the next block would use
+    pullPendingKernel();
+
+    if (!hasKernel)
+    {
+        if (active != nullptr)
+            for (auto& convolver : active->convolvers)
+                convolver.reset();
+
+        return true;
+    }
+
+    ImpulseResponseCache::Key key;
+
+    if (!SnapshotIO::read(in, key) || active == nullptr || !(key == active->impulse->getKey()))
+        return false;
+
+    for (auto& convolver : active->convolvers)
+        if (!convolver.restoreState(in))
+            return false;
+
+    return true;
+}
+
+//==============================================================================
+void ConvolutionReverb::setWet(float value)
+{
+    wetLevel = juce::jlimit(0.0f, 1.0f, value);
+    updateMixGains();
+}
+
+void ConvolutionReverb::setWidth(float value)
+{
+    width = juce::jlimit(0.0f, 1.0f, value);
+    updateMixGains();
+}
+
+void ConvolutionReverb::setDryEnabled(bool enabled)
+{
+    dryEnabled = enabled;
+    updateMixGains();
+    dryGain.setCurrentAndTargetValue(dryGain.getTargetValue());
+}
+
+void ConvolutionReverb::updateMixGains()
+{
+    const float wet = wetLevel * wetScaleFactor;
+
+    dryGain.setTargetValue(dryEnabled ? (1.0f - wetLevel) * dryScaleFactor : 0.0f);
+    wetGain1.setTargetValue(0.5f * wet * (1.0f + width));
+    wetGain2.setTargetValue(0.5f * wet * (1.0f - width));
+}
+
+void ConvolutionReverb::pullPendingKernel() noexcept
+{
+    if (pending.load(std::memory_order_relaxed) == nullptr)
+        return;
+
+    if (auto* next = pending.exchange(nullptr, std::memory_order_acq_rel))
+    {
+        const auto& key = next->impulse->getKey();
+
+        // The release pool still holds the old kernel, so this never frees.
+        // A build that was already running when prepare() changed the rate
+        // or block size can still land here afterwards; it is dropped, and
+        // the load prepare() asked for follows.
+        if (key.sampleRate == sampleRate && key.partitionSize == partitionSize && next->headSize == headSize)
+            active = next;
+
+        next->decReferenceCountWithoutDeleting();
+    }
+}
+
+//==============================================================================
+template <bool isStereo, bool isDucked, typename SampleType>
+void ConvolutionReverb::processSamples(SampleType* left, SampleType* right, int numSamples, const float* wetScale) noexcept
+{
+    constexpr int numChannels = isStereo ? 2 : 1;
+
+    pullPendingKernel();
+
+    float* wetL = wetBuffer.get();
+    float* wetR = wetBuffer + wetBufferSize;
+
+    for (int start = 0; start < numSamples; start += wetBufferSize)
+    {
+        const int n = juce::jmin(wetBufferSize, numSamples - start);
+        SampleType* l = left + start;
+        SampleType* r = isStereo ? right + start : nullptr;
+        const float* duck = isDucked ? wetScale + start : nullptr;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            float* wet = ch == 0 ? wetL : wetR;
+
+            if (active != nullptr)
+                active->convolvers[ch].process(*active->fft, active->impulse->getSpectra(ch),
+                                               *active->headFft, active->headSpectra[ch], ch == 0 ? l : r, wet, n);
+            else
+                juce::FloatVectorOperations::clear(wet, n);
+        }
+
+        for (int i = 0; i < n; ++i)
+        {
+            const float scale = isDucked ? duck[i] : 1.0f;
+            const float dry = dryGain.getNextValue();
+            const float wet1 = wetGain1.getNextValue() * scale;
+
+            // The dry signal keeps the host's precision
+            if constexpr (isStereo)
+            {
+                const float wet2 = wetGain2.getNextValue() * scale;
+
+                l[i] = (SampleType)(wetL[i] * wet1 + wetR[i] * wet2) + l[i] * dry;
+                r[i] = (SampleType)(wetR[i] * wet1 + wetL[i] * wet2) + r[i] * dry;
+            }
+            else
+            {
+                l[i] = (SampleType)(wetL[i] * wet1) + l[i] * dry;
+            }
+        }
+    }
+}
+
+template <typename SampleType>
+void ConvolutionReverb::processMono(SampleType* samples, int numSamples, const float* wetScale)
+{
+    if (wetScale != nullptr)
+        processSamples<false, true>(samples, (SampleType*)nullptr, numSamples, wetScale);
+    else
+        processSamples<false, false>(samples, (SampleType*)nullptr, numSamples, wetScale);
+}
+
+template <typename SampleType>
+void ConvolutionReverb::processStereo(SampleType* left, SampleType* right, int numSamples, const float* wetScale)
+{
+    if (wetScale != nullptr)
+        processSamples<true, true>(left, right, numSamples, wetScale);
+    else
+        processSamples<true, false>(left, right, numSamples, wetScale);
+}
+
+template void ConvolutionReverb::processMono(float*, int, const float*);
+template void ConvolutionReverb::processMono(double*, int, const float*);
+template void ConvolutionReverb::processStereo(float*, float*, int, const float*);
+template void ConvolutionReverb::processStereo(double*, double*, int, const float*);
@@ -0,0 +1,180 @@
+#pragma once
+#include <JuceHeader.h>
+#include "ImpulseResponseCache.h"
+#include "SnapshotIO.h"
+#include "SampleConversion.h"
+#include "DspKernels.h"
+
+//==============================================================================
+// Two-stage uniformly partitioned overlap-save convolver for one channel.
+//
+// The body cuts the IR into partitions of B samples (with a floor of 512)
+// and only ever sees complete blocks: once per block it transforms the block
+// that just finished and sums partitions 1..P-1 into the time-domain output
+// for the next one. The first partition is convolved by the head instead, in
+// partitions of H samples, which follows the call size. The head produces
+// output on every call by transforming its partially filled current block
+// again, which costs a 2H FFT pair rather than a 2B one. That keeps the
+// added latency at zero for any call size, without a full-size transform
+// per control block.
+//==============================================================================
+class PartitionedConvolver
+{
+public:
+    // Complex spectra are stored split as [re(B) | im(B)] per partition, with
+    // the (purely real) Nyquist bin packed into im[0].
+    static int getSpectrumSize(int partitionSize) noexcept { return 2 * partitionSize; }
+
+    // headSize divides partitionSize; both are powers of two
+    void prepare(int partitionSize, int numPartitions, int headSize);
+    void reset();
+
+    // input is float or double; it is taken into the float window directly.
+    // headSpectra are the first partition re-cut by createHeadSpectra.
+    template <typename SampleType>
+    void process(const juce::dsp::FFT& fft, const float* impulseSpectra,
+                 const juce::dsp::FFT& headFft, const float* headSpectra,
+                 const SampleType* input, float* output, int numSamples) noexcept;
+
+    void saveState(juce::OutputStream& out) const;
+    bool restoreState(juce::InputStream& in);
+
+    // Helpers shared with the impulse-response loader
+    static void packSpectrum(const float* interleaved, float* split, int partitionSize) noexcept;
+    static void unpackSpectrum(const float* split, float* interleaved, int partitionSize) noexcept;
+
+    // Off the audio thread: cuts the first of an IR's partitions into
+    // partitionSize / headSize head partitions, written to headSpectra
+    static void createHeadSpectra(const juce::dsp::FFT& fft, const float* impulseSpectra, int partitionSize,
+                                  const juce::dsp::FFT& headFft, float* headSpectra, int headSize);
+
+private:
+    // One partition size's input window and frequency-domain delay line
+    struct Stage
+    {
+        void allocate(int partitionSize, int numPartitions);
+        void clear();
+
+        // sum = the newest-but-p spectra times partitions p = 1..P-1, for the
+        // block after the newest
+        void sumPastBlocks(const float* impulseSpectra) noexcept;
+
+        // The current block is complete and its spectrum is in the newest
+        // slot: moves on to the next
+        void advance() noexcept;
+
+        void saveState(juce::OutputStream& out) const;
+        bool restoreState(juce::InputStream& in);
+
+        int size = 0, numParts = 0, spectrumSize = 0;
+        int inputPos = 0, fdlHead = 0;
+
+        juce::HeapBlock<float> window;  // [previous block | current block]
+        juce::HeapBlock<float> fdl;     // numParts spectra, fdlHead the current block's
+        juce::HeapBlock<float> sum;     // contribution of partitions 1..P-1
+    };
+
+    Stage body, head;
+
+    juce::HeapBlock<float> bodyOutput;  // the body's output for the current block
+    juce::HeapBlock<float> accumulated; // the head's current block * G0 + sum
+    juce::HeapBlock<float> work;        // FFT scratch, 2 * fftSize
+};
+
+//==============================================================================
+// Convolution reverb mode.
+//
+// Impulse responses are fetched from the shared ImpulseResponseCache on a
+// background thread and wrapped in a Kernel that owns the per-instance
+// convolver state. The audio thread picks up new kernels through an atomic
+// pointer and never allocates or frees: kernels are only deleted by the
+// loader, once nothing but its release pool still references them.
+//==============================================================================
+class ConvolutionReverb
+{
+public:
+    ConvolutionReverb();
+    ~ConvolutionReverb();
+
+    void prepare(double sampleRate, int samplesPerBlock);
+    void reset();
+
+    // Message thread. Loading happens asynchronously; until the new IR is
+    // ready the previous one (or silence) keeps playing.
+    void loadImpulseResponse(const juce::File& file);
+    juce::File getImpulseResponseFile() const;
+
+    // True while a requested IR is still being built. Offline renders wait
+    // for this before processing so the first blocks aren't rendered dry.
+    bool isLoading() const;
+
+    // Length of the most recently built IR, or 0 if none is loaded. The
+    // output stops changing exactly this long after the input does.
+    double getTailSeconds() const;
+
+    // Exact state snapshot, for the processing thread between blocks. The
+    // convolver state is only restored into the same IR at the same
+    // partition size; without buffers it is cleared as reset() does.
+    void saveState(juce::OutputStream& out, bool includeBuffers) const;
+    bool restoreState(juce::InputStream& in);
+
+    void setWet(float value);
+    void setWidth(float value);
+
+    // With the dry signal off the tank outputs only its wet mix; eco mode
+    // adds the dry back itself at the host rate. Takes effect immediately.
+    void setDryEnabled(bool enabled);
+
+    // wetScale, if given, holds a gain per sample for the wet signal (ducking).
+    // Takes float or double samples; the convolution itself runs in float.
+    template <typename SampleType>
+    void processMono(SampleType* samples, int numSamples, const float* wetScale = nullptr);
+
+    template <typename SampleType>
+    void processStereo(SampleType* left, SampleType* right, int numSamples, const float* wetScale = nullptr);
+
+    static constexpr double maxImpulseSeconds = 10.0;
+
+private:
+    struct Kernel : public juce::ReferenceCountedObject
+    {
+        using Ptr = juce::ReferenceCountedObjectPtr<Kernel>;
+
+        ImpulseResponseCache::Entry::Ptr impulse;  // shared, read-only partitions
+        std::unique_ptr<juce::dsp::FFT> fft;
+
+        // The first partition, re-cut for the convolvers' heads
+        int headSize = 0;
+        std::unique_ptr<juce::dsp::FFT> headFft;
+        juce::HeapBlock<float> headSpectra[2];
+
+        PartitionedConvolver convolvers[2];
+    };
+
+    class Loader;
+
+    template <bool isStereo, bool isDucked, typename SampleType>
+    void processSamples(SampleType* left, SampleType* right, int numSamples, const float* wetScale) noexcept;
+
+    void requestLoad();
+    void pullPendingKernel() noexcept;
+    void updateMixGains();
+
+    double sampleRate = 44100.0;
+    int partitionSize = 0, headSize = 0;
+
+    float wetLevel = 0.3f, width = 1.0f;
+    bool dryEnabled = true;
+    juce::SmoothedValue<float> dryGain, wetGain1, wetGain2;
+
+    Kernel::Ptr active;
+    std::atomic<Kernel*> pending{ nullptr };
+    std::atomic<double> impulseSeconds{ 0.0 };
+
+    juce::HeapBlock<float> wetBuffer;
+    int wetBufferSize = 0;
+
+    std::unique_ptr<Loader> loader;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ConvolutionReverb)
+};
@@ -0,0 +1,368 @@
+#include <JuceHeader.h>
+#include "DspKernels.h"
+
+namespace
+{
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    template <typename Type>
+    inline void undenormalise(Type& x) noexcept
+    {
+       #if JUCE_INTEL
+        x += 0.1f;
+        x -= 0.1f;
+       #else
+        juce::ignoreUnused(x);
+       #endif
+    }
+
+    //==============================================================================
+    // Baseline kernels: the plugin's own compiler flags, and JUCE's SIMD types
+    void combSteps(float* tile, int rowStride, int numRows, int numLanes, float* last,
+                   const float* damping, const float* feedback, const float* input) noexcept
+    {
+        constexpr int lanes = (int)Vec::SIMDNumElements;
+        jassert(numLanes % lanes == 0);
+
+        for (int i = 0; i < numRows; ++i)
+        {
+            float* row = tile + i * rowStride;
+
+            const auto damp = Vec::expand(damping[i]);
+            const auto pass = Vec::expand(1.0f - damping[i]);
+            const float feedbck = feedback[i];
+            const float in = input[i];
+
+            for (int k = 0; k < numLanes; k += lanes)
+            {
+                const auto y = Vec::fromRawArray(row + k);
+
+                auto state = y * pass + Vec::fromRawArray(last + k) * damp;
+                undenormalise(state);
+                state.copyToRawArray(last + k);
+
+                auto temp = state * feedbck + in;
+                undenormalise(temp);
+                temp.copyToRawArray(row + k);
+            }
+        }
+    }
+
+    void multiplyAccumulate(const float* x, const float* h, float* acc, int partitionSize) noexcept
+    {
+        const float* xr = x;
+        const float* xi = x + partitionSize;
+        const float* hr = h;
+        const float* hi = h + partitionSize;
+        float* ar = acc;
+        float* ai = acc + partitionSize;
+
+        // Bin 0 holds the real DC and Nyquist values
+        ar[0] += xr[0] * hr[0];
+        ai[0] += xi[0] * hi[0];
+
+        for (int k = 1; k < partitionSize; ++k)
+        {
+            ar[k] += xr[k] * hr[k] - xi[k] * hi[k];
+            ai[k] += xr[k] * hi[k] + xi[k] * hr[k];
+        }
+    }
+
+    void decimate(const float* even, const float* odd, const float* coefficients, int numCoefficients,
+                  int numOutputs, float* output) noexcept
+    {
+        for (int j = 0; j < numOutputs; ++j)
+        {
+            float sum = 0.5f * even[j];
+
+            for (int m = 1; m <= numCoefficients; ++m)
+                sum += coefficients[m - 1] * (odd[j - m] + odd[j - 1 + m]);
+
+            output[j] = sum;
+        }
+    }
+
+    void interpolate(const float* history, const float* coefficients, int numCoefficients,
+                     int numInputs, float* output) noexcept
+    {
+        for (int j = 0; j < numInputs; ++j)
+        {
+            float sum = 0.0f;
+
+            for (int m = 1; m <= numCoefficients; ++m)
+                sum += coefficients[m - 1] * (history[j - 1 + m] + history[j - m]);
+
+            output[2 * j] = 2.0f * sum;
+            output[2 * j + 1] = history[j];
+        }
+    }
+
+    // The vector kernels' arithmetic for one lane of a block step: row lane
+    // of a * s + b * x, summed pairwise
+    inline float blockStep(const float* a, const float* b, const float* s, const float* x, int lane) noexcept
+    {
+        return ((a[lane] * s[0] + a[4 + lane] * s[1]) + (a[8 + lane] * s[2] + a[12 + lane] * s[3]))
+             + ((b[lane] * x[0] + b[4 + lane] * x[1]) + (b[8 + lane] * x[2] + b[12 + lane] * x[3]));
+    }
+
+    inline float filterSample(const DspKernels::BlockFilter& filter, float* s, float x) noexcept
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            const float* c = filter.sections[i];
+            const float y = c[0] * x + s[2 * i];
+
+            s[2 * i] = (c[1] * x - c[3] * y) + s[2 * i + 1];
+            s[2 * i + 1] = c[2] * x - c[4] * y;
+            x = y;
+        }
+
+        return x;
+    }
+
+    // Scalar, but lane for lane the same arithmetic as the vector kernels,
+    // so the results match them exactly
+    void analyseChannel(const float* input, int numSamples, const DspKernels::BlockFilter& filter,
+                        float* state, float* results) noexcept
+    {
+        float s[4], sumSquares[4] {}, peak[4] {}, weighted[4] {};
+        std::copy(state, state + 4, s);
+
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const float* x = input + i;
+            float y[4], next[4];
+
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                sumSquares[lane] += x[lane] * x[lane];
+                peak[lane] = juce::jmax(peak[lane], std::abs(x[lane]));
+
+                y[lane] = blockStep(filter.output, filter.feedthrough, s, x, lane);
+                next[lane] = blockStep(filter.transition, filter.input, s, x, lane);
+                weighted[lane] += y[lane] * y[lane];
+            }
+
+            std::copy(next, next + 4, s);
+        }
+
+        float sum = (sumSquares[0] + sumSquares[1]) + (sumSquares[2] + sumSquares[3]);
+        float max = juce::jmax(juce::jmax(peak[0], peak[1]), juce::jmax(peak[2], peak[3]));
+        float weightedSum = (weighted[0] + weighted[1]) + (weighted[2] + weighted[3]);
+
+        for (; i < numSamples; ++i)
+        {
+            const float x = input[i];
+            sum += x * x;
+            max = juce::jmax(max, std::abs(x));
+
+            const float y = filterSample(filter, s, x);
+            weightedSum += y * y;
+        }
+
+        std::copy(s, s + 4, state);
+        results[0] = sum;
+        results[1] = max;
+        results[2] = weightedSum;
+    }
+
+    void analyse(const float* const* channels, int numChannels, int numSamples,
+                 const DspKernels::BlockFilter& filter, float* state, float* results) noexcept
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            analyseChannel(channels[ch], numSamples, filter, state + 4 * ch, results + 3 * ch);
+    }
+
+    // Four partial sums, as one 128-bit register holds them, then pairwise
+    inline float sumLines(const float* values) noexcept
+    {
+        constexpr int numLines = DspKernels::FdnTank::numLines;
+        float sums[4] {};
+
+        for (int k = 0; k < numLines; k += 4)
+            for (int lane = 0; lane < 4; ++lane)
+                sums[lane] += values[k + lane];
+
+        return (sums[0] + sums[2]) + (sums[1] + sums[3]);
+    }
+
+    void fdnSteps(DspKernels::FdnTank& tank, const float* inL, const float* inR,
+                  float* outL, float* outR, int numSamples) noexcept
+    {
+        constexpr int numLines = DspKernels::FdnTank::numLines;
+        constexpr int lanes = (int)Vec::SIMDNumElements;
+        static_assert(numLines % lanes == 0, "The lines must fill whole registers");
+
+        const auto damping = Vec::expand(tank.damping);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            alignas(32) float taps[numLines], scaled[numLines], productsL[numLines], productsR[numLines];
+
+            for (int j = 0; j < numLines; ++j)
+                taps[j] = tank.lines[j][(tank.writePos - tank.delays[j]) & tank.masks[j]];
+
+            // DECAY changes glide over the ramp instead of jumping
+            if (tank.lineGainRampRemaining > 0)
+            {
+                const bool last = --tank.lineGainRampRemaining == 0;
+
+                for (int j = 0; j < numLines; ++j)
+                    tank.lineGain[j] = last ? tank.lineGainTarget[j] : tank.lineGain[j] + tank.lineGainStep[j];
+            }
+
+            for (int k = 0; k < numLines; k += lanes)
+            {
+                const auto y = Vec::fromRawArray(taps + k);
+
+                (y * Vec::fromRawArray(tank.tapL + k)).copyToRawArray(productsL + k);
+                (y * Vec::fromRawArray(tank.tapR + k)).copyToRawArray(productsR + k);
+
+                const auto lowpass = y + (Vec::fromRawArray(tank.lowpass + k) - y) * damping;
+                lowpass.copyToRawArray(tank.lowpass + k);
+                (lowpass * Vec::fromRawArray(tank.lineGain + k)).copyToRawArray(scaled + k);
+            }
+
+            // Householder reflection: A = I - (2/N) * 1 * 1^T
+            const float reflection = sumLines(scaled) * (2.0f / (float)numLines);
+
+            for (int k = 0; k < numLines; k += lanes)
+            {
+                const auto feedback = Vec::fromRawArray(scaled + k) - reflection
+                                    + Vec::fromRawArray(tank.injectL + k) * inL[i]
+                                    + Vec::fromRawArray(tank.injectR + k) * inR[i];
+                feedback.copyToRawArray(taps + k);
+            }
+
+            for (int j = 0; j < numLines; ++j)
+                tank.lines[j][tank.writePos & tank.masks[j]] = taps[j];
+
+            tank.writePos = (tank.writePos + 1) & tank.masks[numLines - 1];
+
+            outL[i] = sumLines(productsL);
+            outR[i] = sumLines(productsR);
+        }
+    }
+
+    const DspKernels::Table baselineTable { combSteps, multiplyAccumulate, decimate, interpolate, analyse, fdnSteps };
+
+    //==============================================================================
+    constexpr int unchosen = -1;
+    std::atomic<int> activeIsa { unchosen };
+
+    const DspKernels::Table* findTable(DspKernels::Isa isa) noexcept
+    {
+        switch (isa)
+        {
+            case DspKernels::Isa::avx2:     return DspKernels::getAvx2Table();
+            case DspKernels::Isa::avx512:   return DspKernels::getAvx512Table();
+            case DspKernels::Isa::baseline: break;
+        }
+
+        return &baselineTable;
+    }
+
+    bool cpuSupports(DspKernels::Isa isa) noexcept
+    {
+        switch (isa)
+        {
+            case DspKernels::Isa::avx2:     return juce::SystemStats::hasAVX2();
+            case DspKernels::Isa::avx512:   return juce::SystemStats::hasAVX512F() && juce::SystemStats::hasAVX2();
+            case DspKernels::Isa::baseline: break;
+        }
+
+        return true;
+    }
+
+    bool findIsa(const char* name, DspKernels::Isa& isa) noexcept
+    {
+        for (auto candidate : { DspKernels::Isa::baseline, DspKernels::Isa::avx2, DspKernels::Isa::avx512 })
+        {
+            if (std::strcmp(name, DspKernels::getName(candidate)) == 0)
+            {
+                isa = candidate;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    DspKernels::Isa chooseIsa() noexcept
+    {
+        // An override that names an unknown or unavailable set falls back to
+        // the automatic choice rather than failing
+        auto isa = DspKernels::Isa::baseline;
+
+        if (const char* forced = std::getenv("LUSION_ISA"))
+            if (findIsa(forced, isa) && DspKernels::isAvailable(isa))
+                return isa;
+
+        for (auto candidate : { DspKernels::Isa::avx512, DspKernels::Isa::avx2 })
+            if (DspKernels::isAvailable(candidate))
+                return candidate;
+
+        return DspKernels::Isa::baseline;
+    }
+}
+
+//==============================================================================
+void DspKernels::initialise() noexcept
+{
+    if (activeIsa.load(std::memory_order_acquire) == unchosen)
+    {
+        auto expected = unchosen;
+        activeIsa.compare_exchange_strong(expected, (int)chooseIsa(), std::memory_order_acq_rel);
+    }
+}
+
+const DspKernels::Table& DspKernels::get() noexcept
+{
+    return *findTable(getActiveIsa());
+}
+
+DspKernels::Isa DspKernels::getActiveIsa() noexcept
+{
+    initialise();
+    return (Isa)activeIsa.load(std::memory_order_acquire);
+}
+
+const char* DspKernels::getName(Isa isa) noexcept
+{
+    switch (isa)
+    {
+        case Isa::avx2:     return "avx2";
+        case Isa::avx512:   return "avx512";
+        case Isa::baseline: break;
+    }
+
+   #if JUCE_INTEL
+    return "sse2";
+   #elif JUCE_ARM
+    return "neon";
+   #else
+    return "scalar";
+   #endif
+}
+
+bool DspKernels::isAvailable(Isa isa) noexcept
+{
+    return findTable(isa) != nullptr && cpuSupports(isa);
+}
+
+bool DspKernels::setActiveIsa(Isa isa) noexcept
+{
+    if (!isAvailable(isa))
+        return false;
+
+    activeIsa.store((int)isa, std::memory_order_release);
+    return true;
+}
+
+bool DspKernels::setActiveIsa(const char* name) noexcept
+{
+    Isa isa;
+    return findIsa(name, isa) && setActiveIsa(isa);
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+//==============================================================================
+// The innermost float loops of the tanks, the convolver, the eco resamplers
+// and the input analysis, compiled once per instruction set and chosen at
+// runtime.
+//
+// The baseline kernels are built like the rest of the plugin (SSE2 on x86-64,
+// NEON on ARM). DspKernelsAvx2.cpp and DspKernelsAvx512.cpp are built with
+// their own compiler flags, and their kernels only run on a CPU that reports
+// the instruction set. Every variant does the same arithmetic in the same
+// order, with no fused multiply-adds, so the output is bit-identical
+// whichever one runs: a render farm with mixed CPU generations writes the
+// same files on every node, and switching variants while audio is running
+// is inaudible.
+//
+// The choice is the widest instruction set available, unless the LUSION_ISA
+// environment variable names another one (see getName()).
+//
+// The per-ISA files include this header, so it must stay free of JUCE: inline
+// code compiled there would use the wider instructions, and the linker might
+// keep that copy for the whole binary.
+//==============================================================================
+namespace DspKernels
+{
+    enum class Isa { baseline, avx2, avx512 };
+
+    // A cascade of two biquads (transposed direct form II) in block form, for
+    // four samples per step: with s the sections' four states and x the next
+    // four inputs, the outputs are output * s + feedthrough * x and the new
+    // states transition * s + input * x. The 4x4 matrices are column-major.
+    // The sections' own coefficients (b0, b1, b2, a1, a2) run whatever is
+    // left over one sample at a time.
+    struct BlockFilter
+    {
+        float output[16], feedthrough[16], transition[16], input[16];
+        float sections[2][5];
+    };
+
+    // FdnReverb's network. Line i is read delays[i] samples behind writePos
+    // and written at writePos, both wrapped by masks[i]; the longest line has
+    // the largest mask, and writePos wraps by that. The per-line arrays are
+    // aligned for the baseline kernel's SIMD loads.
+    struct FdnTank
+    {
+        static constexpr int numLines = 8;
+
+        float* lines[numLines];
+        int delays[numLines], masks[numLines];
+        int writePos;
+
+        alignas(32) float lowpass[numLines];
+        alignas(32) float lineGain[numLines];
+        alignas(32) float lineGainTarget[numLines];
+        alignas(32) float lineGainStep[numLines];
+        int lineGainRampRemaining;
+
+        alignas(32) float injectL[numLines];
+        alignas(32) float injectR[numLines];
+        alignas(32) float tapL[numLines];
+        alignas(32) float tapR[numLines];
+        float damping;
+    };
+
+    struct Table
+    {
+        // Runs numRows samples through a bank of one-pole-damped combs, one
+        // per lane. Each row of tile holds the lanes' delayed samples for one
+        // sample and is overwritten with what the combs write back; last holds
+        // each lane's damping filter state. damping, feedback and input hold
+        // one value per row, shared by all lanes. numLanes is a multiple of 4.
+        void (*combSteps)(float* tile, int rowStride, int numRows, int numLanes, float* last,
+                          const float* damping, const float* feedback, const float* input) noexcept;
+
+        // acc += x * h over PartitionedConvolver's split spectra: partitionSize
+        // real parts, then as many imaginary parts, with the real DC and
+        // Nyquist values sharing bin 0
+        void (*multiplyAccumulate)(const float* x, const float* h, float* acc, int partitionSize) noexcept;
+
+        // The half-band filter's polyphase branches (see HalfBandFilter).
+        // even and odd point at the centre tap of the first output, history
+        // at the input the first output pair is centred on.
+        void (*decimate)(const float* even, const float* odd, const float* coefficients, int numCoefficients,
+                         int numOutputs, float* output) noexcept;
+
+        void (*interpolate)(const float* history, const float* coefficients, int numCoefficients,
+                            int numInputs, float* output) noexcept;
+
+        // One pass over each channel: results gets the sum of squares, the
+        // peak magnitude and the sum of squares after the filter, three
+        // floats per channel. state holds the filter's four states per
+        // channel, carried from block to block.
+        void (*analyse)(const float* const* channels, int numChannels, int numSamples,
+                        const BlockFilter& filter, float* state, float* results) noexcept;
+
+        // Runs numSamples through the network: each step reads the taps, ramps
+        // the line gains if a ramp is left, damps and scales the taps, mixes
+        // them through a Householder reflection and writes them back with the
+        // inputs injected. outL and outR get the output taps, read before the
+        // write. Lane sums are taken four lanes at a time, then pairwise.
+        void (*fdnSteps)(FdnTank& tank, const float* inL, const float* inR,
+                         float* outL, float* outR, int numSamples) noexcept;
+    };
+
+    // Chooses the instruction set if that hasn't happened yet. Call it off the
+    // audio thread: the CPU check can read system files.
+    void initialise() noexcept;
+
+    // The kernels in use. Cheap enough to fetch once per block.
+    const Table& get() noexcept;
+
+    Isa getActiveIsa() noexcept;
+
+    // "sse2" (or "neon" on ARM), "avx2" or "avx512"
+    const char* getName(Isa isa) noexcept;
+
+    // True if this build has the instruction set's kernels and the CPU can run them
+    bool isAvailable(Isa isa) noexcept;
+
+    // Forces an instruction set, for tests and the tools' --isa option.
+    // Returns false, and changes nothing, if it isn't available.
+    bool setActiveIsa(Isa isa) noexcept;
+    bool setActiveIsa(const char* name) noexcept;
+
+    // Defined by the per-ISA files; null when one was built without its
+    // instruction set (a non-x86 target, or missing compiler flags)
+    const Table* getAvx2Table() noexcept;
+    const Table* getAvx512Table() noexcept;
+}
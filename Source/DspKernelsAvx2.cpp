@@ -0,0 +1,22 @@
+// Built with AVX2 enabled (-mavx2, /arch:AVX2); see DspKernels.h.
+// Nothing from JUCE may be included here.
+#include "DspKernels.h"
+
+#if defined(__AVX2__)
+ #include "DspKernelsSimd.h"
+
+namespace
+{
+    constexpr auto avx2Table = makeTable<Avx, Sse>();
+}
+
+const DspKernels::Table* DspKernels::getAvx2Table() noexcept
+{
+    return &avx2Table;
+}
+#else
+const DspKernels::Table* DspKernels::getAvx2Table() noexcept
+{
+    return nullptr;
+}
+#endif
@@ -0,0 +1,22 @@
+// Built with AVX-512 enabled (-mavx512f, /arch:AVX512); see DspKernels.h.
+// Nothing from JUCE may be included here.
+#include "DspKernels.h"
+
+#if defined(__AVX512F__) && defined(__AVX2__)
+ #include "DspKernelsSimd.h"
+
+namespace
+{
+    constexpr auto avx512Table = makeTable<Avx512, Avx, Sse>();
+}
+
+const DspKernels::Table* DspKernels::getAvx512Table() noexcept
+{
+    return &avx512Table;
+}
+#else
+const DspKernels::Table* DspKernels::getAvx512Table() noexcept
+{
+    return nullptr;
+}
+#endif
@@ -0,0 +1,498 @@
+#pragma once
+#include <immintrin.h>
+#include "DspKernels.h"
+
+//==============================================================================
+// The x86 kernels, written once over register widths. Each per-ISA file
+// includes this and instantiates them with the widths its instruction set
+// has, widest first: every loop covers what it can with the widest register
+// and leaves the rest to the narrower ones, then to scalar code.
+//
+// Everything here has internal linkage, so each file keeps its own copies,
+// compiled with its own flags. Results are per lane and in the baseline
+// kernels' order of operations (see DspKernels.cpp), hence bit-identical.
+//==============================================================================
+namespace
+{
+    struct Sse
+    {
+        using V = __m128;
+        static constexpr int width = 4;
+
+        static V load(const float* p) noexcept           { return _mm_loadu_ps(p); }
+        static void store(float* p, V v) noexcept        { _mm_storeu_ps(p, v); }
+        static V expand(float x) noexcept                { return _mm_set1_ps(x); }
+        static V add(V a, V b) noexcept                  { return _mm_add_ps(a, b); }
+        static V sub(V a, V b) noexcept                  { return _mm_sub_ps(a, b); }
+        static V mul(V a, V b) noexcept                  { return _mm_mul_ps(a, b); }
+        static V max(V a, V b) noexcept                  { return _mm_max_ps(a, b); }
+        static V abs(V a) noexcept                       { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+
+        // [a0 b0 a1 b1 ...]
+        static void storeInterleaved(float* p, V a, V b) noexcept
+        {
+            _mm_storeu_ps(p, _mm_unpacklo_ps(a, b));
+            _mm_storeu_ps(p + 4, _mm_unpackhi_ps(a, b));
+        }
+
+        // Four floats from each of width / 4 sources, one per 128-bit lane
+        static V loadQuads(const float* const* sources, int offset) noexcept
+        {
+            return _mm_loadu_ps(sources[0] + offset);
+        }
+
+        // Four floats repeated in every 128-bit lane
+        static V repeatQuad(const float* p) noexcept     { return _mm_loadu_ps(p); }
+
+        // Element i of each 128-bit lane, across that lane
+        template <int i>
+        static V spread(V a) noexcept                    { return _mm_shuffle_ps(a, a, i * 0x55); }
+    };
+
+   #if defined(__AVX2__)
+    struct Avx
+    {
+        using V = __m256;
+        static constexpr int width = 8;
+
+        static V load(const float* p) noexcept           { return _mm256_loadu_ps(p); }
+        static void store(float* p, V v) noexcept        { _mm256_storeu_ps(p, v); }
+        static V expand(float x) noexcept                { return _mm256_set1_ps(x); }
+        static V add(V a, V b) noexcept                  { return _mm256_add_ps(a, b); }
+        static V sub(V a, V b) noexcept                  { return _mm256_sub_ps(a, b); }
+        static V mul(V a, V b) noexcept                  { return _mm256_mul_ps(a, b); }
+        static V max(V a, V b) noexcept                  { return _mm256_max_ps(a, b); }
+        static V abs(V a) noexcept                       { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+
+        static void storeInterleaved(float* p, V a, V b) noexcept
+        {
+            // The unpacks work within 128-bit halves
+            const auto lo = _mm256_unpacklo_ps(a, b);
+            const auto hi = _mm256_unpackhi_ps(a, b);
+            _mm256_storeu_ps(p, _mm256_permute2f128_ps(lo, hi, 0x20));
+            _mm256_storeu_ps(p + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+        }
+
+        static V loadQuads(const float* const* sources, int offset) noexcept
+        {
+            return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(sources[0] + offset)),
+                                        _mm_loadu_ps(sources[1] + offset), 1);
+        }
+
+        static V repeatQuad(const float* p) noexcept     { return _mm256_broadcast_ps(reinterpret_cast<const __m128*>(p)); }
+
+        template <int i>
+        static V spread(V a) noexcept                    { return _mm256_permute_ps(a, i * 0x55); }
+    };
+   #endif
+
+   #if defined(__AVX512F__)
+    struct Avx512
+    {
+        using V = __m512;
+        static constexpr int width = 16;
+
+        static V load(const float* p) noexcept           { return _mm512_loadu_ps(p); }
+        static void store(float* p, V v) noexcept        { _mm512_storeu_ps(p, v); }
+        static V expand(float x) noexcept                { return _mm512_set1_ps(x); }
+        static V add(V a, V b) noexcept                  { return _mm512_add_ps(a, b); }
+        static V sub(V a, V b) noexcept                  { return _mm512_sub_ps(a, b); }
+        static V mul(V a, V b) noexcept                  { return _mm512_mul_ps(a, b); }
+        static V max(V a, V b) noexcept                  { return _mm512_max_ps(a, b); }
+        static V abs(V a) noexcept                       { return _mm512_abs_ps(a); }
+
+        static void storeInterleaved(float* p, V a, V b) noexcept
+        {
+            // Indices 16 and up pick from b
+            const auto first = _mm512_set_epi32(23, 7, 22, 6, 21, 5, 20, 4, 19, 3, 18, 2, 17, 1, 16, 0);
+            const auto second = _mm512_set_epi32(31, 15, 30, 14, 29, 13, 28, 12, 27, 11, 26, 10, 25, 9, 24, 8);
+            _mm512_storeu_ps(p, _mm512_permutex2var_ps(a, first, b));
+            _mm512_storeu_ps(p + 16, _mm512_permutex2var_ps(a, second, b));
+        }
+
+        static V loadQuads(const float* const* sources, int offset) noexcept
+        {
+            auto v = _mm512_castps128_ps512(_mm_loadu_ps(sources[0] + offset));
+            v = _mm512_insertf32x4(v, _mm_loadu_ps(sources[1] + offset), 1);
+            v = _mm512_insertf32x4(v, _mm_loadu_ps(sources[2] + offset), 2);
+            return _mm512_insertf32x4(v, _mm_loadu_ps(sources[3] + offset), 3);
+        }
+
+        static V repeatQuad(const float* p) noexcept     { return _mm512_broadcast_f32x4(_mm_loadu_ps(p)); }
+
+        template <int i>
+        static V spread(V a) noexcept                    { return _mm512_permute_ps(a, i * 0x55); }
+    };
+   #endif
+
+    // x += 0.1f; x -= 0.1f, as the tanks do
+    template <typename R>
+    inline typename R::V undenormalise(typename R::V x) noexcept
+    {
+        const auto offset = R::expand(0.1f);
+        return R::sub(R::add(x, offset), offset);
+    }
+
+    //==============================================================================
+    // Each step takes lanes (or bins, or outputs) from k on while a whole
+    // register fits and returns where it stopped
+    template <typename R>
+    inline int combLanes(float* row, float* last, int k, int numLanes,
+                         float damping, float feedback, float input) noexcept
+    {
+        const auto damp = R::expand(damping);
+        const auto pass = R::expand(1.0f - damping);
+        const auto feedbck = R::expand(feedback);
+        const auto in = R::expand(input);
+
+        for (; k + R::width <= numLanes; k += R::width)
+        {
+            const auto y = R::load(row + k);
+
+            const auto state = undenormalise<R>(R::add(R::mul(y, pass), R::mul(R::load(last + k), damp)));
+            R::store(last + k, state);
+
+            R::store(row + k, undenormalise<R>(R::add(R::mul(state, feedbck), in)));
+        }
+
+        return k;
+    }
+
+    template <typename... Registers>
+    void combSteps(float* tile, int rowStride, int numRows, int numLanes, float* last,
+                   const float* damping, const float* feedback, const float* input) noexcept
+    {
+        for (int i = 0; i < numRows; ++i)
+        {
+            float* row = tile + i * rowStride;
+            int k = 0;
+
+            ((k = combLanes<Registers>(row, last, k, numLanes, damping[i], feedback[i], input[i])), ...);
+        }
+    }
+
+    template <typename R>
+    inline int multiplyBins(const float* xr, const float* xi, const float* hr, const float* hi,
+                            float* ar, float* ai, int k, int numBins) noexcept
+    {
+        for (; k + R::width <= numBins; k += R::width)
+        {
+            const auto a = R::load(xr + k), b = R::load(xi + k);
+            const auto c = R::load(hr + k), d = R::load(hi + k);
+
+            R::store(ar + k, R::add(R::load(ar + k), R::sub(R::mul(a, c), R::mul(b, d))));
+            R::store(ai + k, R::add(R::load(ai + k), R::add(R::mul(a, d), R::mul(b, c))));
+        }
+
+        return k;
+    }
+
+    template <typename... Registers>
+    void multiplyAccumulate(const float* x, const float* h, float* acc, int partitionSize) noexcept
+    {
+        const float* xr = x;
+        const float* xi = x + partitionSize;
+        const float* hr = h;
+        const float* hi = h + partitionSize;
+        float* ar = acc;
+        float* ai = acc + partitionSize;
+
+        ar[0] += xr[0] * hr[0];
+        ai[0] += xi[0] * hi[0];
+
+        int k = 1;
+        ((k = multiplyBins<Registers>(xr, xi, hr, hi, ar, ai, k, partitionSize)), ...);
+
+        for (; k < partitionSize; ++k)
+        {
+            ar[k] += xr[k] * hr[k] - xi[k] * hi[k];
+            ai[k] += xr[k] * hi[k] + xi[k] * hr[k];
+        }
+    }
+
+    template <typename R>
+    inline int decimateOutputs(const float* even, const float* odd, const float* coefficients, int numCoefficients,
+                               int j, int numOutputs, float* output) noexcept
+    {
+        for (; j + R::width <= numOutputs; j += R::width)
+        {
+            auto sum = R::mul(R::expand(0.5f), R::load(even + j));
+
+            for (int m = 1; m <= numCoefficients; ++m)
+                sum = R::add(sum, R::mul(R::expand(coefficients[m - 1]),
+                                         R::add(R::load(odd + j - m), R::load(odd + j - 1 + m))));
+
+            R::store(output + j, sum);
+        }
+
+        return j;
+    }
+
+    template <typename... Registers>
+    void decimate(const float* even, const float* odd, const float* coefficients, int numCoefficients,
+                  int numOutputs, float* output) noexcept
+    {
+        int j = 0;
+        ((j = decimateOutputs<Registers>(even, odd, coefficients, numCoefficients, j, numOutputs, output)), ...);
+
+        for (; j < numOutputs; ++j)
+        {
+            float sum = 0.5f * even[j];
+
+            for (int m = 1; m <= numCoefficients; ++m)
+                sum += coefficients[m - 1] * (odd[j - m] + odd[j - 1 + m]);
+
+            output[j] = sum;
+        }
+    }
+
+    template <typename R>
+    inline int interpolateInputs(const float* history, const float* coefficients, int numCoefficients,
+                                 int j, int numInputs, float* output) noexcept
+    {
+        for (; j + R::width <= numInputs; j += R::width)
+        {
+            auto sum = R::expand(0.0f);
+
+            for (int m = 1; m <= numCoefficients; ++m)
+                sum = R::add(sum, R::mul(R::expand(coefficients[m - 1]),
+                                         R::add(R::load(history + j - 1 + m), R::load(history + j - m))));
+
+            R::storeInterleaved(output + 2 * j, R::mul(R::expand(2.0f), sum), R::load(history + j));
+        }
+
+        return j;
+    }
+
+    template <typename... Registers>
+    void interpolate(const float* history, const float* coefficients, int numCoefficients,
+                     int numInputs, float* output) noexcept
+    {
+        int j = 0;
+        ((j = interpolateInputs<Registers>(history, coefficients, numCoefficients, j, numInputs, output)), ...);
+
+        for (; j < numInputs; ++j)
+        {
+            float sum = 0.0f;
+
+            for (int m = 1; m <= numCoefficients; ++m)
+                sum += coefficients[m - 1] * (history[j - 1 + m] + history[j - m]);
+
+            output[2 * j] = 2.0f * sum;
+            output[2 * j + 1] = history[j];
+        }
+    }
+
+    // One lane of the block step of analyse: row lane of a * s + b * x, with
+    // the columns of a and b already repeated across every 128-bit lane
+    template <typename R>
+    inline typename R::V blockStep(const typename R::V* a, const typename R::V* b,
+                                   typename R::V s, typename R::V x) noexcept
+    {
+        return R::add(R::add(R::add(R::mul(a[0], R::template spread<0>(s)), R::mul(a[1], R::template spread<1>(s))),
+                             R::add(R::mul(a[2], R::template spread<2>(s)), R::mul(a[3], R::template spread<3>(s)))),
+                      R::add(R::add(R::mul(b[0], R::template spread<0>(x)), R::mul(b[1], R::template spread<1>(x))),
+                             R::add(R::mul(b[2], R::template spread<2>(x)), R::mul(b[3], R::template spread<3>(x)))));
+    }
+
+    // Not std::max or std::abs: a copy compiled here could be the one the
+    // linker keeps (see DspKernels.h)
+    inline float maxOf(float a, float b) noexcept     { return a < b ? b : a; }
+    inline float magnitude(float x) noexcept          { return x < 0.0f ? -x : x; }
+
+    inline float filterSample(const DspKernels::BlockFilter& filter, float* s, float x) noexcept
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            const float* c = filter.sections[i];
+            const float y = c[0] * x + s[2 * i];
+
+            s[2 * i] = (c[1] * x - c[3] * y) + s[2 * i + 1];
+            s[2 * i + 1] = c[2] * x - c[4] * y;
+            x = y;
+        }
+
+        return x;
+    }
+
+    // Each 128-bit lane runs one channel, four samples per step
+    template <typename R>
+    inline int analyseChannels(const float* const* channels, int ch, int numChannels, int numSamples,
+                               const DspKernels::BlockFilter& filter, float* state, float* results) noexcept
+    {
+        constexpr int channelsPerRegister = R::width / 4;
+        using V = typename R::V;
+
+        V output[4], feedthrough[4], transition[4], input[4];
+
+        for (int j = 0; j < 4; ++j)
+        {
+            output[j] = R::repeatQuad(filter.output + 4 * j);
+            feedthrough[j] = R::repeatQuad(filter.feedthrough + 4 * j);
+            transition[j] = R::repeatQuad(filter.transition + 4 * j);
+            input[j] = R::repeatQuad(filter.input + 4 * j);
+        }
+
+        for (; ch + channelsPerRegister <= numChannels; ch += channelsPerRegister)
+        {
+            const float* const* sources = channels + ch;
+            float* s = state + 4 * ch;
+
+            auto states = R::load(s);
+            auto sumSquares = R::expand(0.0f), peak = R::expand(0.0f), weighted = R::expand(0.0f);
+
+            int i = 0;
+
+            for (; i + 4 <= numSamples; i += 4)
+            {
+                const auto x = R::loadQuads(sources, i);
+
+                sumSquares = R::add(sumSquares, R::mul(x, x));
+                peak = R::max(peak, R::abs(x));
+
+                const auto y = blockStep<R>(output, feedthrough, states, x);
+                states = blockStep<R>(transition, input, states, x);
+                weighted = R::add(weighted, R::mul(y, y));
+            }
+
+            R::store(s, states);
+
+            float sums[R::width], peaks[R::width], weightedSums[R::width];
+            R::store(sums, sumSquares);
+            R::store(peaks, peak);
+            R::store(weightedSums, weighted);
+
+            for (int c = 0; c < channelsPerRegister; ++c)
+            {
+                const float* a = sums + 4 * c;
+                const float* p = peaks + 4 * c;
+                const float* w = weightedSums + 4 * c;
+
+                float sum = (a[0] + a[1]) + (a[2] + a[3]);
+                float max = maxOf(maxOf(p[0], p[1]), maxOf(p[2], p[3]));
+                float weightedSum = (w[0] + w[1]) + (w[2] + w[3]);
+
+                for (int j = i; j < numSamples; ++j)
+                {
+                    const float x = sources[c][j];
+                    sum += x * x;
+                    max = maxOf(max, magnitude(x));
+
+                    const float y = filterSample(filter, s + 4 * c, x);
+                    weightedSum += y * y;
+                }
+
+                float* r = results + 3 * (ch + c);
+                r[0] = sum;
+                r[1] = max;
+                r[2] = weightedSum;
+            }
+        }
+
+        return ch;
+    }
+
+    template <typename... Registers>
+    void analyse(const float* const* channels, int numChannels, int numSamples,
+                 const DspKernels::BlockFilter& filter, float* state, float* results) noexcept
+    {
+        int ch = 0;
+        ((ch = analyseChannels<Registers>(channels, ch, numChannels, numSamples, filter, state, results)), ...);
+    }
+
+    constexpr int numFdnLines = DspKernels::FdnTank::numLines;
+    static_assert(numFdnLines % Sse::width == 0, "The narrowest register must finish the lines");
+
+    // The taps' output products, damping and line gains
+    template <typename R>
+    inline int fdnLanes(DspKernels::FdnTank& tank, const float* taps, float* productsL, float* productsR,
+                        float* scaled, int k) noexcept
+    {
+        const auto damping = R::expand(tank.damping);
+
+        for (; k + R::width <= numFdnLines; k += R::width)
+        {
+            const auto y = R::load(taps + k);
+
+            R::store(productsL + k, R::mul(y, R::load(tank.tapL + k)));
+            R::store(productsR + k, R::mul(y, R::load(tank.tapR + k)));
+
+            const auto lowpass = R::add(y, R::mul(R::sub(R::load(tank.lowpass + k), y), damping));
+            R::store(tank.lowpass + k, lowpass);
+            R::store(scaled + k, R::mul(lowpass, R::load(tank.lineGain + k)));
+        }
+
+        return k;
+    }
+
+    template <typename R>
+    inline int fdnFeedback(const DspKernels::FdnTank& tank, const float* scaled, float reflection,
+                           float inL, float inR, float* feedback, int k) noexcept
+    {
+        for (; k + R::width <= numFdnLines; k += R::width)
+        {
+            const auto mixed = R::sub(R::load(scaled + k), R::expand(reflection));
+            const auto injected = R::add(mixed, R::mul(R::load(tank.injectL + k), R::expand(inL)));
+            R::store(feedback + k, R::add(injected, R::mul(R::load(tank.injectR + k), R::expand(inR))));
+        }
+
+        return k;
+    }
+
+    // Four partial sums, as one 128-bit register holds them, then pairwise
+    inline float sumLines(const float* values) noexcept
+    {
+        float sums[4] {};
+
+        for (int k = 0; k < numFdnLines; k += 4)
+            for (int lane = 0; lane < 4; ++lane)
+                sums[lane] += values[k + lane];
+
+        return (sums[0] + sums[2]) + (sums[1] + sums[3]);
+    }
+
+    template <typename... Registers>
+    void fdnSteps(DspKernels::FdnTank& tank, const float* inL, const float* inR,
+                  float* outL, float* outR, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float taps[numFdnLines], scaled[numFdnLines], productsL[numFdnLines], productsR[numFdnLines];
+
+            for (int j = 0; j < numFdnLines; ++j)
+                taps[j] = tank.lines[j][(tank.writePos - tank.delays[j]) & tank.masks[j]];
+
+            if (tank.lineGainRampRemaining > 0)
+            {
+                const bool last = --tank.lineGainRampRemaining == 0;
+
+                for (int j = 0; j < numFdnLines; ++j)
+                    tank.lineGain[j] = last ? tank.lineGainTarget[j] : tank.lineGain[j] + tank.lineGainStep[j];
+            }
+
+            int k = 0;
+            ((k = fdnLanes<Registers>(tank, taps, productsL, productsR, scaled, k)), ...);
+
+            const float reflection = sumLines(scaled) * (2.0f / (float)numFdnLines);
+
+            k = 0;
+            ((k = fdnFeedback<Registers>(tank, scaled, reflection, inL[i], inR[i], taps, k)), ...);
+
+            for (int j = 0; j < numFdnLines; ++j)
+                tank.lines[j][tank.writePos & tank.masks[j]] = taps[j];
+
+            tank.writePos = (tank.writePos + 1) & tank.masks[numFdnLines - 1];
+
+            outL[i] = sumLines(productsL);
+            outR[i] = sumLines(productsR);
+        }
+    }
+
+    template <typename... Registers>
+    constexpr DspKernels::Table makeTable() noexcept
+    {
+        return { combSteps<Registers...>, multiplyAccumulate<Registers...>,
+                 decimate<Registers...>, interpolate<Registers...>, analyse<Registers...>,
+                 fdnSteps<Registers...> };
+    }
+}
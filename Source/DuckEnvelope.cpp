@@ -0,0 +1,114 @@
+#include "DuckEnvelope.h"
+
+namespace
+{
+    // Same curve the per-block ducker used: no ducking up to the threshold,
+    // then full ducking half a unit of level above it
+    constexpr float threshold = 0.08f;
+    constexpr float slope = 2.0f;
+    constexpr float maxDuck = 0.7f;
+
+    // RMS over mean absolute value for a sine, pi / (2 * sqrt(2)): the curve
+    // was tuned on block RMS
+    constexpr float formFactor = 1.1107207f;
+}
+
+//==============================================================================
+void DuckEnvelope::prepare(double newSampleRate, int maxBlockSize)
+{
+    sampleRate = newSampleRate;
+
+    const auto coefficient = [this](float seconds)
+        {
+            return 1.0f - std::exp(-1.0f / (seconds * (float)sampleRate));
+        };
+
+    attackCoeff = coefficient(attackSeconds);
+    releaseCoeff = coefficient(releaseSeconds);
+
+    capacity = juce::jmax(1, maxBlockSize);
+    gains.allocate((size_t)capacity, true);
+    scratch.allocate((size_t)capacity, true);
+
+    reset();
+}
+
+void DuckEnvelope::reset()
+{
+    envelope = 0.0f;
+    duckAmount = 0.0f;
+}
+
+//==============================================================================
+template <typename SampleType>
+const float* DuckEnvelope::process(const juce::AudioBuffer<SampleType>& input, int startSample, int numSamples) noexcept
+{
+    jassert(numSamples <= capacity);
+
+    using FVO = juce::FloatVectorOperations;
+
+    const int numChannels = input.getNumChannels();
+    float* level = gains.get();
+
+    if (numChannels == 0)
+    {
+        FVO::clear(level, numSamples);
+    }
+    else
+    {
+        SampleConversion::absToFloat(level, input.getReadPointer(0, startSample), numSamples);
+
+        for (int ch = 1; ch < numChannels; ++ch)
+        {
+            SampleConversion::absToFloat(scratch.get(), input.getReadPointer(ch, startSample), numSamples);
+            FVO::add(level, scratch.get(), numSamples);
+        }
+
+        FVO::multiply(level, formFactor / (float)numChannels, numSamples);
+    }
+
+    float env = envelope;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float x = level[i];
+        env += (x > env ? attackCoeff : releaseCoeff) * (x - env);
+        level[i] = env;
+    }
+
+    envelope = env;
+
+    // level -> duck amount (0..1) -> wet gain, in place
+    FVO::add(level, -threshold, numSamples);
+    FVO::multiply(level, slope, numSamples);
+    FVO::clip(level, level, 0.0f, 1.0f, numSamples);
+
+    if (numSamples > 0)
+        duckAmount = level[numSamples - 1];
+
+    FVO::multiply(level, -maxDuck, numSamples);
+    FVO::add(level, 1.0f, numSamples);
+
+    return level;
+}
+
+template const float* DuckEnvelope::process(const juce::AudioBuffer<float>&, int, int) noexcept;
+template const float* DuckEnvelope::process(const juce::AudioBuffer<double>&, int, int) noexcept;
+
+double DuckEnvelope::getSettleSeconds(float attenuationDb) const
+{
+    // The release is the slower of the two one-pole sections
+    return attenuationDb / 20.0 * std::log(10.0) * releaseSeconds;
+}
+
+//==============================================================================
+void DuckEnvelope::saveState(juce::OutputStream& out) const
+{
+    SnapshotIO::write(out, envelope);
+    SnapshotIO::write(out, duckAmount);
+}
+
+bool DuckEnvelope::restoreState(juce::InputStream& in)
+{
+    return SnapshotIO::read(in, envelope) && SnapshotIO::read(in, duckAmount);
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <JuceHeader.h>
+#include "SnapshotIO.h"
+#include "SampleConversion.h"
+
+//==============================================================================
+// Per-sample ducking of the wet signal.
+//
+// Follows the rectified input level (averaged over channels) with separate
+// attack and release times, and turns it into a wet gain for every sample:
+// unity below the threshold, down to 1 - maxDuck as the input gets louder.
+// The level is scaled so a sine reads its RMS, as with the block RMS this
+// replaced, so the threshold keeps its sensitivity.
+// The engine multiplies the gains into its wet mix, so the ducking sounds
+// the same at any host block size.
+//
+// Rectifying, channel averaging and the gain curve run as vector operations;
+// only the one-pole follower itself is a scalar loop.
+//==============================================================================
+class DuckEnvelope
+{
+public:
+    static constexpr float attackSeconds = 0.02f;
+    static constexpr float releaseSeconds = 0.25f;
+
+    void prepare(double sampleRate, int maxBlockSize);
+    void reset();
+
+    // Wet gains for up to maxBlockSize samples of float or double input from
+    // startSample. The returned buffer stays valid until the next call.
+    template <typename SampleType>
+    const float* process(const juce::AudioBuffer<SampleType>& input, int startSample, int numSamples) noexcept;
+
+    // 0 = no ducking, 1 = fully ducked, as of the last processed sample
+    float getDuckAmount() const noexcept { return duckAmount; }
+
+    // Time until a difference in the follower's starting state has shrunk
+    // by attenuationDb
+    double getSettleSeconds(float attenuationDb) const;
+
+    void saveState(juce::OutputStream& out) const;
+    bool restoreState(juce::InputStream& in);
+
+private:
+    double sampleRate = 44100.0;
+    float attackCoeff = 1.0f, releaseCoeff = 1.0f;
+
+    float envelope = 0.0f;
+    float duckAmount = 0.0f;
+
+    juce::HeapBlock<float> gains, scratch;
+    int capacity = 0;
+};
@@ -0,0 +1,276 @@
+#include "FdnReverb.h"
+
+namespace
+{
+    // Mutually prime-ish line lengths, spread over a medium hall
+    constexpr float delayMs[FdnReverb::numLines] =
+        { 21.53f, 27.67f, 31.79f, 35.61f, 40.63f, 45.91f, 51.59f, 56.93f };
+
+    // Orthogonal Hadamard rows used for input injection and output taps,
+    // so L and R excite and read back decorrelated mixtures of the lines
+    constexpr float injectLSigns[FdnReverb::numLines] = { 1, -1, -1,  1,  1, -1, -1,  1 };
+    constexpr float injectRSigns[FdnReverb::numLines] = { 1,  1,  1,  1, -1, -1, -1, -1 };
+    constexpr float tapLSigns[FdnReverb::numLines]    = { 1, -1,  1, -1,  1, -1,  1, -1 };
+    constexpr float tapRSigns[FdnReverb::numLines]    = { 1,  1, -1, -1,  1,  1, -1, -1 };
+
+    constexpr float inputGain  = 0.125f;
+    constexpr float outputGain = 0.6f;
+    constexpr float damping    = 0.25f;
+
+    // Same wet/dry law as juce::Reverb so both engines sit at the same level
+    constexpr float wetScaleFactor = 3.0f;
+    constexpr float dryScaleFactor = 2.0f;
+}
+
+//==============================================================================
+void FdnReverb::prepare(double newSampleRate, int)
+{
+    sampleRate = newSampleRate;
+
+    size_t totalSize = 0;
+    int sizes[numLines];
+
+    for (int i = 0; i < numLines; ++i)
+    {
+        tank.delays[i] = juce::jmax(1, juce::roundToInt(delayMs[i] * 0.001 * sampleRate));
+        sizes[i] = juce::nextPowerOfTwo(tank.delays[i] + 1);
+        tank.masks[i] = sizes[i] - 1;
+        totalSize += (size_t)sizes[i];
+    }
+
+    lineMemory.calloc(totalSize);
+    lineMemorySize = totalSize;
+
+    float* p = lineMemory.get();
+    for (int i = 0; i < numLines; ++i)
+    {
+        tank.lines[i] = p;
+        p += sizes[i];
+    }
+
+    for (int i = 0; i < numLines; ++i)
+    {
+        tank.injectL[i] = injectLSigns[i] * inputGain;
+        tank.injectR[i] = injectRSigns[i] * inputGain;
+        tank.tapL[i] = tapLSigns[i] * outputGain;
+        tank.tapR[i] = tapRSigns[i] * outputGain;
+    }
+
+    tank.damping = damping;
+
+    const double smoothTime = 0.01;
+    dryGain.reset(sampleRate, smoothTime);
+    wetGain1.reset(sampleRate, smoothTime);
+    wetGain2.reset(sampleRate, smoothTime);
+
+    rampLength = juce::jmax(1, juce::roundToInt(smoothTime * sampleRate));
+
+    updateLineGains(false);
+    updateMixGains();
+    reset();
+}
+
+void FdnReverb::reset()
+{
+    if (lineMemory != nullptr)
+        juce::FloatVectorOperations::clear(lineMemory.get(), (int)lineMemorySize);
+
+    tank.writePos = 0;
+    std::fill(std::begin(tank.lowpass), std::end(tank.lowpass), 0.0f);
+
+    dryGain.setCurrentAndTargetValue(dryGain.getTargetValue());
+    wetGain1.setCurrentAndTargetValue(wetGain1.getTargetValue());
+    wetGain2.setCurrentAndTargetValue(wetGain2.getTargetValue());
+}
+
+//==============================================================================
+void FdnReverb::saveState(juce::OutputStream& out, bool includeBuffers) const
+{
+    SnapshotIO::write(out, decaySeconds);
+    SnapshotIO::write(out, wetLevel);
+    SnapshotIO::write(out, width);
+    SnapshotIO::writeArray(out, tank.lineGain, numLines);
+    SnapshotIO::writeArray(out, tank.lineGainTarget, numLines);
+    SnapshotIO::writeArray(out, tank.lineGainStep, numLines);
+    SnapshotIO::write(out, tank.lineGainRampRemaining);
+
+    for (const auto* s : { &dryGain, &wetGain1, &wetGain2 })
+        SnapshotIO::write(out, *s);
+
+    SnapshotIO::write(out, includeBuffers);
+
+    if (!includeBuffers)
+        return;
+
+    SnapshotIO::write(out, lineMemorySize);
+    SnapshotIO::writeArray(out, lineMemory.get(), lineMemorySize);
+    SnapshotIO::write(out, tank.writePos);
+    SnapshotIO::writeArray(out, tank.lowpass, numLines);
+}
+
+bool FdnReverb::restoreState(juce::InputStream& in)
+{
+    if (!(SnapshotIO::read(in, decaySeconds) && SnapshotIO::read(in, wetLevel) && SnapshotIO::read(in, width)
+          && SnapshotIO::readArray(in, tank.lineGain, numLines)
+          && SnapshotIO::readArray(in, tank.lineGainTarget, numLines)
+          && SnapshotIO::readArray(in, tank.lineGainStep, numLines)
+          && SnapshotIO::read(in, tank.lineGainRampRemaining)
+          && tank.lineGainRampRemaining >= 0 && tank.lineGainRampRemaining <= rampLength))
+        return false;
+
+    for (auto* s : { &dryGain, &wetGain1, &wetGain2 })
+        if (!SnapshotIO::read(in, *s))
+            return false;
+
+    bool hasBuffers = false;
+
+    if (!SnapshotIO::read(in, hasBuffers))
+        return false;
+
+    if (!hasBuffers)
+    {
+        reset();
+        return true;
+    }
+
+    // Lines are sized by prepare(), so the snapshot must come from the same rate
+    size_t size = 0;
+
+    if (!SnapshotIO::read(in, size) || size != lineMemorySize
+        || !SnapshotIO::readArray(in, lineMemory.get(), lineMemorySize))
+        return false;
+
+    if (!SnapshotIO::read(in, tank.writePos) || tank.writePos < 0 || tank.writePos > tank.masks[numLines - 1])
+        return false;
+
+    return SnapshotIO::readArray(in, tank.lowpass, numLines);
+}
+
+//==============================================================================
+void FdnReverb::setWet(float value)
+{
+    wetLevel = juce::jlimit(0.0f, 1.0f, value);
+    updateMixGains();
+}
+
+void FdnReverb::setDecay(float seconds)
+{
+    seconds = juce::jlimit(0.05f, 30.0f, seconds);
+
+    if (seconds != decaySeconds)
+    {
+        decaySeconds = seconds;
+        updateLineGains(true);
+    }
+}
+
+void FdnReverb::setWidth(float value)
+{
+    width = juce::jlimit(0.0f, 1.0f, value);
+    updateMixGains();
+}
+
+double FdnReverb::getTailSeconds(float seconds, float attenuationDb) const
+{
+    // DECAY is the RT60; the last write needs one more trip through the longest line
+    seconds = juce::jlimit(0.05f, 30.0f, seconds);
+    return seconds * attenuationDb / 60.0 + tank.delays[numLines - 1] / sampleRate;
+}
+
+void FdnReverb::updateLineGains(bool ramp)
+{
+    // -60 dB after decaySeconds: each pass through line i loses 60 * d_i / (T60 * fs) dB
+    for (int i = 0; i < numLines; ++i)
+    {
+        tank.lineGainTarget[i] = (float)std::pow(10.0, -3.0 * tank.delays[i] / (decaySeconds * sampleRate));
+
+        if (ramp)
+            tank.lineGainStep[i] = (tank.lineGainTarget[i] - tank.lineGain[i]) * (1.0f / (float)rampLength);
+        else
+            tank.lineGain[i] = tank.lineGainTarget[i];
+    }
+
+    tank.lineGainRampRemaining = ramp ? rampLength : 0;
+}
+
+void FdnReverb::setDryEnabled(bool enabled)
+{
+    dryEnabled = enabled;
+    updateMixGains();
+    dryGain.setCurrentAndTargetValue(dryGain.getTargetValue());
+}
+
+void FdnReverb::updateMixGains()
+{
+    const float wet = wetLevel * wetScaleFactor;
+
+    dryGain.setTargetValue(dryEnabled ? (1.0f - wetLevel) * dryScaleFactor : 0.0f);
+    wetGain1.setTargetValue(0.5f * wet * (1.0f + width));
+    wetGain2.setTargetValue(0.5f * wet * (1.0f - width));
+}
+
+//==============================================================================
+template <bool isStereo, bool isDucked, typename SampleType>
+void FdnReverb::processSamples(SampleType* left, SampleType* right, int numSamples, const float* wetScale) noexcept
+{
+    const auto fdnSteps = DspKernels::get().fdnSteps;
+
+    for (int start = 0; start < numSamples; start += maxChunkSize)
+    {
+        const int n = juce::jmin(maxChunkSize, numSamples - start);
+        SampleType* l = left + start;
+        SampleType* r = isStereo ? right + start : nullptr;
+
+        for (int i = 0; i < n; ++i)
+        {
+            inputL[i] = (float)l[i];
+            inputR[i] = isStereo ? (float)r[i] : inputL[i];
+        }
+
+        fdnSteps(tank, inputL, inputR, wetL, wetR, n);
+
+        for (int i = 0; i < n; ++i)
+        {
+            const float outL = wetL[i], outR = wetR[i];
+            const float scale = isDucked ? wetScale[start + i] : 1.0f;
+            const float dry = dryGain.getNextValue();
+            const float wet1 = wetGain1.getNextValue() * scale;
+
+            // The dry signal keeps the host's precision
+            if constexpr (isStereo)
+            {
+                const float wet2 = wetGain2.getNextValue() * scale;
+
+                l[i] = (SampleType)(outL * wet1 + outR * wet2) + l[i] * dry;
+                r[i] = (SampleType)(outR * wet1 + outL * wet2) + r[i] * dry;
+            }
+            else
+            {
+                l[i] = (SampleType)(outL * wet1) + l[i] * dry;
+            }
+        }
+    }
+}
+
+template <typename SampleType>
+void FdnReverb::processMono(SampleType* samples, int numSamples, const float* wetScale)
+{
+    if (wetScale != nullptr)
+        processSamples<false, true>(samples, (SampleType*)nullptr, numSamples, wetScale);
+    else
+        processSamples<false, false>(samples, (SampleType*)nullptr, numSamples, wetScale);
+}
+
+template <typename SampleType>
+void FdnReverb::processStereo(SampleType* left, SampleType* right, int numSamples, const float* wetScale)
+{
+    if (wetScale != nullptr)
+        processSamples<true, true>(left, right, numSamples, wetScale);
+    else
+        processSamples<true, false>(left, right, numSamples, wetScale);
+}
+
+template void FdnReverb::processMono(float*, int, const float*);
+template void FdnReverb::processMono(double*, int, const float*);
+template void FdnReverb::processStereo(float*, float*, int, const float*);
+template void FdnReverb::processStereo(double*, double*, int, const float*);
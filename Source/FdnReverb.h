@@ -0,0 +1,77 @@
+#pragma once
+#include <JuceHeader.h>
+#include "SnapshotIO.h"
+#include "DspKernels.h"
+
+//==============================================================================
+// 8-line feedback delay network.
+//
+// All delay lines are processed together: taps are gathered into one vector,
+// damped, scaled and mixed through a Householder matrix with SIMD registers,
+// then scattered back into the lines. DECAY maps directly onto the RT60.
+//
+// The network itself is DspKernels::fdnSteps, in the widest instruction set
+// the CPU has, run over chunks of up to maxChunkSize samples.
+//==============================================================================
+class FdnReverb
+{
+public:
+    static constexpr int numLines = DspKernels::FdnTank::numLines;
+
+    void prepare(double sampleRate, int samplesPerBlock);
+    void reset();
+
+    void setWet(float value);
+    void setDecay(float seconds);
+    void setWidth(float value);
+
+    // With the dry signal off the tank outputs only its wet mix; eco mode
+    // adds the dry back itself at the host rate. Takes effect immediately.
+    void setDryEnabled(bool enabled);
+
+    // Seconds until the network has decayed by attenuationDb at the given DECAY
+    double getTailSeconds(float decaySeconds, float attenuationDb) const;
+
+    // Longest a sample can circulate before any of it reaches the output:
+    // every line is tapped, so one trip through the longest
+    double getLongestPathSeconds() const { return tank.delays[numLines - 1] / sampleRate; }
+
+    // Exact state snapshot. Without buffers only the parameters and
+    // smoothers are kept, and restoring clears the lines as reset() does.
+    void saveState(juce::OutputStream& out, bool includeBuffers) const;
+    bool restoreState(juce::InputStream& in);
+
+    // wetScale, if given, holds a gain per sample for the wet signal (ducking).
+    // Takes float or double samples; the network itself always runs in float.
+    template <typename SampleType>
+    void processMono(SampleType* samples, int numSamples, const float* wetScale = nullptr);
+
+    template <typename SampleType>
+    void processStereo(SampleType* left, SampleType* right, int numSamples, const float* wetScale = nullptr);
+
+private:
+    // Ramps the line gains to the current DECAY over rampLength samples,
+    // or jumps straight there when ramp is false
+    void updateLineGains(bool ramp);
+    void updateMixGains();
+
+    // Mono feeds the one channel into both inputs and takes the L output
+    template <bool isStereo, bool isDucked, typename SampleType>
+    void processSamples(SampleType* left, SampleType* right, int numSamples, const float* wetScale) noexcept;
+
+    double sampleRate = 44100.0;
+    float decaySeconds = 1.5f;
+    float wetLevel = 0.3f, width = 1.0f;
+    bool dryEnabled = true;
+
+    juce::HeapBlock<float> lineMemory;
+    size_t lineMemorySize = 0;
+
+    DspKernels::FdnTank tank {};
+    int rampLength = 1;
+
+    static constexpr int maxChunkSize = 32;
+    float inputL[maxChunkSize], inputR[maxChunkSize], wetL[maxChunkSize], wetR[maxChunkSize];
+
+    juce::SmoothedValue<float> dryGain, wetGain1, wetGain2;
+};
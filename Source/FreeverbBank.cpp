@@ -0,0 +1,403 @@
+#include "FreeverbBank.h"
+
+namespace
+{
+    // Tunings and gain laws from juce::Reverb, so the output matches it
+    constexpr short combTunings[FreeverbBank::numCombs] = { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 };
+    constexpr short allPassTunings[FreeverbBank::numAllPasses] = { 556, 441, 341, 225 };
+    constexpr int stereoSpread = 23;
+
+    constexpr float fixedGain = 0.015f;
+    constexpr float wetScaleFactor = 3.0f;
+    constexpr float dryScaleFactor = 2.0f;
+    constexpr float roomScaleFactor = 0.28f;
+    constexpr float roomOffset = 0.7f;
+    constexpr float dampingAmount = 0.5f * 0.4f;
+
+    // Calls fn(offsetInChunk, bufferIndex, length) for the one or two
+    // contiguous runs that n samples starting at start cover in a ring of size
+    template <typename Fn>
+    inline void forEachRun(int start, int size, int n, Fn&& fn) noexcept
+    {
+        if (start >= size)
+            start -= size;
+
+        const int first = juce::jmin(n, size - start);
+        fn(0, start, first);
+
+        if (first < n)
+            fn(first, 0, n - first);
+    }
+
+    template <typename Type>
+    inline void undenormalise(Type& x) noexcept
+    {
+       #if JUCE_INTEL
+        x += 0.1f;
+        x -= 0.1f;
+       #else
+        juce::ignoreUnused(x);
+       #endif
+    }
+}
+
+//==============================================================================
+void FreeverbBank::prepare(double newSampleRate, int)
+{
+    sampleRate = newSampleRate;
+
+    // Same integer rounding as juce::Reverb::setSampleRate
+    const int intSampleRate = (int)sampleRate;
+    const auto lineLength = [intSampleRate](int tuning)
+        {
+            return juce::jmax(1, (intSampleRate * tuning) / 44100);
+        };
+
+    size_t totalSize = 0;
+
+    const auto layout = [&](StereoDelay& d, int tuning)
+        {
+            d.size = lineLength(tuning + stereoSpread);
+            d.leftOffset = d.size - lineLength(tuning);
+            d.pos = 0;
+            totalSize += 2 * (size_t)d.size;
+        };
+
+    for (int i = 0; i < numCombs; ++i)
+        layout(combs[i], combTunings[i]);
+
+    for (int i = 0; i < numAllPasses; ++i)
+        layout(allPasses[i], allPassTunings[i]);
+
+    chunkSize = maxChunkSize;
+    for (int i = 0; i < numCombs; ++i)
+        chunkSize = juce::jmin(chunkSize, lineLength(combTunings[i]));
+    for (int i = 0; i < numAllPasses; ++i)
+        chunkSize = juce::jmin(chunkSize, lineLength(allPassTunings[i]));
+
+    delayMemory.calloc(totalSize);
+    delayMemorySize = totalSize;
+
+    float* p = delayMemory.get();
+    for (auto& d : combs)     { d.frames = p; p += 2 * d.size; }
+    for (auto& d : allPasses) { d.frames = p; p += 2 * d.size; }
+
+    const double smoothTime = 0.01;
+    damping.reset(sampleRate, smoothTime);
+    feedback.reset(sampleRate, smoothTime);
+    dryGain.reset(sampleRate, smoothTime);
+    wetGain1.reset(sampleRate, smoothTime);
+    wetGain2.reset(sampleRate, smoothTime);
+
+    damping.setCurrentAndTargetValue(dampingAmount);
+    feedback.setCurrentAndTargetValue(roomSize * roomScaleFactor + roomOffset);
+    updateMixGains();
+
+    dryGain.setCurrentAndTargetValue(dryGain.getTargetValue());
+    wetGain1.setCurrentAndTargetValue(wetGain1.getTargetValue());
+    wetGain2.setCurrentAndTargetValue(wetGain2.getTargetValue());
+
+    reset();
+}
+
+void FreeverbBank::reset()
+{
+    if (delayMemory != nullptr)
+        juce::FloatVectorOperations::clear(delayMemory.get(), (int)delayMemorySize);
+
+    for (auto& d : combs)     d.pos = 0;
+    for (auto& d : allPasses) d.pos = 0;
+
+    std::fill(std::begin(combLast), std::end(combLast), 0.0f);
+}
+
+//==============================================================================
+void FreeverbBank::saveState(juce::OutputStream& out, bool includeBuffers) const
+{
+    SnapshotIO::write(out, wetLevel);
+    SnapshotIO::write(out, roomSize);
+    SnapshotIO::write(out, width);
+
+    for (const auto* s : { &damping, &feedback, &dryGain, &wetGain1, &wetGain2 })
+        SnapshotIO::write(out, *s);
+
+    SnapshotIO::write(out, includeBuffers);
+
+    if (!includeBuffers)
+        return;
+
+    SnapshotIO::write(out, delayMemorySize);
+    SnapshotIO::writeArray(out, delayMemory.get(), delayMemorySize);
+
+    for (const auto& d : combs)     SnapshotIO::write(out, d.pos);
+    for (const auto& d : allPasses) SnapshotIO::write(out, d.pos);
+
+    SnapshotIO::writeArray(out, combLast, numLanes);
+}
+
+bool FreeverbBank::restoreState(juce::InputStream& in)
+{
+    bool hasBuffers = false;
+
+    if (!(SnapshotIO::read(in, wetLevel) && SnapshotIO::read(in, roomSize) && SnapshotIO::read(in, width)))
+        return false;
+
+    for (auto* s : { &damping, &feedback, &dryGain, &wetGain1, &wetGain2 })
+        if (!SnapshotIO::read(in, *s))
+            return false;
+
+    if (!SnapshotIO::read(in, hasBuffers))
+        return false;
+
+    if (!hasBuffers)
+    {
+        reset();
+        return true;
+    }
+
+    // Lines are sized by prepare(), so the snapshot must come from the same rate
+    size_t size = 0;
+
+    if (!SnapshotIO::read(in, size) || size != delayMemorySize
+        || !SnapshotIO::readArray(in, delayMemory.get(), delayMemorySize))
+        return false;
+
+    const auto readPosition = [&in](StereoDelay& d)
+        {
+            return SnapshotIO::read(in, d.pos) && d.pos >= 0 && d.pos < d.size;
+        };
+
+    for (auto& d : combs)
+        if (!readPosition(d))
+            return false;
+
+    for (auto& d : allPasses)
+        if (!readPosition(d))
+            return false;
+
+    return SnapshotIO::readArray(in, combLast, numLanes);
+}
+
+//==============================================================================
+void FreeverbBank::setWet(float value)
+{
+    wetLevel = juce::jlimit(0.0f, 1.0f, value);
+    updateMixGains();
+}
+
+void FreeverbBank::setDecay(float seconds)
+{
+    // Map 0.1 – 6.0 seconds → roomSize (0–1)
+    roomSize = juce::jlimit(0.05f, 1.0f, seconds / 6.0f);
+    feedback.setTargetValue(roomSize * roomScaleFactor + roomOffset);
+}
+
+void FreeverbBank::setWidth(float value)
+{
+    width = juce::jlimit(0.0f, 1.0f, value);
+    updateMixGains();
+}
+
+double FreeverbBank::getTailSeconds(float decaySeconds, float attenuationDb) const
+{
+    // Low frequencies pass the damping filter unchanged, so the longest comb
+    // loses -20*log10(feedback) dB per trip and rings the longest
+    const float room = juce::jlimit(0.05f, 1.0f, decaySeconds / 6.0f);
+    const double lossPerTripDb = -20.0 * std::log10((double)(room * roomScaleFactor + roomOffset));
+
+    int longestComb = 0, allPassDelay = 0;
+    for (const auto& d : combs)
+        longestComb = juce::jmax(longestComb, d.size);
+    for (const auto& d : allPasses)
+        allPassDelay += d.size;
+
+    return (attenuationDb / lossPerTripDb * longestComb + allPassDelay) / sampleRate;
+}
+
+double FreeverbBank::getLongestPathSeconds() const
+{
+    int longestComb = 0, allPassDelay = 0;
+    for (const auto& d : combs)
+        longestComb = juce::jmax(longestComb, d.size);
+    for (const auto& d : allPasses)
+        allPassDelay += d.size;
+
+    return (longestComb + allPassDelay) / sampleRate;
+}
+
+void FreeverbBank::setDryEnabled(bool enabled)
+{
+    dryEnabled = enabled;
+    updateMixGains();
+    dryGain.setCurrentAndTargetValue(dryGain.getTargetValue());
+}
+
+void FreeverbBank::updateMixGains()
+{
+    const float wet = wetLevel * wetScaleFactor;
+
+    dryGain.setTargetValue(dryEnabled ? (1.0f - wetLevel) * dryScaleFactor : 0.0f);
+    wetGain1.setTargetValue(0.5f * wet * (1.0f + width));
+    wetGain2.setTargetValue(0.5f * wet * (1.0f - width));
+}
+
+//==============================================================================
+template <bool isStereo, bool isDucked, typename SampleType>
+void FreeverbBank::processSamples(SampleType* left, SampleType* right, int numSamples, const float* wetScale) noexcept
+{
+    constexpr int lanes = (int)Vec::SIMDNumElements;
+    constexpr int activeVecs = isStereo ? numVecs : numVecs / 2;
+    constexpr int numChannels = isStereo ? 2 : 1;
+
+    const auto& kernels = DspKernels::get();
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        const int n = juce::jmin(chunkSize, numSamples - start);
+        SampleType* l = left + start;
+        SampleType* r = isStereo ? right + start : nullptr;
+        const float* duck = isDucked ? wetScale + start : nullptr;
+
+        // Every tap of this chunk was written before the chunk started (n never
+        // exceeds the shortest line), so a comb can be read and written as
+        // contiguous runs, transposed into lane-major tiles for the SIMD update.
+        for (int j = 0; j < numCombs; ++j)
+        {
+            const auto& c = combs[j];
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                const float* src = c.frames + ch;
+                const int lane = ch * numCombs + j;
+
+                forEachRun(c.pos + (ch == 0 ? c.leftOffset : 0), c.size, n,
+                    [&](int offset, int idx, int length)
+                    {
+                        for (int i = 0; i < length; ++i)
+                            tile[offset + i][lane] = src[2 * (idx + i)];
+                    });
+            }
+        }
+
+        for (int i = 0; i < n; ++i)
+        {
+            inputs[i] = (float)(isStereo ? l[i] + r[i] : l[i]) * fixedGain;
+            dampings[i] = damping.getNextValue();
+            feedbacks[i] = feedback.getNextValue();
+
+            // The combs output what they read, before the update below
+            auto sumL = Vec::expand(0.0f);
+            auto sumR = Vec::expand(0.0f);
+
+            for (int k = 0; k < activeVecs; ++k)
+            {
+                const auto y = Vec::fromRawArray(tile[i] + k * lanes);
+
+                if (k * lanes < numCombs)
+                    sumL += y;
+                else
+                    sumR += y;
+            }
+
+            wetL[i] = sumL.sum();
+            wetR[i] = sumR.sum();
+        }
+
+        kernels.combSteps(tile[0], numLanes, n, activeVecs * lanes, combLast, dampings, feedbacks, inputs);
+
+        for (int j = 0; j < numCombs; ++j)
+        {
+            auto& c = combs[j];
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                float* dest = c.frames + ch;
+                const int lane = ch * numCombs + j;
+
+                forEachRun(c.pos, c.size, n, [&](int offset, int idx, int length)
+                    {
+                        for (int i = 0; i < length; ++i)
+                            dest[2 * (idx + i)] = tile[offset + i][lane];
+                    });
+            }
+
+            c.advance(n);
+        }
+
+        // Allpasses have no recursion shorter than their length either, so
+        // each stage runs over the whole chunk before the next one
+        for (auto& a : allPasses)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                float* io = ch == 0 ? wetL : wetR;
+                float* frames = a.frames + ch;
+
+                // Reads come first in time, so stage the delayed samples before writing
+                forEachRun(a.pos + (ch == 0 ? a.leftOffset : 0), a.size, n,
+                    [&](int offset, int idx, int length)
+                    {
+                        for (int i = 0; i < length; ++i)
+                            scratch[offset + i] = frames[2 * (idx + i)];
+                    });
+
+                for (int i = 0; i < n; ++i)
+                {
+                    float temp = io[i] + scratch[i] * 0.5f;
+                    undenormalise(temp);
+                    io[i] = scratch[i] - io[i];
+                    scratch[i] = temp;
+                }
+
+                forEachRun(a.pos, a.size, n, [&](int offset, int idx, int length)
+                    {
+                        for (int i = 0; i < length; ++i)
+                            frames[2 * (idx + i)] = scratch[offset + i];
+                    });
+            }
+
+            a.advance(n);
+        }
+
+        for (int i = 0; i < n; ++i)
+        {
+            const float dry = dryGain.getNextValue();
+            const float scale = isDucked ? duck[i] : 1.0f;
+            const float wet1 = wetGain1.getNextValue() * scale;
+
+            if constexpr (isStereo)
+            {
+                const float wet2 = wetGain2.getNextValue() * scale;
+
+                // The dry signal keeps the host's precision
+                l[i] = (SampleType)(wetL[i] * wet1 + wetR[i] * wet2) + l[i] * dry;
+                r[i] = (SampleType)(wetR[i] * wet1 + wetL[i] * wet2) + r[i] * dry;
+            }
+            else
+            {
+                l[i] = (SampleType)(wetL[i] * wet1) + l[i] * dry;
+            }
+        }
+    }
+}
+
+template <typename SampleType>
+void FreeverbBank::processMono(SampleType* samples, int numSamples, const float* wetScale)
+{
+    if (wetScale != nullptr)
+        processSamples<false, true>(samples, (SampleType*)nullptr, numSamples, wetScale);
+    else
+        processSamples<false, false>(samples, (SampleType*)nullptr, numSamples, wetScale);
+}
+
+template <typename SampleType>
+void FreeverbBank::processStereo(SampleType* left, SampleType* right, int numSamples, const float* wetScale)
+{
+    if (wetScale != nullptr)
+        processSamples<true, true>(left, right, numSamples, wetScale);
+    else
+        processSamples<true, false>(left, right, numSamples, wetScale);
+}
+
+template void FreeverbBank::processMono(float*, int, const float*);
+template void FreeverbBank::processMono(double*, int, const float*);
+template void FreeverbBank::processStereo(float*, float*, int, const float*);
+template void FreeverbBank::processStereo(double*, double*, int, const float*);
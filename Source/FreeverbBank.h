@@ -0,0 +1,105 @@
+#pragma once
+#include <JuceHeader.h>
+#include "SnapshotIO.h"
+#include "DspKernels.h"
+
+//==============================================================================
+// Freeverb comb/allpass topology, drop-in for juce::Reverb.
+//
+// The 8 combs of both channels run as 16 SIMD lanes (L combs then R combs).
+// Each comb and allpass keeps its L and R state interleaved in one buffer of
+// [L, R] frames: the R line is the longer (stereo-spread) one and is read at
+// the write position, the L line is read a fixed number of frames ahead of
+// it, so both channels of a filter walk the same cache lines.
+//
+// Work is done in chunks no longer than the shortest line, which lets every
+// filter be read and written as contiguous runs without per-sample wrapping.
+// The comb update itself is DspKernels::combSteps, in the widest instruction
+// set the CPU has.
+//==============================================================================
+class FreeverbBank
+{
+public:
+    static constexpr int numCombs = 8;
+    static constexpr int numAllPasses = 4;
+
+    void prepare(double sampleRate, int samplesPerBlock);
+    void reset();
+
+    void setWet(float value);
+    void setDecay(float seconds);
+    void setWidth(float value);
+
+    // With the dry signal off the tank outputs only its wet mix; eco mode
+    // adds the dry back itself at the host rate. Takes effect immediately.
+    void setDryEnabled(bool enabled);
+
+    // Seconds until the tank has decayed by attenuationDb at the given DECAY
+    double getTailSeconds(float decaySeconds, float attenuationDb) const;
+
+    // Longest a sample can circulate before any of it reaches the output:
+    // the longest comb followed by the allpass chain
+    double getLongestPathSeconds() const;
+
+    // Exact state snapshot. Without buffers only the parameters and
+    // smoothers are kept, and restoring clears the lines as reset() does.
+    void saveState(juce::OutputStream& out, bool includeBuffers) const;
+    bool restoreState(juce::InputStream& in);
+
+    // wetScale, if given, holds a gain per sample for the wet signal (ducking).
+    // Takes float or double samples; the tank itself always runs in float.
+    template <typename SampleType>
+    void processMono(SampleType* samples, int numSamples, const float* wetScale = nullptr);
+
+    template <typename SampleType>
+    void processStereo(SampleType* left, SampleType* right, int numSamples, const float* wetScale = nullptr);
+
+private:
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr int numLanes = numCombs * 2;
+    static constexpr int numVecs = numLanes / (int)Vec::SIMDNumElements;
+
+    static_assert(numCombs % Vec::SIMDNumElements == 0,
+        "L and R combs must not share a SIMD register");
+
+    struct StereoDelay
+    {
+        float* frames = nullptr;
+        int size = 0;        // length of the R line, in frames
+        int leftOffset = 0;  // R length minus L length
+        int pos = 0;
+
+        void advance(int numFrames) noexcept
+        {
+            pos += numFrames;
+            if (pos >= size)
+                pos -= size;
+        }
+    };
+
+    template <bool isStereo, bool isDucked, typename SampleType>
+    void processSamples(SampleType* left, SampleType* right, int numSamples, const float* wetScale) noexcept;
+
+    void updateMixGains();
+
+    double sampleRate = 44100.0;
+    float wetLevel = 0.3f, roomSize = 0.5f, width = 1.0f;
+    bool dryEnabled = true;
+
+    juce::HeapBlock<float> delayMemory;
+    size_t delayMemorySize = 0;
+
+    StereoDelay combs[numCombs];
+    StereoDelay allPasses[numAllPasses];
+
+    alignas(Vec::SIMDRegisterSize) float combLast[numLanes];
+
+    static constexpr int maxChunkSize = 32;
+    int chunkSize = maxChunkSize;
+
+    alignas(Vec::SIMDRegisterSize) float tile[maxChunkSize][numLanes];
+    float wetL[maxChunkSize], wetR[maxChunkSize], scratch[maxChunkSize];
+    float inputs[maxChunkSize], dampings[maxChunkSize], feedbacks[maxChunkSize];
+
+    juce::SmoothedValue<float> damping, feedback, dryGain, wetGain1, wetGain2;
+};
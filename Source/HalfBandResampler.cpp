@@ -0,0 +1,366 @@
+#include "HalfBandResampler.h"
+
+namespace
+{
+    constexpr int delay = HalfBandFilter::delay;
+    constexpr int numCoefficients = HalfBandFilter::numCoefficients;
+    constexpr const float* coefficients = HalfBandFilter::coefficients;
+}
+
+//==============================================================================
+void HalfBandDecimator::reset() noexcept
+{
+    std::fill(std::begin(even), std::end(even), 0.0f);
+    std::fill(std::begin(odd), std::end(odd), 0.0f);
+    unpaired = 0.0f;
+    hasUnpaired = false;
+}
+
+template <typename SampleType>
+int HalfBandDecimator::process(const SampleType* input, int numSamples, float* output) noexcept
+{
+    const auto& kernels = DspKernels::get();
+    int numOut = 0, i = 0;
+
+    while (i < numSamples)
+    {
+        float* e = even + historySize;
+        float* o = odd + historySize;
+        int numPairs = 0;
+
+        if (hasUnpaired)
+        {
+            e[0] = unpaired;
+            o[0] = (float)input[i++];
+            hasUnpaired = false;
+            numPairs = 1;
+        }
+
+        for (; numPairs < chunkSize && i + 1 < numSamples; ++numPairs, i += 2)
+        {
+            e[numPairs] = (float)input[i];
+            o[numPairs] = (float)input[i + 1];
+        }
+
+        if (numPairs < chunkSize && i + 1 == numSamples)
+        {
+            unpaired = (float)input[i++];
+            hasUnpaired = true;
+        }
+
+        if (numPairs == 0)
+            break;
+
+        // Each output completes a pair. Its centre tap lands on the even
+        // sample delay / 2 pairs back, all the others on odd samples.
+        constexpr int centre = delay / 2 + 1;
+
+        kernels.decimate(even + centre, odd + centre, coefficients, numCoefficients, numPairs, output + numOut);
+
+        std::memmove(even, even + numPairs, sizeof(float) * (size_t)historySize);
+        std::memmove(odd, odd + numPairs, sizeof(float) * (size_t)historySize);
+
+        numOut += numPairs;
+    }
+
+    return numOut;
+}
+
+void HalfBandDecimator::saveState(juce::OutputStream& out) const
+{
+    SnapshotIO::writeArray(out, even, (size_t)historySize);
+    SnapshotIO::writeArray(out, odd, (size_t)historySize);
+    SnapshotIO::write(out, unpaired);
+    SnapshotIO::write(out, hasUnpaired);
+}
+
+bool HalfBandDecimator::restoreState(juce::InputStream& in)
+{
+    return SnapshotIO::readArray(in, even, (size_t)historySize)
+        && SnapshotIO::readArray(in, odd, (size_t)historySize)
+        && SnapshotIO::read(in, unpaired)
+        && SnapshotIO::read(in, hasUnpaired);
+}
+
+//==============================================================================
+void HalfBandInterpolator::reset() noexcept
+{
+    std::fill(std::begin(history), std::end(history), 0.0f);
+}
+
+void HalfBandInterpolator::process(const float* input, int numSamples, float* output) noexcept
+{
+    // Zero-stuffing doubles the gain of the filter's even branch and leaves
+    // the odd one a pure delay of delay / 2 input samples
+    constexpr int centre = delay / 2 + 1;
+
+    const auto& kernels = DspKernels::get();
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        const int n = juce::jmin(chunkSize, numSamples - start);
+
+        juce::FloatVectorOperations::copy(history + historySize, input + start, n);
+
+        kernels.interpolate(history + centre, coefficients, numCoefficients, n, output + 2 * start);
+
+        std::memmove(history, history + n, sizeof(float) * (size_t)historySize);
+    }
+}
+
+void HalfBandInterpolator::saveState(juce::OutputStream& out) const
+{
+    SnapshotIO::writeArray(out, history, (size_t)historySize);
+}
+
+bool HalfBandInterpolator::restoreState(juce::InputStream& in)
+{
+    return SnapshotIO::readArray(in, history, (size_t)historySize);
+}
+
+//==============================================================================
+void EcoResampler::prepare(int newFactor, int maxBlockSize, int newNumChannels)
+{
+    jassert(newFactor == 2 || newFactor == 4);
+    jassert(newNumChannels > 0 && newNumChannels <= maxChannels);
+
+    factor = newFactor == 4 ? 4 : 2;
+    numStages = factor == 4 ? 2 : 1;
+    numChannels = juce::jlimit(1, maxChannels, newNumChannels);
+
+    // Every stage's filter delay counted at the host rate, which with the
+    // factor - 1 samples of wet kept queued (for blocks that end mid-frame)
+    // comes to a whole number of filter delays
+    latency = 2 * delay * (factor - 1);
+
+    maxBlock = juce::jmax(1, maxBlockSize);
+    maxLowRateBlock = maxBlock / factor + 1;
+    wetCapacity = maxBlock + 2 * factor;
+
+    delaySize = juce::nextPowerOfTwo(latency + maxBlock);
+    delayMask = delaySize - 1;
+
+    // The middle rate, between two stages: the first decimator's output on
+    // the way down, the first interpolator's on the way up
+    const int stageSize = juce::jmax(maxBlock / 2 + 1, 2 * maxLowRateBlock);
+    const int perChannel = maxLowRateBlock + stageSize + wetCapacity;
+
+    memory.calloc((size_t)(numChannels * perChannel + delaySize + maxBlock));
+    dryMemory.calloc((size_t)(numChannels * delaySize));
+
+    float* p = memory.get();
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        lowRate[ch] = p;  p += maxLowRateBlock;
+        stage[ch] = p;    p += stageSize;
+        wet[ch] = p;      p += wetCapacity;
+        delayed[ch] = dryMemory + ch * delaySize;
+    }
+
+    delayedScale = p;
+    p += delaySize;
+
+    dryGains = p;
+
+    reset();
+}
+
+void EcoResampler::reset()
+{
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        for (auto& decimator : decimators[ch])
+            decimator.reset();
+
+        for (auto& interpolator : interpolators[ch])
+            interpolator.reset();
+    }
+
+    if (memory != nullptr)
+    {
+        juce::FloatVectorOperations::clear(memory.get(), (int)(dryGains - memory.get()));
+        juce::FloatVectorOperations::clear(dryMemory.get(), numChannels * delaySize);
+    }
+
+    // Blocks that end part-way through a low-rate frame leave up to
+    // factor - 1 host samples that only arrive with the next one
+    numWet = factor - 1;
+    delayWritePos = 0;
+}
+
+//==============================================================================
+template <typename SampleType>
+int EcoResampler::down(const juce::AudioBuffer<SampleType>& block, const float* wetScale) noexcept
+{
+    using FVO = juce::FloatVectorOperations;
+
+    const int numBlockChannels = juce::jmin(block.getNumChannels(), numChannels);
+    const int numSamples = block.getNumSamples();
+
+    jassert(numSamples <= maxBlock);
+
+    // Keep the dry signal and ducking gains for mix() to pick up once the
+    // wet has come round
+    const int first = juce::jmin(numSamples, delaySize - delayWritePos);
+
+    const auto store = [&](auto* plane, const auto* source)
+        {
+            std::copy_n(source, first, plane + delayWritePos);
+            std::copy_n(source + first, numSamples - first, plane);
+        };
+
+    for (int ch = 0; ch < numBlockChannels; ++ch)
+        store(delayed[ch], block.getReadPointer(ch));
+
+    if (wetScale != nullptr)
+    {
+        store(delayedScale, wetScale);
+    }
+    else
+    {
+        FVO::fill(delayedScale + delayWritePos, 1.0f, first);
+        FVO::fill(delayedScale, 1.0f, numSamples - first);
+    }
+
+    int numLowRate = 0;
+
+    for (int ch = 0; ch < numBlockChannels; ++ch)
+    {
+        const SampleType* source = block.getReadPointer(ch);
+
+        if (numStages == 1)
+        {
+            numLowRate = decimators[ch][0].process(source, numSamples, lowRate[ch]);
+        }
+        else
+        {
+            const int numHalf = decimators[ch][0].process(source, numSamples, stage[ch]);
+            numLowRate = decimators[ch][1].process(stage[ch], numHalf, lowRate[ch]);
+        }
+    }
+
+    return numLowRate;
+}
+
+template <typename SampleType>
+void EcoResampler::mix(juce::AudioBuffer<SampleType>& block, int numLowRate, juce::SmoothedValue<float>& dryGain) noexcept
+{
+    const int numBlockChannels = juce::jmin(block.getNumChannels(), numChannels);
+    const int numSamples = block.getNumSamples();
+
+    jassert(numLowRate <= maxLowRateBlock);
+
+    for (int ch = 0; ch < numBlockChannels; ++ch)
+    {
+        float* dest = wet[ch] + numWet;
+
+        if (numStages == 1)
+        {
+            interpolators[ch][0].process(lowRate[ch], numLowRate, dest);
+        }
+        else
+        {
+            interpolators[ch][1].process(lowRate[ch], numLowRate, stage[ch]);
+            interpolators[ch][0].process(stage[ch], 2 * numLowRate, dest);
+        }
+    }
+
+    numWet += numLowRate * factor;
+    jassert(numWet >= numSamples && numWet <= wetCapacity);
+
+    if (dryGain.isSmoothing())
+    {
+        for (int i = 0; i < numSamples; ++i)
+            dryGains[i] = dryGain.getNextValue();
+    }
+    else
+    {
+        juce::FloatVectorOperations::fill(dryGains, dryGain.getTargetValue(), numSamples);
+    }
+
+    // The delayed samples may wrap round the end of the delay line
+    const int readPos = (delayWritePos - latency) & delayMask;
+    const int first = juce::jmin(numSamples, delaySize - readPos);
+    const float* scale = delayedScale;
+
+    for (int ch = 0; ch < numBlockChannels; ++ch)
+    {
+        SampleType* out = block.getWritePointer(ch);
+        const double* dry = delayed[ch];
+        float* w = wet[ch];
+
+        // The dry signal at the block's precision, the wet in float
+        const auto mixRun = [&](int offset, int delayPos, int length)
+            {
+                for (int i = offset; i < offset + length; ++i, ++delayPos)
+                    out[i] = (SampleType)(dry[delayPos] * dryGains[i]) + (SampleType)(w[i] * scale[delayPos]);
+            };
+
+        mixRun(0, readPos, first);
+        mixRun(first, 0, numSamples - first);
+
+        std::memmove(w, w + numSamples, sizeof(float) * (size_t)(numWet - numSamples));
+    }
+
+    numWet -= numSamples;
+    delayWritePos = (delayWritePos + numSamples) & delayMask;
+}
+
+template int EcoResampler::down(const juce::AudioBuffer<float>&, const float*) noexcept;
+template int EcoResampler::down(const juce::AudioBuffer<double>&, const float*) noexcept;
+template void EcoResampler::mix(juce::AudioBuffer<float>&, int, juce::SmoothedValue<float>&) noexcept;
+template void EcoResampler::mix(juce::AudioBuffer<double>&, int, juce::SmoothedValue<float>&) noexcept;
+
+//==============================================================================
+void EcoResampler::saveState(juce::OutputStream& out) const
+{
+    SnapshotIO::write(out, factor);
+    SnapshotIO::write(out, numChannels);
+    SnapshotIO::write(out, delaySize);
+    SnapshotIO::write(out, delayWritePos);
+    SnapshotIO::write(out, numWet);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        for (const auto& decimator : decimators[ch])
+            decimator.saveState(out);
+
+        for (const auto& interpolator : interpolators[ch])
+            interpolator.saveState(out);
+
+        SnapshotIO::writeArray(out, wet[ch], (size_t)numWet);
+        SnapshotIO::writeArray(out, delayed[ch], (size_t)delaySize);
+    }
+
+    SnapshotIO::writeArray(out, delayedScale, (size_t)delaySize);
+}
+
+bool EcoResampler::restoreState(juce::InputStream& in)
+{
+    int savedFactor = 0, savedChannels = 0, savedDelaySize = 0;
+
+    if (!(SnapshotIO::read(in, savedFactor) && savedFactor == factor
+          && SnapshotIO::read(in, savedChannels) && savedChannels == numChannels
+          && SnapshotIO::read(in, savedDelaySize) && savedDelaySize == delaySize
+          && SnapshotIO::read(in, delayWritePos) && juce::isPositiveAndBelow(delayWritePos, delaySize)
+          && SnapshotIO::read(in, numWet) && juce::isPositiveAndNotGreaterThan(numWet, wetCapacity)))
+        return false;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        for (auto& decimator : decimators[ch])
+            if (!decimator.restoreState(in))
+                return false;
+
+        for (auto& interpolator : interpolators[ch])
+            if (!interpolator.restoreState(in))
+                return false;
+
+        if (!SnapshotIO::readArray(in, wet[ch], (size_t)numWet)
+            || !SnapshotIO::readArray(in, delayed[ch], (size_t)delaySize))
+            return false;
+    }
+
+    return SnapshotIO::readArray(in, delayedScale, (size_t)delaySize);
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include <JuceHeader.h>
+#include "SnapshotIO.h"
+#include "DspKernels.h"
+
+//==============================================================================
+// 31-tap linear-phase half-band FIR (Kaiser, beta 7): flat to 0.17 fs, at
+// least 70 dB down from 0.33 fs. Every other tap is zero, so both converters
+// below run it polyphase: one branch is 8 symmetric taps, the other a plain
+// delay. The group delay is 15 samples at the higher rate.
+//
+// Both keep linear histories, the decimator's split into its two phases, so
+// every output is a short loop over contiguous samples, run a register of
+// outputs at a time by DspKernels.
+//==============================================================================
+struct HalfBandFilter
+{
+    static constexpr int numTaps = 31;
+    static constexpr int delay = (numTaps - 1) / 2;
+    static constexpr int numCoefficients = (numTaps + 1) / 4;
+
+    // Taps at delay +- (2m - 1), m = 1..numCoefficients; the centre tap is 0.5
+    static constexpr float coefficients[numCoefficients] = {
+        3.137553524e-01f, -9.309585073e-02f, 4.399148690e-02f, -2.159313323e-02f,
+        9.804640936e-03f, -3.772687340e-03f, 1.064564372e-03f, -1.258684805e-04f
+    };
+};
+
+//==============================================================================
+// 2:1 decimator. Outputs on every second input sample, counting from the last
+// reset, so calls of any length (odd ones included) join seamlessly.
+//==============================================================================
+class HalfBandDecimator
+{
+public:
+    void reset() noexcept;
+
+    // Returns the number of outputs written: numSamples / 2, give or take
+    // one depending on the carried-over phase. The input can be float or
+    // double; the filter runs in float.
+    template <typename SampleType>
+    int process(const SampleType* input, int numSamples, float* output) noexcept;
+
+    void saveState(juce::OutputStream& out) const;
+    bool restoreState(juce::InputStream& in);
+
+private:
+    static constexpr int historySize = 2 * HalfBandFilter::numCoefficients - 1;
+    static constexpr int chunkSize = 64;
+
+    // Even and odd input samples, the last historySize pairs first
+    float even[historySize + chunkSize] = {};
+    float odd[historySize + chunkSize] = {};
+
+    // An even sample still waiting for its odd partner
+    float unpaired = 0.0f;
+    bool hasUnpaired = false;
+};
+
+//==============================================================================
+// 1:2 interpolator: two outputs for every input
+//==============================================================================
+class HalfBandInterpolator
+{
+public:
+    void reset() noexcept;
+
+    void process(const float* input, int numSamples, float* output) noexcept;
+
+    void saveState(juce::OutputStream& out) const;
+    bool restoreState(juce::InputStream& in);
+
+private:
+    static constexpr int historySize = 2 * HalfBandFilter::numCoefficients - 1;
+    static constexpr int chunkSize = 64;
+
+    float history[historySize + chunkSize] = {};   // inputs, the last historySize first
+};
+
+//==============================================================================
+// The eco-mode wrapper around a tank: takes host-rate blocks down by 2 or 4
+// through cascaded half-band stages, lets the tank run on the low-rate signal,
+// and brings its wet output back up for the dry/wet mix at the host rate.
+//
+// The round trip has a fixed latency (getLatencySamples), so the dry signal
+// and the ducking gains are delayed by the same amount before mixing and the
+// processor reports it to the host. Low-rate blocks vary in length by one
+// sample when the host block isn't a multiple of the factor; the upsampled
+// wet is queued so every call still mixes exactly its own block.
+//==============================================================================
+class EcoResampler
+{
+public:
+    static constexpr int maxChannels = 12;  // as ReverbEngine
+
+    // factor is 2 or 4; maxBlockSize is the longest host-rate block. Only
+    // numChannels channels get converters and memory.
+    void prepare(int factor, int maxBlockSize, int numChannels = 2);
+    void reset();
+
+    int getFactor() const noexcept { return factor; }
+
+    // Host-rate samples the wet and dry paths are delayed by
+    int getLatencySamples() const noexcept { return latency; }
+
+    // Longest low-rate block down() can produce from maxBlockSize samples
+    int getMaxLowRateBlockSize() const noexcept { return maxLowRateBlock; }
+
+    // Takes a host-rate block, remembers its dry signal (and ducking gains,
+    // if any) for mix(), and leaves its low-rate version in
+    // getLowRateChannel(). Returns the number of low-rate samples. Blocks
+    // can be float or double; only the dry signal is kept at that precision.
+    template <typename SampleType>
+    int down(const juce::AudioBuffer<SampleType>& block, const float* wetScale) noexcept;
+
+    float* getLowRateChannel(int channel) noexcept { return lowRate[channel]; }
+
+    // Upsamples numLowRate samples of tank output from the low-rate channels
+    // and writes dry * dryGain + wet * ducking into the block that was
+    // passed to down()
+    template <typename SampleType>
+    void mix(juce::AudioBuffer<SampleType>& block, int numLowRate, juce::SmoothedValue<float>& dryGain) noexcept;
+
+    void saveState(juce::OutputStream& out) const;
+    bool restoreState(juce::InputStream& in);
+
+private:
+    int factor = 1, numStages = 0, latency = 0;
+    int numChannels = 0, maxBlock = 0, maxLowRateBlock = 0;
+
+    HalfBandDecimator decimators[maxChannels][2];
+    HalfBandInterpolator interpolators[maxChannels][2];
+
+    juce::HeapBlock<float> memory;
+    float* lowRate[maxChannels] = {};
+    float* stage[maxChannels] = {};     // scratch between the two stages
+    float* wet[maxChannels] = {};       // upsampled wet not yet mixed
+    int wetCapacity = 0, numWet = 0;
+
+    // Dry channels and ducking gains, delayed by latency. The dry is held
+    // as double, which stores float blocks exactly too.
+    juce::HeapBlock<double> dryMemory;
+    double* delayed[maxChannels] = {};
+    float* delayedScale = nullptr;
+    int delaySize = 0, delayMask = 0, delayWritePos = 0;
+
+    float* dryGains = nullptr;          // per-sample dry gain for one block
+};
@@ -0,0 +1,407 @@
+#include "ImpulseResponseCache.h"
+#include "ConvolutionReverb.h"
+
+namespace
+{
+    // IRs are normalised to unit energy, then scaled to sit near the
+    // algorithmic engines' wet level
+    constexpr float impulseGain = 0.4f;
+
+    // Backing file layout: fixed header, then numChannels * numPartitions
+    // split spectra. The header is padded so the spectra stay SIMD-aligned.
+    constexpr char fileMagic[8] = { 'L', 'S', 'R', 'I', 'R', 'C', '0', '1' };
+    constexpr size_t headerSize = 64;
+
+    // Bump whenever a build would write different spectra for the same key:
+    // the header or spectrum layout, the resampler or the normalisation. It
+    // is in the file name as well, so builds that differ never share files.
+    constexpr juce::uint32 formatVersion = 2;
+
+    // Backing files not mapped for this long are pruned
+    constexpr int maxUnusedDays = 30;
+
+    struct FileHeader
+    {
+        char magic[8];
+        juce::uint32 formatVersion;
+        juce::uint64 contentHash;
+        double sampleRate;
+        juce::int32 partitionSize, numPartitions, numChannels;
+    };
+
+    static_assert(sizeof(FileHeader) <= headerSize, "Cache header doesn't fit");
+
+    size_t getNumSpectraFloats(int partitionSize, int numPartitions, int numChannels)
+    {
+        return (size_t)numChannels * (size_t)numPartitions
+             * (size_t)PartitionedConvolver::getSpectrumSize(partitionSize);
+    }
+
+    // 64-bit FNV-1a over the file contents
+    juce::uint64 hashFileContents(const juce::File& file)
+    {
+        juce::FileInputStream in(file);
+
+        if (!in.openedOk())
+            return 0;
+
+        juce::uint64 hash = 0xcbf29ce484222325ull;
+        juce::HeapBlock<juce::uint8> chunk(65536);
+
+        for (;;)
+        {
+            const int numRead = in.read(chunk, 65536);
+
+            if (numRead <= 0)
+                break;
+
+            for (int i = 0; i < numRead; ++i)
+                hash = (hash ^ chunk[i]) * 0x100000001b3ull;
+        }
+
+        // Zero means "unreadable" to the callers
+        return hash != 0 ? hash : 1;
+    }
+
+    // Band-limited windowed-sinc resampler for whole impulse responses.
+    // ratio = input rate / output rate; the cutoff drops below Nyquist when
+    // downsampling so nothing aliases into the tail.
+    void resampleImpulse(const float* input, int numInput, double ratio, float* output, int numOutput)
+    {
+        constexpr int halfTaps = 32;
+        constexpr int tableResolution = 256;
+
+        // Blackman-windowed sinc, tabulated over |x| in [0, halfTaps]
+        std::vector<double> table((size_t)(halfTaps * tableResolution + 2), 0.0);
+
+        for (size_t i = 0; i < table.size(); ++i)
+        {
+            const double x = (double)i / tableResolution;
+
+            if (x >= halfTaps)
+                break;
+
+            const double px = juce::MathConstants<double>::pi * x;
+            const double sinc = i == 0 ? 1.0 : std::sin(px) / px;
+            const double w = 0.5 + 0.5 * x / halfTaps;
+
+            table[i] = sinc * (0.42 - 0.5 * std::cos(juce::MathConstants<double>::twoPi * w)
+                                    + 0.08 * std::cos(2.0 * juce::MathConstants<double>::twoPi * w));
+        }
+
+        const double cutoff = juce::jmin(1.0, 1.0 / ratio);
+        const double halfWidth = halfTaps / cutoff;
+
+        for (int n = 0; n < numOutput; ++n)
+        {
+            const double t = n * ratio;
+            const int first = juce::jmax(0, (int)std::ceil(t - halfWidth));
+            const int last = juce::jmin(numInput - 1, (int)std::floor(t + halfWidth));
+
+            double sum = 0.0;
+
+            for (int k = first; k <= last; ++k)
+            {
+                const double pos = std::abs(t - k) * cutoff * tableResolution;
+                const int idx = (int)pos;
+                const double frac = pos - idx;
+
+                sum += input[k] * (table[(size_t)idx] + frac * (table[(size_t)idx + 1] - table[(size_t)idx]));
+            }
+
+            output[n] = (float)(sum * cutoff);
+        }
+    }
+}
+
+//==============================================================================
+ImpulseResponseCache::ImpulseResponseCache()
+    : directory(juce::File::getSpecialLocation(juce::File::tempDirectory)
+                    .getChildFile("LusionSmartReverb IR Cache"))
+{
+    pruneBackingFiles();
+}
+
+ImpulseResponseCache::~ImpulseResponseCache()
+{
+    const juce::ScopedLock sl(lock);
+    entries.clear();
+}
+
+ImpulseResponseCache::Entry::Ptr ImpulseResponseCache::getOrCreate(const juce::File& file, double sampleRate,
+                                                                   int partitionSize,
+                                                                   juce::AudioFormatManager& formatManager)
+{
+    const auto contentHash = getContentHash(file);
+
+    if (contentHash == 0 || sampleRate <= 0.0 || partitionSize <= 0)
+        return nullptr;
+
+    const Key key{ contentHash, sampleRate, partitionSize };
+    Entry::Ptr entry;
+
+    {
+        const juce::ScopedLock sl(lock);
+
+        for (auto* e : entries)
+        {
+            if (e->getKey() == key)
+            {
+                entry = e;
+                break;
+            }
+        }
+
+        if (entry == nullptr)
+        {
+            entry = new Entry(key);
+            entries.add(entry);
+        }
+    }
+
+    // Whoever gets here first builds; everybody else waits and shares the result
+    const juce::ScopedLock bl(entry->buildLock);
+
+    if (!entry->ready && !entry->failed)
+    {
+        if (build(*entry, file, formatManager))
+            entry->ready = true;
+        else if (!juce::Thread::currentThreadShouldExit())
+            entry->failed = true;
+    }
+
+    return entry->ready ? entry : nullptr;
+}
+
+void ImpulseResponseCache::purgeUnused()
+{
+    const juce::ScopedLock sl(lock);
+
+    // New references are only handed out under the lock, so an entry that only
+    // the cache holds right now can't be picked up while it is removed
+    for (int i = entries.size(); --i >= 0;)
+        if (entries.getObjectPointerUnchecked(i)->getReferenceCount() == 1)
+            entries.remove(i);
+}
+
+//==============================================================================
+juce::uint64 ImpulseResponseCache::getContentHash(const juce::File& file)
+{
+    if (!file.existsAsFile())
+        return 0;
+
+    const auto path = file.getFullPathName();
+    const auto size = file.getSize();
+    const auto modified = file.getLastModificationTime();
+
+    // Re-reading a large IR for every instance would defeat the point, so the
+    // hash is remembered until the file changes on disk
+    {
+        const juce::ScopedLock sl(lock);
+
+        for (const auto& h : hashes)
+            if (h.path == path && h.size == size && h.modified == modified)
+                return h.hash;
+    }
+
+    const auto hash = hashFileContents(file);
+
+    if (hash != 0)
+    {
+        const juce::ScopedLock sl(lock);
+
+        for (auto& h : hashes)
+        {
+            if (h.path == path)
+            {
+                h = { path, size, modified, hash };
+                return hash;
+            }
+        }
+
+        hashes.add({ path, size, modified, hash });
+    }
+
+    return hash;
+}
+
+juce::File ImpulseResponseCache::getBackingFile(const Key& key) const
+{
+    return directory.getChildFile(juce::String::toHexString((juce::int64)key.contentHash)
+                                  + "_" + juce::String(juce::roundToInt(key.sampleRate))
+                                  + "_" + juce::String(key.partitionSize)
+                                  + "_v" + juce::String(formatVersion) + ".irc");
+}
+
+void ImpulseResponseCache::pruneBackingFiles()
+{
+    // Deleting a file another process has mapped only unlinks it, or fails
+    // on Windows; either way that process keeps its pages
+    const auto versionTag = "_v" + juce::String(formatVersion);
+    const auto oldest = juce::Time::getCurrentTime() - juce::RelativeTime::days(maxUnusedDays);
+
+    for (const auto& file : directory.findChildFiles(juce::File::findFiles, false, "*.irc"))
+        if (!file.getFileNameWithoutExtension().contains(versionTag) || file.getLastModificationTime() < oldest)
+            file.deleteFile();
+}
+
+bool ImpulseResponseCache::mapBackingFile(Entry& entry)
+{
+    auto mapping = std::make_unique<juce::MemoryMappedFile>(entry.backingFile, juce::MemoryMappedFile::readOnly);
+
+    if (mapping->getData() == nullptr || mapping->getSize() < headerSize)
+        return false;
+
+    FileHeader header;
+    std::memcpy(&header, mapping->getData(), sizeof(header));
+
+    const auto& key = entry.getKey();
+
+    if (std::memcmp(header.magic, fileMagic, sizeof(fileMagic)) != 0
+        || header.formatVersion != formatVersion
+        || header.contentHash != key.contentHash
+        || header.sampleRate != key.sampleRate
+        || header.partitionSize != key.partitionSize
+        || header.numChannels < 1 || header.numChannels > 2
+        || header.numPartitions < 1)
+        return false;
+
+    const size_t numFloats = getNumSpectraFloats(header.partitionSize, header.numPartitions, header.numChannels);
+
+    if (mapping->getSize() != headerSize + numFloats * sizeof(float))
+        return false;
+
+    const auto* data = reinterpret_cast<const float*>(static_cast<const char*>(mapping->getData()) + headerSize);
+    const size_t channelSize = numFloats / (size_t)header.numChannels;
+
+    entry.numPartitions = header.numPartitions;
+    entry.numChannels = header.numChannels;
+    entry.spectra[0] = data;
+    entry.spectra[1] = data + (header.numChannels > 1 ? channelSize : 0);
+    entry.mapping = std::move(mapping);
+
+    // A file in use stays young enough not to be pruned
+    entry.backingFile.setLastModificationTime(juce::Time::getCurrentTime());
+
+    return true;
+}
+
+bool ImpulseResponseCache::build(Entry& entry, const juce::File& file, juce::AudioFormatManager& formatManager)
+{
+    const auto& key = entry.getKey();
+    const int B = key.partitionSize;
+
+    // Another process (or a sandboxed host's other instances) may already have it
+    entry.backingFile = getBackingFile(key);
+
+    if (entry.backingFile.existsAsFile() && mapBackingFile(entry))
+        return true;
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+
+    if (reader == nullptr || reader->lengthInSamples <= 0 || reader->sampleRate <= 0.0)
+        return false;
+
+    const int numChannels = juce::jlimit(1, 2, (int)reader->numChannels);
+    const int numInput = (int)juce::jmin(reader->lengthInSamples,
+                                         (juce::int64)(ConvolutionReverb::maxImpulseSeconds * reader->sampleRate));
+
+    juce::AudioBuffer<float> raw(numChannels, numInput);
+    reader->read(&raw, 0, numInput, 0, true, numChannels > 1);
+
+    // Resample to the processing rate
+    const double ratio = reader->sampleRate / key.sampleRate;
+    const int numOutput = juce::jmax(1, (int)std::ceil(numInput / ratio));
+
+    juce::AudioBuffer<float> impulse(numChannels, numOutput);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        if (juce::Thread::currentThreadShouldExit())
+            return false;
+
+        if (ratio == 1.0)
+            impulse.copyFrom(ch, 0, raw, ch, 0, numOutput);
+        else
+            resampleImpulse(raw.getReadPointer(ch), numInput, ratio, impulse.getWritePointer(ch), numOutput);
+    }
+
+    // Normalise to unit energy per channel
+    double energy = 0.0;
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int i = 0; i < numOutput; ++i)
+            energy += juce::square((double)impulse.getSample(ch, i));
+
+    energy /= numChannels;
+
+    if (energy > 0.0)
+        impulse.applyGain(impulseGain / (float)std::sqrt(energy));
+
+    // Partition and transform
+    const int numPartitions = (numOutput + B - 1) / B;
+    const int spectrumSize = PartitionedConvolver::getSpectrumSize(B);
+    const size_t numFloats = getNumSpectraFloats(B, numPartitions, numChannels);
+    const size_t channelSize = numFloats / (size_t)numChannels;
+
+    juce::HeapBlock<float> spectra(numFloats, true);
+    juce::HeapBlock<float> work((size_t)(4 * B), true);
+    juce::dsp::FFT fft(juce::roundToInt(std::log2(2 * B)));
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        float* channelSpectra = spectra + ch * channelSize;
+
+        for (int p = 0; p < numPartitions; ++p)
+        {
+            const int start = p * B;
+            const int length = juce::jmin(B, numOutput - start);
+
+            juce::FloatVectorOperations::clear(work.get(), 4 * B);
+            juce::FloatVectorOperations::copy(work.get(), impulse.getReadPointer(ch, start), length);
+
+            fft.performRealOnlyForwardTransform(work, true);
+            PartitionedConvolver::packSpectrum(work, channelSpectra + p * spectrumSize, B);
+        }
+    }
+
+    // Write the backing file and map it back in, so every instance reads the
+    // same clean, shareable pages
+    if (directory.createDirectory())
+    {
+        juce::TemporaryFile temp(entry.backingFile);
+        bool written = false;
+
+        if (auto out = temp.getFile().createOutputStream())
+        {
+            FileHeader header{};
+            std::memcpy(header.magic, fileMagic, sizeof(fileMagic));
+            header.formatVersion = formatVersion;
+            header.contentHash = key.contentHash;
+            header.sampleRate = key.sampleRate;
+            header.partitionSize = B;
+            header.numPartitions = numPartitions;
+            header.numChannels = numChannels;
+
+            char headerBlock[headerSize] = {};
+            std::memcpy(headerBlock, &header, sizeof(header));
+
+            written = out->write(headerBlock, headerSize)
+                   && out->write(spectra.get(), numFloats * sizeof(float));
+
+            out->flush();
+            written = written && out->getStatus().wasOk();
+        }
+
+        if (written && temp.overwriteTargetFileWithTemporary() && mapBackingFile(entry))
+            return true;
+    }
+
+    // No usable temp directory: keep the partitions on the heap instead
+    entry.numPartitions = numPartitions;
+    entry.numChannels = numChannels;
+    entry.fallbackStorage = std::move(spectra);
+    entry.spectra[0] = entry.fallbackStorage.get();
+    entry.spectra[1] = entry.fallbackStorage + (numChannels > 1 ? channelSize : 0);
+
+    return true;
+}
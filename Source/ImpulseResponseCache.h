@@ -0,0 +1,111 @@
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+// Process-wide cache of impulse responses that have already been resampled
+// and transformed into convolution partitions.
+//
+// Entries are keyed by file content hash, sample rate and partition size, so
+// every plugin instance (and every bus loading the same hall) shares a single
+// read-only copy. Partition data lives in a memory-mapped file in the temp
+// directory; it is kept in memory only if the file cannot be written.
+//
+// Backing files are left behind for other processes and later sessions to
+// map, as any of them may still have one mapped. Instead, files from another
+// cache format or unused for a month are pruned when the cache is created.
+//
+// Access it through juce::SharedResourcePointer<ImpulseResponseCache>.
+//==============================================================================
+class ImpulseResponseCache
+{
+public:
+    struct Key
+    {
+        juce::uint64 contentHash = 0;
+        double sampleRate = 0.0;
+        int partitionSize = 0;
+
+        bool operator== (const Key& other) const noexcept
+        {
+            return contentHash == other.contentHash
+                && sampleRate == other.sampleRate
+                && partitionSize == other.partitionSize;
+        }
+    };
+
+    class Entry : public juce::ReferenceCountedObject
+    {
+    public:
+        using Ptr = juce::ReferenceCountedObjectPtr<Entry>;
+
+        explicit Entry(const Key& k) : key(k) {}
+
+        const Key& getKey() const noexcept { return key; }
+
+        int getPartitionSize() const noexcept { return key.partitionSize; }
+        int getNumPartitions() const noexcept { return numPartitions; }
+        int getNumChannels() const noexcept { return numChannels; }
+
+        // numPartitions split spectra for the given channel; mono IRs return
+        // the same data for both channels
+        const float* getSpectra(int channel) const noexcept
+        {
+            return spectra[juce::jmin(channel, numChannels - 1)];
+        }
+
+    private:
+        friend class ImpulseResponseCache;
+
+        const Key key;
+
+        juce::CriticalSection buildLock;
+        bool ready = false, failed = false;
+
+        int numPartitions = 0, numChannels = 0;
+        const float* spectra[2] = {};
+
+        std::unique_ptr<juce::MemoryMappedFile> mapping;
+        juce::File backingFile;
+
+        juce::HeapBlock<float> fallbackStorage;
+
+        JUCE_DECLARE_NON_COPYABLE(Entry)
+    };
+
+    ImpulseResponseCache();
+    ~ImpulseResponseCache();
+
+    // Returns the shared partitions for this file, building them if nobody
+    // has yet. Blocks while another thread builds the same key, so call it
+    // from a background thread. Returns nullptr if the file can't be read or
+    // the calling thread was asked to exit.
+    Entry::Ptr getOrCreate(const juce::File& file, double sampleRate, int partitionSize,
+                           juce::AudioFormatManager& formatManager);
+
+    // Drops entries that no kernel references any more
+    void purgeUnused();
+
+private:
+    struct FileHash
+    {
+        juce::String path;
+        juce::int64 size = 0;
+        juce::Time modified;
+        juce::uint64 hash = 0;
+    };
+
+    juce::uint64 getContentHash(const juce::File& file);
+
+    bool build(Entry& entry, const juce::File& file, juce::AudioFormatManager& formatManager);
+    bool mapBackingFile(Entry& entry);
+    juce::File getBackingFile(const Key& key) const;
+    void pruneBackingFiles();
+
+    juce::CriticalSection lock;
+    juce::ReferenceCountedArray<Entry> entries;
+    juce::Array<FileHash> hashes;
+
+    juce::File directory;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ImpulseResponseCache)
+};
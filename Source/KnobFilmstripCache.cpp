@@ -0,0 +1,39 @@
+#include "KnobFilmstripCache.h"
+
+//==============================================================================
+const juce::Image& KnobFilmstripCache::Filmstrip::getFrame(float proportion, const Renderer& render)
+{
+    const int index = juce::roundToInt(juce::jlimit(0.0f, 1.0f, proportion) * (numFrames - 1));
+    auto& frame = frames[(size_t)index];
+
+    if (frame.isNull())
+    {
+        frame = juce::Image(juce::Image::ARGB,
+            juce::jmax(1, juce::roundToInt(key.width * key.scale)),
+            juce::jmax(1, juce::roundToInt(key.height * key.scale)), true);
+
+        juce::Graphics g(frame);
+        g.addTransform(juce::AffineTransform::scale(key.scale));
+
+        render(g, juce::Rectangle<float>((float)key.width, (float)key.height),
+               (float)index / (float)(numFrames - 1));
+    }
+
+    return frame;
+}
+
+//==============================================================================
+KnobFilmstripCache::Filmstrip::Ptr KnobFilmstripCache::get(const Key& key)
+{
+    // Strips only the cache still references belong to sizes or scales no
+    // knob is showing any more
+    for (int i = filmstrips.size(); --i >= 0;)
+        if (filmstrips.getObjectPointerUnchecked(i)->getReferenceCount() == 1)
+            filmstrips.remove(i);
+
+    for (auto* filmstrip : filmstrips)
+        if (filmstrip->getKey() == key)
+            return filmstrip;
+
+    return filmstrips.add(new Filmstrip(key));
+}
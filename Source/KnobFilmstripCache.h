@@ -0,0 +1,62 @@
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+// Process-wide cache of pre-rendered rotary knob frames.
+//
+// A filmstrip holds numFrames images of one knob design, from the start to
+// the end of its rotation, at one size and display scale. Each frame is
+// rendered the first time it is shown and then only blitted. Every knob of
+// the same size, scale and colours, in every editor, shares one strip; strips
+// nobody holds any more are dropped on the next lookup.
+//
+// Message thread only. Access it through
+// juce::SharedResourcePointer<KnobFilmstripCache>.
+//==============================================================================
+class KnobFilmstripCache
+{
+public:
+    static constexpr int numFrames = 128;
+
+    struct Key
+    {
+        int width = 0, height = 0;          // logical size of the knob
+        float scale = 1.0f;                 // physical pixels per logical pixel
+        std::array<juce::uint32, 4> colours{};
+
+        bool operator== (const Key& other) const noexcept
+        {
+            return width == other.width && height == other.height
+                && scale == other.scale && colours == other.colours;
+        }
+    };
+
+    // Draws the knob into bounds with the given position (0..1)
+    using Renderer = std::function<void(juce::Graphics&, juce::Rectangle<float> bounds, float proportion)>;
+
+    class Filmstrip : public juce::ReferenceCountedObject
+    {
+    public:
+        using Ptr = juce::ReferenceCountedObjectPtr<Filmstrip>;
+
+        explicit Filmstrip(const Key& k) : key(k), frames((size_t)numFrames) {}
+
+        const Key& getKey() const noexcept { return key; }
+
+        // The frame nearest to proportion (0..1), at physical resolution
+        const juce::Image& getFrame(float proportion, const Renderer& render);
+
+    private:
+        const Key key;
+        std::vector<juce::Image> frames;
+
+        JUCE_DECLARE_NON_COPYABLE(Filmstrip)
+    };
+
+    Filmstrip::Ptr get(const Key& key);
+
+    int getNumFilmstrips() const { return filmstrips.size(); }
+
+private:
+    juce::ReferenceCountedArray<Filmstrip> filmstrips;
+};
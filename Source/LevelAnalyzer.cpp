@@ -0,0 +1,260 @@
+#include "LevelAnalyzer.h"
+
+namespace
+{
+    // A one-pole average with half the window as its time constant has the
+    // same noise bandwidth as the rectangular window
+    constexpr double loudnessTimeConstant = LevelAnalyzer::loudnessWindowSeconds * 0.5;
+
+    // BS.1770 channel weights: +1.5 dB for the surrounds, LFE left out
+    float getChannelWeight(juce::AudioChannelSet::ChannelType type)
+    {
+        switch (type)
+        {
+            case juce::AudioChannelSet::LFE:
+            case juce::AudioChannelSet::LFE2:
+                return 0.0f;
+
+            case juce::AudioChannelSet::leftSurround:
+            case juce::AudioChannelSet::rightSurround:
+            case juce::AudioChannelSet::leftSurroundSide:
+            case juce::AudioChannelSet::rightSurroundSide:
+            case juce::AudioChannelSet::leftSurroundRear:
+            case juce::AudioChannelSet::rightSurroundRear:
+                return 1.41f;
+
+            default:
+                return 1.0f;
+        }
+    }
+
+    // One sample through the two sections, in the order the kernels'
+    // leftover loop uses
+    double filterSample(const double (&sections)[2][5], double* s, double x)
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            const double* c = sections[i];
+            const double y = c[0] * x + s[2 * i];
+
+            s[2 * i] = (c[1] * x - c[3] * y) + s[2 * i + 1];
+            s[2 * i + 1] = c[2] * x - c[4] * y;
+            x = y;
+        }
+
+        return x;
+    }
+}
+
+//==============================================================================
+void LevelAnalyzer::prepare(double newSampleRate, const juce::AudioChannelSet& layout, int maxChannels, int maxBlockSize)
+{
+    sampleRate = newSampleRate;
+    numChannelsPrepared = juce::jmax(1, maxChannels);
+    capacity = juce::jmax(1, maxBlockSize);
+
+    filterStates.allocate((size_t)(4 * numChannelsPrepared), true);
+    results.allocate((size_t)(3 * numChannelsPrepared), true);
+    weights.allocate((size_t)numChannelsPrepared, true);
+    scratch.allocate((size_t)(numChannelsPrepared * capacity), true);
+    channels.allocate((size_t)numChannelsPrepared, true);
+
+    for (int ch = 0; ch < numChannelsPrepared; ++ch)
+        weights[ch] = ch < layout.size() ? getChannelWeight(layout.getTypeOfChannel(ch)) : 0.0f;
+
+    levelCoefficient = getCoefficient(capacity, levelWindowSeconds);
+    loudnessCoefficient = getCoefficient(capacity, loudnessTimeConstant);
+
+    designKWeighting();
+    reset();
+}
+
+void LevelAnalyzer::reset()
+{
+    std::fill(filterStates.get(), filterStates.get() + 4 * numChannelsPrepared, 0.0f);
+
+    meanSquare = 0.0f;
+    rmsLevel = 0.0f;
+    peakLevel = 0.0f;
+    loudnessPower = 0.0f;
+    blockPeak = 0.0f;
+}
+
+void LevelAnalyzer::designKWeighting()
+{
+    // The BS.1770 filters for any sample rate, from their analogue prototypes
+    double sections[2][5];
+
+    {
+        constexpr double f0 = 1681.974450955533, gainDb = 3.999843853973347, q = 0.7071752369554196;
+
+        const double k = std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+        const double vh = std::pow(10.0, gainDb / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+
+        sections[0][0] = (vh + vb * k / q + k * k) / a0;
+        sections[0][1] = 2.0 * (k * k - vh) / a0;
+        sections[0][2] = (vh - vb * k / q + k * k) / a0;
+        sections[0][3] = 2.0 * (k * k - 1.0) / a0;
+        sections[0][4] = (1.0 - k / q + k * k) / a0;
+    }
+
+    {
+        constexpr double f0 = 38.13547087602444, q = 0.5003270373238773;
+
+        const double k = std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+        const double a0 = 1.0 + k / q + k * k;
+
+        sections[1][0] = 1.0;
+        sections[1][1] = -2.0;
+        sections[1][2] = 1.0;
+        sections[1][3] = 2.0 * (k * k - 1.0) / a0;
+        sections[1][4] = (1.0 - k / q + k * k) / a0;
+    }
+
+    // The block matrices, column by column: the response over four samples
+    // to each state, then to each input sample, on its own
+    for (int j = 0; j < 4; ++j)
+    {
+        double s[4] = {};
+        s[j] = 1.0;
+
+        for (int i = 0; i < 4; ++i)
+            kWeighting.output[4 * j + i] = (float)filterSample(sections, s, 0.0);
+
+        for (int i = 0; i < 4; ++i)
+            kWeighting.transition[4 * j + i] = (float)s[i];
+    }
+
+    for (int k = 0; k < 4; ++k)
+    {
+        double s[4] = {};
+
+        for (int i = 0; i < 4; ++i)
+            kWeighting.feedthrough[4 * k + i] = (float)filterSample(sections, s, i == k ? 1.0 : 0.0);
+
+        for (int i = 0; i < 4; ++i)
+            kWeighting.input[4 * k + i] = (float)s[i];
+    }
+
+    for (int i = 0; i < 2; ++i)
+        for (int c = 0; c < 5; ++c)
+            kWeighting.sections[i][c] = (float)sections[i][c];
+}
+
+float LevelAnalyzer::getCoefficient(int numSamples, double windowSeconds) const noexcept
+{
+    if (sampleRate <= 0.0)
+        return 1.0f;
+
+    return 1.0f - (float)std::exp(-numSamples / (windowSeconds * sampleRate));
+}
+
+//==============================================================================
+template <typename SampleType>
+void LevelAnalyzer::process(const juce::AudioBuffer<SampleType>& block) noexcept
+{
+    const int numChannels = juce::jmin(block.getNumChannels(), numChannelsPrepared);
+    const int numSamples = block.getNumSamples();
+
+    jassert(numSamples <= capacity);
+    jassert(block.getNumChannels() <= numChannelsPrepared);
+
+    if (numSamples == 0 || numChannels == 0)
+        return;
+
+    // The kernel reads float; double input comes across once, into scratch
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            channels[ch] = block.getReadPointer(ch);
+        }
+        else
+        {
+            float* dest = scratch + ch * capacity;
+            SampleConversion::toFloat(dest, block.getReadPointer(ch), numSamples);
+            channels[ch] = dest;
+        }
+    }
+
+    DspKernels::get().analyse(channels, numChannels, numSamples, kWeighting, filterStates, results);
+
+    float blockPower = 0.0f, blockPeakSum = 0.0f, blockLoudnessPower = 0.0f;
+    blockPeak = 0.0f;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const float* r = results + 3 * ch;
+
+        blockPower += r[0];
+        blockPeakSum += r[1];
+        blockPeak = juce::jmax(blockPeak, r[1]);
+        blockLoudnessPower += weights[ch] * r[2];
+    }
+
+    // Power and peak are channel averages, loudness a weighted sum
+    blockPower /= (float)(numSamples * numChannels);
+    blockPeakSum /= (float)numChannels;
+    blockLoudnessPower /= (float)numSamples;
+
+    // Only the last block of a host buffer can be short
+    const bool isFull = numSamples == capacity;
+    const float coefficient = isFull ? levelCoefficient : getCoefficient(numSamples, levelWindowSeconds);
+    const float loudnessCoeff = isFull ? loudnessCoefficient : getCoefficient(numSamples, loudnessTimeConstant);
+
+    // Mean square and peak share one time constant: the power follows
+    // smoothly, the peak jumps up and falls back at the same rate
+    meanSquare += coefficient * (blockPower - meanSquare);
+    peakLevel = juce::jmax(blockPeakSum, peakLevel * (1.0f - coefficient));
+    rmsLevel = std::sqrt(meanSquare);
+
+    loudnessPower += loudnessCoeff * (blockLoudnessPower - loudnessPower);
+}
+
+template void LevelAnalyzer::process(const juce::AudioBuffer<float>&) noexcept;
+template void LevelAnalyzer::process(const juce::AudioBuffer<double>&) noexcept;
+
+//==============================================================================
+float LevelAnalyzer::getCrestFactor() const noexcept
+{
+    return rmsLevel > 0.0f ? peakLevel / rmsLevel : 0.0f;
+}
+
+float LevelAnalyzer::getLoudness() const noexcept
+{
+    if (loudnessPower <= 0.0f)
+        return loudnessFloor;
+
+    return juce::jmax(loudnessFloor, -0.691f + 10.0f * std::log10(loudnessPower));
+}
+
+double LevelAnalyzer::getSettleSeconds(float attenuationDb) const
+{
+    return attenuationDb / 20.0 * std::log(10.0) * juce::jmax(levelWindowSeconds, loudnessTimeConstant);
+}
+
+void LevelAnalyzer::saveState(juce::OutputStream& out) const
+{
+    SnapshotIO::write(out, numChannelsPrepared);
+    SnapshotIO::writeArray(out, filterStates.get(), (size_t)(4 * numChannelsPrepared));
+
+    SnapshotIO::write(out, meanSquare);
+    SnapshotIO::write(out, rmsLevel);
+    SnapshotIO::write(out, peakLevel);
+    SnapshotIO::write(out, loudnessPower);
+    SnapshotIO::write(out, blockPeak);
+}
+
+bool LevelAnalyzer::restoreState(juce::InputStream& in)
+{
+    int numChannels = 0;
+
+    if (!(SnapshotIO::read(in, numChannels) && numChannels == numChannelsPrepared
+          && SnapshotIO::readArray(in, filterStates.get(), (size_t)(4 * numChannelsPrepared))))
+        return false;
+
+    return SnapshotIO::read(in, meanSquare) && SnapshotIO::read(in, rmsLevel) && SnapshotIO::read(in, peakLevel)
+        && SnapshotIO::read(in, loudnessPower) && SnapshotIO::read(in, blockPeak);
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <JuceHeader.h>
+#include "SnapshotIO.h"
+#include "SampleConversion.h"
+#include "DspKernels.h"
+
+//==============================================================================
+// The input levels behind AUTO and the meters: RMS, peak, crest factor and a
+// short-term loudness estimate.
+//
+// One kernel pass per block reads every input sample once and gives each
+// channel's sum of squares, peak and K-weighted sum of squares (see
+// DspKernels::Table::analyse). The K-weighting is the ITU-R BS.1770 pre-filter
+// and RLB high-pass, run four samples per step in block form; everything
+// carried between blocks is the filter states and a few smoothed values.
+//
+// RMS and peak follow with a 10 ms time constant, as they always have. The
+// loudness follows the channel-weighted K-weighted power with an exponential
+// stand-in for BS.1770's 3 s short-term window, so it needs no history.
+//==============================================================================
+class LevelAnalyzer
+{
+public:
+    static constexpr double levelWindowSeconds = 0.01;
+    static constexpr double loudnessWindowSeconds = 3.0;
+
+    // Loudness reported for silence, in LUFS
+    static constexpr float loudnessFloor = -120.0f;
+
+    // layout (the input bus) gives each channel its BS.1770 weight; channels
+    // beyond it, which carry no input, are left out of the loudness
+    void prepare(double sampleRate, const juce::AudioChannelSet& layout, int maxChannels, int maxBlockSize);
+    void reset();
+
+    // Analyses up to maxBlockSize samples of float or double input
+    template <typename SampleType>
+    void process(const juce::AudioBuffer<SampleType>& block) noexcept;
+
+    float getRmsLevel() const noexcept { return rmsLevel; }
+    float getPeakLevel() const noexcept { return peakLevel; }
+
+    // Smoothed peak over smoothed RMS; 0 for silence
+    float getCrestFactor() const noexcept;
+
+    // Short-term loudness in LUFS
+    float getLoudness() const noexcept;
+
+    // Largest magnitude on any channel in the last block
+    float getBlockPeak() const noexcept { return blockPeak; }
+
+    // Time until a difference in the starting state has shrunk by
+    // attenuationDb
+    double getSettleSeconds(float attenuationDb) const;
+
+    void saveState(juce::OutputStream& out) const;
+    bool restoreState(juce::InputStream& in);
+
+private:
+    void designKWeighting();
+    float getCoefficient(int numSamples, double windowSeconds) const noexcept;
+
+    double sampleRate = 44100.0;
+    int capacity = 0, numChannelsPrepared = 0;
+
+    DspKernels::BlockFilter kWeighting {};
+    float levelCoefficient = 1.0f, loudnessCoefficient = 1.0f;
+
+    juce::HeapBlock<float> filterStates, results, weights, scratch;
+    juce::HeapBlock<const float*> channels;
+
+    float meanSquare = 0.0f;
+    float rmsLevel = 0.0f;
+    float peakLevel = 0.0f;
+    float loudnessPower = 0.0f;
+    float blockPeak = 0.0f;
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+// What the audio thread measured and applied for one control block
+//==============================================================================
+struct MeterFrame
+{
+    int numSamples = 0;
+
+    float rms = 0.0f;       // smoothed input RMS
+    float peak = 0.0f;      // smoothed input peak
+    float duck = 0.0f;      // 0 = no ducking, 1 = fully ducked
+    float wet = 0.0f;       // wet level the engine ran with
+    float decay = 0.0f;     // decay (seconds) the engine ran with
+};
+
+//==============================================================================
+// Wait-free single-producer / single-consumer queue of meter frames.
+//
+// The audio thread pushes one frame per control block and the editor drains
+// everything that has arrived on each UI frame, so no block is missed however
+// the two rates line up. Storage is fixed at construction: push() never
+// allocates or locks, and when nobody is reading (editor closed) it simply
+// drops frames once the queue is full.
+//==============================================================================
+class MeterFifo
+{
+public:
+    // About 350 ms of control blocks at 192 kHz
+    static constexpr int capacity = 2048;
+
+    MeterFifo() : fifo(capacity) {}
+
+    // Audio thread only. Returns false if the frame was dropped.
+    bool push(const MeterFrame& frame) noexcept
+    {
+        const auto scope = fifo.write(1);
+
+        if (scope.blockSize1 == 0)
+            return false;
+
+        frames[(size_t)scope.startIndex1] = frame;
+        return true;
+    }
+
+    // Reader thread only. Calls callback(const MeterFrame&) for each queued
+    // frame, oldest first, and returns how many there were.
+    template <typename Callback>
+    int drain(Callback&& callback)
+    {
+        const auto scope = fifo.read(fifo.getNumReady());
+
+        for (int i = 0; i < scope.blockSize1; ++i)
+            callback(frames[(size_t)(scope.startIndex1 + i)]);
+
+        for (int i = 0; i < scope.blockSize2; ++i)
+            callback(frames[(size_t)(scope.startIndex2 + i)]);
+
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    // Reader thread only: throws away anything queued, e.g. frames that piled
+    // up while no editor was open
+    void discard() { drain([](const MeterFrame&) {}); }
+
+private:
+    juce::AbstractFifo fifo;
+    std::array<MeterFrame, (size_t)capacity> frames;
+
+    JUCE_DECLARE_NON_COPYABLE(MeterFifo)
+};
@@ -0,0 +1,455 @@
+#include "MultichannelBank.h"
+
+namespace
+{
+    // Tunings and gain laws from FreeverbBank, so channels 0 and 1 ring
+    // exactly like its L and R tanks
+    constexpr short combTunings[MultichannelBank::numCombs] = { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 };
+    constexpr short allPassTunings[MultichannelBank::numAllPasses] = { 556, 441, 341, 225 };
+    constexpr int stereoSpread = 23;
+
+    constexpr float fixedGain = 0.015f;
+    constexpr float wetScaleFactor = 3.0f;
+    constexpr float dryScaleFactor = 2.0f;
+    constexpr float roomScaleFactor = 0.28f;
+    constexpr float roomOffset = 0.7f;
+    constexpr float dampingAmount = 0.5f * 0.4f;
+
+    // Calls fn(offsetInChunk, bufferIndex, length) for the one or two
+    // contiguous runs that n samples starting at start cover in a ring of size
+    template <typename Fn>
+    inline void forEachRun(int start, int size, int n, Fn&& fn) noexcept
+    {
+        if (start >= size)
+            start -= size;
+
+        const int first = juce::jmin(n, size - start);
+        fn(0, start, first);
+
+        if (first < n)
+            fn(first, 0, n - first);
+    }
+
+    template <typename Type>
+    inline void undenormalise(Type& x) noexcept
+    {
+       #if JUCE_INTEL
+        x += 0.1f;
+        x -= 0.1f;
+       #else
+        juce::ignoreUnused(x);
+       #endif
+    }
+}
+
+//==============================================================================
+template <typename SampleType, bool isDucked, int... counts>
+auto MultichannelBank::makeKernels(std::integer_sequence<int, counts...>)
+{
+    return std::array<Kernel<SampleType>, sizeof...(counts)> { &MultichannelBank::processChunks<SampleType, counts + 1, isDucked>... };
+}
+
+void MultichannelBank::prepare(double newSampleRate, int, int newNumChannels, int newLfeChannel)
+{
+    jassert(newNumChannels > 0 && newNumChannels <= maxChannels);
+
+    sampleRate = newSampleRate;
+    numChannels = juce::jlimit(1, maxChannels, newNumChannels);
+    lfeChannel = juce::isPositiveAndBelow(newLfeChannel, numChannels) ? newLfeChannel : -1;
+
+    numTanks = 0;
+    for (int ch = 0; ch < numChannels; ++ch)
+        if (ch != lfeChannel)
+            tankChannels[numTanks++] = ch;
+
+    const int numVecs = (numTanks + lanes - 1) / lanes;
+    const int frameWidth = numVecs * lanes;
+
+    using Counts = std::make_integer_sequence<int, maxVecs>;
+    static const auto floatDry = makeKernels<float, false>(Counts());
+    static const auto floatDucked = makeKernels<float, true>(Counts());
+    static const auto doubleDry = makeKernels<double, false>(Counts());
+    static const auto doubleDucked = makeKernels<double, true>(Counts());
+
+    const auto index = (size_t)(numVecs - 1);
+    floatKernels[0] = floatDry[index];
+    floatKernels[1] = floatDucked[index];
+    doubleKernels[0] = doubleDry[index];
+    doubleKernels[1] = doubleDucked[index];
+
+    // Same integer rounding as juce::Reverb::setSampleRate
+    const int intSampleRate = (int)sampleRate;
+    const auto lineLength = [intSampleRate](int tuning)
+        {
+            return juce::jmax(1, (intSampleRate * tuning) / 44100);
+        };
+
+    size_t totalSize = 0;
+    chunkSize = maxChunkSize;
+
+    const auto layout = [&](Delay& d, int tuning)
+        {
+            d.size = lineLength(tuning + (numTanks - 1) * stereoSpread);
+            for (int t = 0; t < numTanks; ++t)
+                d.readOffset[t] = d.size - lineLength(tuning + t * stereoSpread);
+
+            d.pos = 0;
+            totalSize += (size_t)(d.size * frameWidth);
+            chunkSize = juce::jmin(chunkSize, lineLength(tuning));
+        };
+
+    for (int i = 0; i < numCombs; ++i)
+        layout(combs[i], combTunings[i]);
+
+    for (int i = 0; i < numAllPasses; ++i)
+        layout(allPasses[i], allPassTunings[i]);
+
+    delayMemory.calloc(totalSize);
+    delayMemorySize = totalSize;
+
+    float* p = delayMemory.get();
+    for (auto& d : combs)     { d.frames = p; p += d.size * frameWidth; }
+    for (auto& d : allPasses) { d.frames = p; p += d.size * frameWidth; }
+
+    const double smoothTime = 0.01;
+    damping.reset(sampleRate, smoothTime);
+    feedback.reset(sampleRate, smoothTime);
+    dryGain.reset(sampleRate, smoothTime);
+    wetGain1.reset(sampleRate, smoothTime);
+    wetGain2.reset(sampleRate, smoothTime);
+
+    damping.setCurrentAndTargetValue(dampingAmount);
+    feedback.setCurrentAndTargetValue(roomSize * roomScaleFactor + roomOffset);
+    updateMixGains();
+
+    dryGain.setCurrentAndTargetValue(dryGain.getTargetValue());
+    wetGain1.setCurrentAndTargetValue(wetGain1.getTargetValue());
+    wetGain2.setCurrentAndTargetValue(wetGain2.getTargetValue());
+
+    reset();
+}
+
+void MultichannelBank::reset()
+{
+    if (delayMemory != nullptr)
+        juce::FloatVectorOperations::clear(delayMemory.get(), (int)delayMemorySize);
+
+    for (auto& d : combs)     d.pos = 0;
+    for (auto& d : allPasses) d.pos = 0;
+
+    std::fill(std::begin(combLast), std::end(combLast), 0.0f);
+
+    // The padding lanes are never gathered, so give them a defined start
+    std::fill_n(&combTile[0][0], maxChunkSize * numCombs * maxFrameWidth, 0.0f);
+    std::fill_n(&allPassTile[0][0], maxChunkSize * maxFrameWidth, 0.0f);
+}
+
+//==============================================================================
+void MultichannelBank::saveState(juce::OutputStream& out, bool includeBuffers) const
+{
+    SnapshotIO::write(out, wetLevel);
+    SnapshotIO::write(out, roomSize);
+    SnapshotIO::write(out, width);
+
+    for (const auto* s : { &damping, &feedback, &dryGain, &wetGain1, &wetGain2 })
+        SnapshotIO::write(out, *s);
+
+    SnapshotIO::write(out, includeBuffers);
+
+    if (!includeBuffers)
+        return;
+
+    SnapshotIO::write(out, numChannels);
+    SnapshotIO::write(out, delayMemorySize);
+    SnapshotIO::writeArray(out, delayMemory.get(), delayMemorySize);
+
+    for (const auto& d : combs)     SnapshotIO::write(out, d.pos);
+    for (const auto& d : allPasses) SnapshotIO::write(out, d.pos);
+
+    SnapshotIO::writeArray(out, combLast, numCombs * maxFrameWidth);
+}
+
+bool MultichannelBank::restoreState(juce::InputStream& in)
+{
+    bool hasBuffers = false;
+
+    if (!(SnapshotIO::read(in, wetLevel) && SnapshotIO::read(in, roomSize) && SnapshotIO::read(in, width)))
+        return false;
+
+    for (auto* s : { &damping, &feedback, &dryGain, &wetGain1, &wetGain2 })
+        if (!SnapshotIO::read(in, *s))
+            return false;
+
+    if (!SnapshotIO::read(in, hasBuffers))
+        return false;
+
+    if (!hasBuffers)
+    {
+        reset();
+        return true;
+    }
+
+    // Lines are sized by prepare(), so the snapshot must come from the same
+    // rate and channel count
+    int channels = 0;
+    size_t size = 0;
+
+    if (!SnapshotIO::read(in, channels) || channels != numChannels
+        || !SnapshotIO::read(in, size) || size != delayMemorySize
+        || !SnapshotIO::readArray(in, delayMemory.get(), delayMemorySize))
+        return false;
+
+    const auto readPosition = [&in](Delay& d)
+        {
+            return SnapshotIO::read(in, d.pos) && d.pos >= 0 && d.pos < d.size;
+        };
+
+    for (auto& d : combs)
+        if (!readPosition(d))
+            return false;
+
+    for (auto& d : allPasses)
+        if (!readPosition(d))
+            return false;
+
+    return SnapshotIO::readArray(in, combLast, numCombs * maxFrameWidth);
+}
+
+//==============================================================================
+void MultichannelBank::setWet(float value)
+{
+    wetLevel = juce::jlimit(0.0f, 1.0f, value);
+    updateMixGains();
+}
+
+void MultichannelBank::setDecay(float seconds)
+{
+    // Map 0.1 – 6.0 seconds → roomSize (0–1)
+    roomSize = juce::jlimit(0.05f, 1.0f, seconds / 6.0f);
+    feedback.setTargetValue(roomSize * roomScaleFactor + roomOffset);
+}
+
+void MultichannelBank::setWidth(float value)
+{
+    width = juce::jlimit(0.0f, 1.0f, value);
+    updateMixGains();
+}
+
+double MultichannelBank::getTailSeconds(float decaySeconds, float attenuationDb) const
+{
+    // As FreeverbBank: the longest comb at the undamped feedback rings the longest
+    const float room = juce::jlimit(0.05f, 1.0f, decaySeconds / 6.0f);
+    const double lossPerTripDb = -20.0 * std::log10((double)(room * roomScaleFactor + roomOffset));
+
+    int longestComb = 0, allPassDelay = 0;
+    for (const auto& d : combs)
+        longestComb = juce::jmax(longestComb, d.size);
+    for (const auto& d : allPasses)
+        allPassDelay += d.size;
+
+    return (attenuationDb / lossPerTripDb * longestComb + allPassDelay) / sampleRate;
+}
+
+double MultichannelBank::getLongestPathSeconds() const
+{
+    int longestComb = 0, allPassDelay = 0;
+    for (const auto& d : combs)
+        longestComb = juce::jmax(longestComb, d.size);
+    for (const auto& d : allPasses)
+        allPassDelay += d.size;
+
+    return (longestComb + allPassDelay) / sampleRate;
+}
+
+void MultichannelBank::setDryEnabled(bool enabled)
+{
+    dryEnabled = enabled;
+    updateMixGains();
+    dryGain.setCurrentAndTargetValue(dryGain.getTargetValue());
+}
+
+void MultichannelBank::updateMixGains()
+{
+    // WIDTH blends each channel's own tank with the mean of all of them; with
+    // two tanks this is exactly FreeverbBank's wet1/wet2 cross-mix
+    const float wet = wetLevel * wetScaleFactor;
+
+    dryGain.setTargetValue(dryEnabled ? (1.0f - wetLevel) * dryScaleFactor : 0.0f);
+    wetGain1.setTargetValue(wet * width);
+    wetGain2.setTargetValue(numTanks > 0 ? wet * (1.0f - width) / (float)numTanks : 0.0f);
+}
+
+//==============================================================================
+template <typename SampleType, int numVecs, bool isDucked>
+void MultichannelBank::processChunks(SampleType* const* channels, int numSamples, const float* wetScale) noexcept
+{
+    constexpr int frameWidth = numVecs * lanes;
+
+    const auto& kernels = DspKernels::get();
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        const int n = juce::jmin(chunkSize, numSamples - start);
+        const float* duck = isDucked ? wetScale + start : nullptr;
+
+        // Every tank hears the same mix of all non-LFE channels, as both
+        // FreeverbBank tanks hear L + R
+        std::fill_n(inputs, n, 0.0f);
+
+        for (int t = 0; t < numTanks; ++t)
+        {
+            const SampleType* x = channels[tankChannels[t]] + start;
+            for (int i = 0; i < n; ++i)
+                inputs[i] += (float)x[i];
+        }
+
+        // Every tap of this chunk was written before the chunk started (n never
+        // exceeds the shortest line), so each lane's reads are contiguous runs,
+        // gathered into lane-major tiles for the SIMD update
+        for (int j = 0; j < numCombs; ++j)
+        {
+            const auto& c = combs[j];
+
+            for (int t = 0; t < numTanks; ++t)
+            {
+                const float* src = c.frames + t;
+                const int lane = j * frameWidth + t;
+
+                forEachRun(c.pos + c.readOffset[t], c.size, n, [&](int offset, int idx, int length)
+                    {
+                        for (int i = 0; i < length; ++i)
+                            combTile[offset + i][lane] = src[frameWidth * (idx + i)];
+                    });
+            }
+        }
+
+        for (int i = 0; i < n; ++i)
+        {
+            inputs[i] *= fixedGain;
+            dampings[i] = damping.getNextValue();
+            feedbacks[i] = feedback.getNextValue();
+
+            // The combs output what they read, before the update below
+            Vec sums[numVecs];
+            for (auto& s : sums)
+                s = Vec::expand(0.0f);
+
+            for (int j = 0; j < numCombs; ++j)
+                for (int v = 0; v < numVecs; ++v)
+                    sums[v] += Vec::fromRawArray(combTile[i] + j * frameWidth + v * lanes);
+
+            for (int v = 0; v < numVecs; ++v)
+                sums[v].copyToRawArray(wetTile[i] + v * lanes);
+        }
+
+        kernels.combSteps(combTile[0], numCombs * maxFrameWidth, n, numCombs * frameWidth,
+                          combLast, dampings, feedbacks, inputs);
+
+        // All lanes write at the same position, so the write-back is whole frames
+        for (int j = 0; j < numCombs; ++j)
+        {
+            auto& c = combs[j];
+
+            forEachRun(c.pos, c.size, n, [&](int offset, int idx, int length)
+                {
+                    for (int i = 0; i < length; ++i)
+                        std::copy_n(combTile[offset + i] + j * frameWidth, frameWidth, c.frames + frameWidth * (idx + i));
+                });
+
+            c.advance(n);
+        }
+
+        // Allpasses have no recursion shorter than their length either, so
+        // each stage runs over the whole chunk before the next one
+        for (auto& a : allPasses)
+        {
+            for (int t = 0; t < numTanks; ++t)
+            {
+                const float* src = a.frames + t;
+
+                forEachRun(a.pos + a.readOffset[t], a.size, n, [&](int offset, int idx, int length)
+                    {
+                        for (int i = 0; i < length; ++i)
+                            allPassTile[offset + i][t] = src[frameWidth * (idx + i)];
+                    });
+            }
+
+            const auto half = Vec::expand(0.5f);
+
+            for (int i = 0; i < n; ++i)
+            {
+                for (int v = 0; v < numVecs; ++v)
+                {
+                    const auto io = Vec::fromRawArray(wetTile[i] + v * lanes);
+                    const auto delayed = Vec::fromRawArray(allPassTile[i] + v * lanes);
+
+                    auto temp = io + delayed * half;
+                    undenormalise(temp);
+
+                    (delayed - io).copyToRawArray(wetTile[i] + v * lanes);
+                    temp.copyToRawArray(allPassTile[i] + v * lanes);
+                }
+            }
+
+            forEachRun(a.pos, a.size, n, [&](int offset, int idx, int length)
+                {
+                    for (int i = 0; i < length; ++i)
+                        std::copy_n(allPassTile[offset + i], frameWidth, a.frames + frameWidth * (idx + i));
+                });
+
+            a.advance(n);
+        }
+
+        for (int i = 0; i < n; ++i)
+        {
+            const float scale = isDucked ? duck[i] : 1.0f;
+
+            dryGains[i] = dryGain.getNextValue();
+            ownGains[i] = wetGain1.getNextValue() * scale;
+            sharedGains[i] = wetGain2.getNextValue() * scale;
+
+            float sum = 0.0f;
+            for (int t = 0; t < numTanks; ++t)
+                sum += wetTile[i][t];
+
+            wetSums[i] = sum * sharedGains[i];
+        }
+
+        for (int t = 0; t < numTanks; ++t)
+        {
+            SampleType* x = channels[tankChannels[t]] + start;
+
+            // The dry signal keeps the host's precision
+            for (int i = 0; i < n; ++i)
+                x[i] = (SampleType)(wetTile[i][t] * ownGains[i] + wetSums[i]) + x[i] * dryGains[i];
+        }
+
+        if (lfeChannel >= 0)
+        {
+            SampleType* x = channels[lfeChannel] + start;
+
+            for (int i = 0; i < n; ++i)
+                x[i] *= dryGains[i];
+        }
+    }
+}
+
+template <typename SampleType>
+void MultichannelBank::process(SampleType* const* channels, int numSamples, const float* wetScale) noexcept
+{
+    const int ducked = wetScale != nullptr ? 1 : 0;
+
+    if constexpr (std::is_same_v<SampleType, float>)
+    {
+        jassert(floatKernels[ducked] != nullptr);
+        (this->*floatKernels[ducked])(channels, numSamples, wetScale);
+    }
+    else
+    {
+        jassert(doubleKernels[ducked] != nullptr);
+        (this->*doubleKernels[ducked])(channels, numSamples, wetScale);
+    }
+}
+
+template void MultichannelBank::process(float* const*, int, const float*) noexcept;
+template void MultichannelBank::process(double* const*, int, const float*) noexcept;
@@ -0,0 +1,127 @@
+#pragma once
+#include <JuceHeader.h>
+#include "SnapshotIO.h"
+#include "DspKernels.h"
+
+//==============================================================================
+// Freeverb comb/allpass tanks for surround buses, one per channel.
+//
+// Channel c's lines are stretched by c times Freeverb's stereo spread, so
+// every tank rings differently and the tails stay decorrelated, the way the
+// R tank differs from the L one in FreeverbBank.
+//
+// Channels are the SIMD lanes. Each comb and allpass keeps one buffer of
+// frames holding all channels side by side: every channel writes at the same
+// position and reads its own distance behind it, so only the reads have to be
+// gathered, a chunk at a time, and everything else is whole registers. The
+// kernel is compiled for each register count and picked in prepare(), so 5.1
+// runs two SSE registers per filter and 7.1.4 three. Each count also comes
+// with and without ducking, chosen per call. The comb update treats all
+// combs' lanes as one row for DspKernels::combSteps, so wider instruction
+// sets cover several combs per register.
+//
+// The LFE channel, if there is one, gets no tank, only the dry gain.
+//==============================================================================
+class MultichannelBank
+{
+public:
+    static constexpr int maxChannels = 12;  // 7.1.4
+    static constexpr int numCombs = 8;
+    static constexpr int numAllPasses = 4;
+
+    // lfeChannel is the LFE's index within the buffer, or -1
+    void prepare(double sampleRate, int samplesPerBlock, int numChannels, int lfeChannel);
+    void reset();
+
+    void setWet(float value);
+    void setDecay(float seconds);
+    void setWidth(float value);
+
+    // With the dry signal off the tanks output only their wet mix; eco mode
+    // adds the dry back itself at the host rate. Takes effect immediately.
+    void setDryEnabled(bool enabled);
+
+    // Seconds until the tanks have decayed by attenuationDb at the given DECAY
+    double getTailSeconds(float decaySeconds, float attenuationDb) const;
+
+    // Longest a sample can circulate before any of it reaches the output,
+    // in the tank with the longest lines
+    double getLongestPathSeconds() const;
+
+    // Exact state snapshot. Without buffers only the parameters and
+    // smoothers are kept, and restoring clears the lines as reset() does.
+    void saveState(juce::OutputStream& out, bool includeBuffers) const;
+    bool restoreState(juce::InputStream& in);
+
+    // channels holds the numChannels passed to prepare(), as float or
+    // double; the tanks run in float either way. wetScale, if given, holds
+    // a gain per sample for the wet signal (ducking).
+    template <typename SampleType>
+    void process(SampleType* const* channels, int numSamples, const float* wetScale = nullptr) noexcept;
+
+private:
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr int lanes = (int)Vec::SIMDNumElements;
+    static constexpr int maxVecs = (maxChannels + lanes - 1) / lanes;
+    static constexpr int maxFrameWidth = maxVecs * lanes;
+
+    struct Delay
+    {
+        float* frames = nullptr;
+        int size = 0;                       // longest tank's line, in frames
+        int readOffset[maxChannels] = {};   // size minus each tank's length
+        int pos = 0;
+
+        void advance(int numFrames) noexcept
+        {
+            pos += numFrames;
+            if (pos >= size)
+                pos -= size;
+        }
+    };
+
+    template <typename SampleType, int numVecs, bool isDucked>
+    void processChunks(SampleType* const* channels, int numSamples, const float* wetScale) noexcept;
+
+    template <typename SampleType>
+    using Kernel = void (MultichannelBank::*)(SampleType* const*, int, const float*) noexcept;
+
+    template <typename SampleType, bool isDucked, int... counts>
+    static auto makeKernels(std::integer_sequence<int, counts...>);
+
+    // One pair of kernels per host sample type: [0] without ducking, [1] with
+    Kernel<float> floatKernels[2] = {};
+    Kernel<double> doubleKernels[2] = {};
+
+    void updateMixGains();
+
+    double sampleRate = 44100.0;
+    float wetLevel = 0.3f, roomSize = 0.5f, width = 1.0f;
+    bool dryEnabled = true;
+
+    int numChannels = 0, numTanks = 0, lfeChannel = -1;
+    int tankChannels[maxChannels] = {};     // buffer channel of each lane
+
+    juce::HeapBlock<float> delayMemory;
+    size_t delayMemorySize = 0;
+
+    Delay combs[numCombs];
+    Delay allPasses[numAllPasses];
+
+    // Each comb's damping state, frameWidth lanes per comb, combs side by side
+    alignas(Vec::SIMDRegisterSize) float combLast[numCombs * maxFrameWidth];
+
+    static constexpr int maxChunkSize = 32;
+    int chunkSize = maxChunkSize;
+
+    // Lane-major working copies of one chunk. Lanes past numTanks are
+    // padding: they run along with the rest and are never read back.
+    alignas(Vec::SIMDRegisterSize) float combTile[maxChunkSize][numCombs * maxFrameWidth];
+    alignas(Vec::SIMDRegisterSize) float wetTile[maxChunkSize][maxFrameWidth];
+    alignas(Vec::SIMDRegisterSize) float allPassTile[maxChunkSize][maxFrameWidth];
+
+    float inputs[maxChunkSize], wetSums[maxChunkSize], dampings[maxChunkSize], feedbacks[maxChunkSize];
+    float dryGains[maxChunkSize], ownGains[maxChunkSize], sharedGains[maxChunkSize];
+
+    juce::SmoothedValue<float> damping, feedback, dryGain, wetGain1, wetGain2;
+};
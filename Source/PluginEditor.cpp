@@ -22,7 +22,55 @@ namespace Colors
 //==============================================================================
 void ModernRotarySlider::paint(juce::Graphics& g)
 {
-    auto bounds = getLocalBounds().toFloat();
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    // Picked up lazily, so a resize or a move to another screen just costs
+    // a lookup (and the first draw of each frame if nobody had this size)
+    if (filmstrip == nullptr || filmstrip->getKey().scale != scale)
+    {
+        KnobFilmstripCache::Key key;
+        key.width = getWidth();
+        key.height = getHeight();
+        key.scale = scale;
+        key.colours = { Colors::panel.getARGB(), Colors::panelLight.getARGB(),
+                        Colors::accent.getARGB(), Colors::accentDim.getARGB() };
+
+        filmstrip = filmstripCache->get(key);
+    }
+
+    const auto sliderPos = (float)valueToProportionOfLength(getValue());
+    g.drawImage(filmstrip->getFrame(sliderPos, drawKnob), getLocalBounds().toFloat());
+
+    // Draw value text, laid out again only when the shown digits change
+    {
+        const int shownValue = juce::roundToInt(getValue() * 100.0);
+
+        if (shownValue != glyphValue)
+        {
+            glyphValue = shownValue;
+
+            auto center = getLocalBounds().toFloat().getCentre();
+            auto textBounds = juce::Rectangle<float>(center.x - 30, center.y - 10, 60, 20);
+
+            valueGlyphs.clear();
+            valueGlyphs.addFittedText(valueFont, juce::String(getValue(), 2),
+                textBounds.getX(), textBounds.getY(), textBounds.getWidth(), textBounds.getHeight(),
+                juce::Justification::centred, 1);
+        }
+
+        g.setColour(Colors::text);
+        valueGlyphs.draw(g);
+    }
+}
+
+void ModernRotarySlider::resized()
+{
+    filmstrip = nullptr;
+    glyphValue = std::numeric_limits<int>::min();
+}
+
+void ModernRotarySlider::drawKnob(juce::Graphics& g, juce::Rectangle<float> bounds, float sliderPos)
+{
     auto center = bounds.getCentre();
 
     // Calculate dimensions
@@ -32,7 +80,6 @@ void ModernRotarySlider::paint(juce::Graphics& g)
     float knobRadius = radius - trackWidth - 4.0f;
 
     // Get rotation angle
-    auto sliderPos = (float)valueToProportionOfLength(getValue());
     float startAngle = juce::MathConstants<float>::pi * 1.25f;
     float endAngle = juce::MathConstants<float>::pi * 2.75f;
     float currentAngle = startAngle + sliderPos * (endAngle - startAngle);
@@ -92,16 +139,6 @@ void ModernRotarySlider::paint(juce::Graphics& g)
         // Dot at end
         g.fillEllipse(indicatorX - 3.5f, indicatorY - 3.5f, 7.0f, 7.0f);
     }
-
-    // Draw value text
-    {
-        g.setColour(Colors::text);
-        g.setFont(juce::Font(16.0f, juce::Font::bold));
-
-        juce::String valueText = juce::String(getValue(), 2);
-        auto textBounds = juce::Rectangle<float>(center.x - 30, center.y - 10, 60, 20);
-        g.drawText(valueText, textBounds, juce::Justification::centred);
-    }
 }
 
 //==============================================================================
@@ -153,6 +190,17 @@ LusionSmartReverbAudioProcessorEditor::LusionSmartReverbAudioProcessorEditor(
     // Initialize waveform data
     waveformData.resize(200, 0.0f);
 
+    // Sized once for the frame loop to refill
+    waveformPath.preallocateSpace(3 * (int)waveformData.size() + 8);
+    spectrumInputPath.preallocateSpace(3 * SpectrumAnalyzer::numBands + 16);
+    spectrumOutputPath.preallocateSpace(3 * SpectrumAnalyzer::numBands + 8);
+
+    // Whatever queued up while no editor was open is stale
+    processor.getMeterFifo().discard();
+
+    // Spectra are only computed while an editor is showing them
+    processor.getSpectrumAnalyzer().start();
+
     // Setup sliders
     wetSlider.setLabel("WET");
     decaySlider.setLabel("DECAY");
@@ -193,6 +241,7 @@ LusionSmartReverbAudioProcessorEditor::LusionSmartReverbAudioProcessorEditor(
     modeSelector.addItem("SHORT REVERB", 1);
     modeSelector.addItem("LONG REVERB", 2);
     modeSelector.addItem("TAIL MODE", 3);
+    modeSelector.addItem("CONVOLUTION", 4);
     modeSelector.setSelectedId(2);
 
     modeSelector.setColour(juce::ComboBox::backgroundColourId, Colors::panelLight);
@@ -202,56 +251,268 @@ LusionSmartReverbAudioProcessorEditor::LusionSmartReverbAudioProcessorEditor(
 
     addAndMakeVisible(modeSelector);
 
+    // Setup engine selector (A/B between the reverb cores)
+    engineSelector.addItem("CLASSIC ENGINE", 1);
+    engineSelector.addItem("FDN ENGINE", 2);
+    engineSelector.setSelectedId(1);
+
+    engineSelector.setColour(juce::ComboBox::backgroundColourId, Colors::panelLight);
+    engineSelector.setColour(juce::ComboBox::outlineColourId, Colors::textVeryDim);
+    engineSelector.setColour(juce::ComboBox::textColourId, Colors::text);
+    engineSelector.setColour(juce::ComboBox::arrowColourId, Colors::accent);
+
+    addAndMakeVisible(engineSelector);
+
+    // Setup IR loader
+    loadIRButton.setColour(juce::TextButton::buttonColourId, Colors::panelLight);
+    loadIRButton.setColour(juce::TextButton::textColourOffId, Colors::text);
+    loadIRButton.setTooltip(processor.getImpulseResponseFile().getFileName());
+    loadIRButton.onClick = [this]
+        {
+            irChooser = std::make_unique<juce::FileChooser>(
+                "Load Impulse Response", processor.getImpulseResponseFile(), "*.wav;*.aif;*.aiff");
+
+            irChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                [this](const juce::FileChooser& chooser)
+                {
+                    const auto file = chooser.getResult();
+                    if (file.existsAsFile())
+                    {
+                        processor.loadImpulseResponse(file);
+                        loadIRButton.setTooltip(file.getFileName());
+                    }
+                });
+        };
+
+    addAndMakeVisible(loadIRButton);
+
     // Create attachments
     wetAttachment = std::make_unique<SA>(p.apvts, "WET", wetSlider);
     decayAttachment = std::make_unique<SA>(p.apvts, "DECAY", decaySlider);
     widthAttachment = std::make_unique<SA>(p.apvts, "WIDTH", widthSlider);
     autoAttachment = std::make_unique<BA>(p.apvts, "AUTO", autoButton);
     modeAttachment = std::make_unique<CA>(p.apvts, "MODE", modeSelector);
+    engineAttachment = std::make_unique<CA>(p.apvts, "ENGINE", engineSelector);
 
     // Start timer for animation
-    startTimerHz(60);
+    startTimerHz(activeFrameRate);
 }
 
 LusionSmartReverbAudioProcessorEditor::~LusionSmartReverbAudioProcessorEditor()
 {
     stopTimer();
+    processor.getSpectrumAnalyzer().stop();
 }
 
 //==============================================================================
 void LusionSmartReverbAudioProcessorEditor::timerCallback()
 {
+    // Minimised, on a hidden tab or scrolled away: keep the meter queue
+    // flowing but draw nothing, and pause the spectrum analysis
+    if (!isShowing())
+    {
+        processor.getMeterFifo().discard();
+        processor.getSpectrumAnalyzer().stop();
+        updateFrameRate(false);
+        return;
+    }
+
+    processor.getSpectrumAnalyzer().start();
+
+    if (getStaticLayerKey() != staticLayerKey)
+        repaint();
+
+    {
+        // Steady state makes no heap allocations; only new label text may
+        AllocationCounter::ScopedCheck noAllocations;
+
+        if (updateFrame())
+            noAllocations.allow();
+    }
+
+    updateFrameRate(frameMoved);
+}
+
+bool LusionSmartReverbAudioProcessorEditor::updateFrame()
+{
+    waveformMoved = false;
+    drainMeterFrames();
+
+    bool moving = waveformMoved;
+
+    SpectrumAnalyzer::Spectrum latest;
+
+    if (processor.getSpectrumAnalyzer().pullSpectrum(latest)
+        && (latest.input != spectrum.input || latest.output != spectrum.output))
+    {
+        spectrum = latest;
+        moving = true;
+    }
+
     // Smooth visual parameters
-    float targetRms = processor.getRmsLevel() * 2.5f;
-    float targetDuck = processor.getDuckAmount();
+    const auto smooth = [&moving](float& value, float target, float amount)
+        {
+            const float step = (target - value) * amount;
+            value += step;
 
-    rmsSmoothed += (targetRms - rmsSmoothed) * 0.15f;
-    duckSmoothed += (targetDuck - duckSmoothed) * 0.1f;
+            // Well under a pixel on the meters
+            if (std::abs(step) > 0.001f)
+                moving = true;
+        };
 
-    // Update waveform
-    waveformData[waveformIndex] = rmsSmoothed;
-    waveformIndex = (waveformIndex + 1) % waveformData.size();
+    smooth(rmsSmoothed, targetRms * 2.5f, 0.15f);
+    smooth(peakSmoothed, targetPeak * 2.5f, 0.15f);
+    smooth(duckSmoothed, targetDuck, 0.1f);
 
-    // Animation
-    animationPhase += 0.02f;
-    if (animationPhase > juce::MathConstants<float>::twoPi)
-        animationPhase -= juce::MathConstants<float>::twoPi;
+    if (moving)
+    {
+        repaint(vizArea);
+        repaint(meterArea);
+    }
 
-    // Update value labels
-    valueLabels[0].setText(juce::String(wetSlider.getValue(), 2), juce::dontSendNotification);
-    valueLabels[1].setText(juce::String(decaySlider.getValue(), 2) + "s", juce::dontSendNotification);
-    valueLabels[2].setText(juce::String(widthSlider.getValue(), 2), juce::dontSendNotification);
+    frameMoved = moving;
 
-    repaint();
+    return updateValueLabels();
+}
+
+bool LusionSmartReverbAudioProcessorEditor::updateValueLabels()
+{
+    // Show what the engine is really running, which with AUTO on isn't what
+    // the knobs say
+    const double values[3] = {
+        hasAppliedValues ? appliedWet : wetSlider.getValue(),
+        hasAppliedValues ? appliedDecay : decaySlider.getValue(),
+        widthSlider.getValue()
+    };
+
+    bool changed = false;
+
+    // Only reformat when the two shown decimals change
+    for (int i = 0; i < 3; ++i)
+    {
+        const int shownValue = juce::roundToInt(values[i] * 100.0);
+
+        if (shownValue == shownValues[i])
+            continue;
+
+        shownValues[i] = shownValue;
+        valueLabels[i].setText(juce::String(values[i], 2) + (i == 1 ? "s" : ""), juce::dontSendNotification);
+        changed = true;
+    }
+
+    return changed;
+}
+
+void LusionSmartReverbAudioProcessorEditor::updateFrameRate(bool moving)
+{
+    // Drop to a slow poll after half a second of nothing changing; the first
+    // frame that moves brings the full rate back
+    stillFrames = moving ? 0 : stillFrames + 1;
+
+    const int rate = !isShowing() ? hiddenFrameRate
+                   : stillFrames < activeFrameRate / 2 ? activeFrameRate
+                   : idleFrameRate;
+
+    if (getTimerInterval() != 1000 / rate)
+        startTimerHz(rate);
+}
+
+//==============================================================================
+void LusionSmartReverbAudioProcessorEditor::drainMeterFrames()
+{
+    float maxRms = 0.0f, maxPeak = 0.0f, maxDuck = 0.0f;
+
+    const int numFrames = processor.getMeterFifo().drain([&](const MeterFrame& frame)
+        {
+            maxRms = juce::jmax(maxRms, frame.rms);
+            maxPeak = juce::jmax(maxPeak, frame.peak);
+            maxDuck = juce::jmax(maxDuck, frame.duck);
+
+            appliedWet = frame.wet;
+            appliedDecay = frame.decay;
+
+            addToWaveform(frame);
+        });
+
+    // Nothing new (transport stopped or the host isn't calling us): hold the
+    // meters where they are and let the smoothing settle on them
+    if (numFrames == 0)
+        return;
+
+    // The loudest block since the last UI frame, so short hits still show
+    targetRms = maxRms;
+    targetPeak = maxPeak;
+    targetDuck = maxDuck;
+    hasAppliedValues = true;
+}
+
+void LusionSmartReverbAudioProcessorEditor::addToWaveform(const MeterFrame& frame)
+{
+    // A column covers one 60 Hz frame's worth of audio, so the 200 points
+    // span the same few seconds as before at any block size or sample rate
+    const double samplesPerColumn = juce::jmax(1.0, processor.getSampleRate() / 60.0);
+
+    const float level = juce::jmin(1.0f, frame.rms * 2.5f);
+
+    columnLevel = juce::jmax(columnLevel, level);
+    columnSamples += frame.numSamples;
+
+    while (columnSamples >= samplesPerColumn)
+    {
+        // Scrolling silence over silence changes nothing on screen
+        if (columnLevel > 0.0f || waveformData[(size_t)waveformIndex] > 0.0f)
+            waveformMoved = true;
+
+        waveformData[(size_t)waveformIndex] = columnLevel;
+        waveformIndex = (waveformIndex + 1) % (int)waveformData.size();
+
+        // Whatever is left over is still this block's audio
+        columnSamples -= samplesPerColumn;
+        columnLevel = columnSamples > 0.0 ? level : 0.0f;
+    }
 }
 
 //==============================================================================
 void LusionSmartReverbAudioProcessorEditor::paint(juce::Graphics& g)
 {
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (staticLayer.isNull() || scale != staticLayerScale || getStaticLayerKey() != staticLayerKey)
+        renderStaticLayer(scale);
+
+    g.drawImage(staticLayer, getLocalBounds().toFloat());
+
+    if (g.clipRegionIntersects(vizArea))
+        drawVisualization(g);
+
+    if (g.clipRegionIntersects(meterArea))
+        drawMeters(g);
+}
+
+void LusionSmartReverbAudioProcessorEditor::renderStaticLayer(float scale)
+{
+    staticLayerScale = scale;
+    staticLayerKey = getStaticLayerKey();
+
+    // Rendered at physical resolution so the blit stays sharp on HiDPI screens
+    staticLayer = juce::Image(juce::Image::ARGB,
+        juce::jmax(1, juce::roundToInt(getWidth() * scale)),
+        juce::jmax(1, juce::roundToInt(getHeight() * scale)), true);
+
+    juce::Graphics g(staticLayer);
+    g.addTransform(juce::AffineTransform::scale(scale));
+
     drawBackground(g);
     drawHeader(g);
-    drawVisualization(g);
-    drawMeters(g);
+    drawVisualizationBackground(g);
+    drawMeterBackgrounds(g);
+}
+
+int LusionSmartReverbAudioProcessorEditor::getStaticLayerKey() const
+{
+    // The header text and the AUTO glow are the only static parts that
+    // follow the controls
+    return (autoButton.getToggleState() ? 1 : 0) | (modeSelector.getSelectedItemIndex() + 1) << 1;
 }
 
 //==============================================================================
@@ -271,11 +532,11 @@ void LusionSmartReverbAudioProcessorEditor::drawBackground(juce::Graphics& g)
     g.setGradientFill(gradient);
     g.fillRoundedRectangle(mainArea.toFloat(), 12.0f);
 
-    // Subtle glow when auto mode is on
+    // Subtle glow when auto mode is on. Constant rather than following the
+    // input, so it can live in the cached static layer.
     if (autoButton.getToggleState())
     {
-        float glowIntensity = 0.08f + rmsSmoothed * 0.12f;
-        g.setColour(Colors::accent.withAlpha(glowIntensity));
+        g.setColour(Colors::accent.withAlpha(0.1f));
         g.fillRoundedRectangle(mainArea.toFloat(), 12.0f);
     }
 
@@ -301,7 +562,8 @@ void LusionSmartReverbAudioProcessorEditor::drawHeader(juce::Graphics& g)
     g.setFont(juce::Font(13.0f));
 
     juce::String modeText = modeSelector.getSelectedItemIndex() == 0 ? "SHORT" :
-        modeSelector.getSelectedItemIndex() == 1 ? "LONG" : "TAIL";
+        modeSelector.getSelectedItemIndex() == 1 ? "LONG" :
+        modeSelector.getSelectedItemIndex() == 2 ? "TAIL" : "CONVOLUTION";
 
     juce::String statusText = autoButton.getToggleState()
         ? "INTELLIGENT PROCESSING  " + modeText + " MODE"
@@ -311,18 +573,45 @@ void LusionSmartReverbAudioProcessorEditor::drawHeader(juce::Graphics& g)
 }
 
 //==============================================================================
-void LusionSmartReverbAudioProcessorEditor::drawVisualization(juce::Graphics& g)
+void LusionSmartReverbAudioProcessorEditor::drawVisualizationBackground(juce::Graphics& g)
 {
-    auto vizArea = juce::Rectangle<int>(40, 120, getWidth() - 80, 120);
-
     // Background panel
     g.setColour(Colors::background.brighter(0.05f));
     g.fillRoundedRectangle(vizArea.toFloat(), 8.0f);
 
-    // Draw waveform
+    // Center line
+    g.setColour(Colors::textVeryDim.withAlpha(0.3f));
+    g.drawLine(vizArea.getX(), vizArea.getCentreY(),
+        vizArea.getRight(), vizArea.getCentreY(), 0.5f);
+
+    // Label
+    g.setColour(Colors::textVeryDim);
+    g.setFont(juce::Font(11.0f));
+    g.drawText("REAL-TIME ANALYZER", vizArea.getX() + 10, vizArea.getY() + 5,
+        200, 20, juce::Justification::left);
+
+    // Octave-ish spectrum grid
+    g.setFont(juce::Font(9.0f));
+
+    for (float frequency : { 100.0f, 1000.0f, 10000.0f })
+    {
+        const float x = spectrumArea.getX() + SpectrumAnalyzer::getFrequencyPosition(frequency) * spectrumArea.getWidth();
+
+        g.setColour(Colors::textVeryDim.withAlpha(0.25f));
+        g.drawVerticalLine(juce::roundToInt(x), spectrumArea.getY(), spectrumArea.getBottom());
+
+        g.setColour(Colors::textVeryDim);
+        g.drawText(frequency < 1000.0f ? "100" : frequency < 10000.0f ? "1k" : "10k",
+            juce::roundToInt(x) + 3, (int)spectrumArea.getBottom() - 12, 30, 12, juce::Justification::left);
+    }
+}
+
+void LusionSmartReverbAudioProcessorEditor::drawVisualization(juce::Graphics& g)
+{
+    // Draw waveform, into a member path that is refilled in place
     if (!waveformData.empty())
     {
-        juce::Path waveform;
+        waveformPath.clear();
         float xStep = vizArea.getWidth() / (float)waveformData.size();
 
         for (size_t i = 0; i < waveformData.size(); ++i)
@@ -332,88 +621,112 @@ void LusionSmartReverbAudioProcessorEditor::drawVisualization(juce::Graphics& g)
             float y = vizArea.getCentreY() - (waveformData[idx] * vizArea.getHeight() * 0.35f);
 
             if (i == 0)
-                waveform.startNewSubPath(x, y);
+                waveformPath.startNewSubPath(x, y);
             else
-                waveform.lineTo(x, y);
+                waveformPath.lineTo(x, y);
         }
 
-        // Reflection
-        juce::Path reflection = waveform;
-        reflection.applyTransform(juce::AffineTransform::verticalFlip(vizArea.getCentreY()));
-
+        // Reflection about the centre line
         g.setColour(Colors::accent.withAlpha(0.1f));
-        g.strokePath(reflection, juce::PathStrokeType(1.5f));
-
-        // Main waveform
-        juce::ColourGradient waveGradient(
-            Colors::accent, vizArea.getCentreX(), vizArea.getY(),
-            Colors::meter, vizArea.getCentreX(), vizArea.getBottom(), false);
+        g.strokePath(waveformPath, juce::PathStrokeType(1.5f),
+            juce::AffineTransform::verticalFlip(2.0f * vizArea.getCentreY()));
 
-        g.setGradientFill(waveGradient);
-        g.strokePath(waveform, juce::PathStrokeType(2.0f));
+        // Main waveform, behind the spectrum
+        g.setGradientFill(waveformGradient);
+        g.strokePath(waveformPath, juce::PathStrokeType(1.5f));
     }
 
-    // Center line
-    g.setColour(Colors::textVeryDim.withAlpha(0.3f));
-    g.drawLine(vizArea.getX(), vizArea.getCentreY(),
-        vizArea.getRight(), vizArea.getCentreY(), 0.5f);
+    drawSpectrum(g);
+}
 
-    // Label
-    g.setColour(Colors::textVeryDim);
-    g.setFont(juce::Font(11.0f));
-    g.drawText("REAL-TIME ANALYZER", vizArea.getX() + 10, vizArea.getY() + 5,
-        200, 20, juce::Justification::left);
+void LusionSmartReverbAudioProcessorEditor::drawSpectrum(juce::Graphics& g)
+{
+    using Analyzer = SpectrumAnalyzer;
+
+    const auto area = spectrumArea;
+
+    const auto fillPath = [&area](juce::Path& path, const std::array<float, Analyzer::numBands>& bands, bool closed)
+        {
+            path.clear();
+            const float xStep = area.getWidth() / (float)(Analyzer::numBands - 1);
+
+            for (int b = 0; b < Analyzer::numBands; ++b)
+            {
+                const float x = area.getX() + b * xStep;
+                const float y = area.getBottom() - bands[(size_t)b] * area.getHeight();
+
+                if (b == 0)
+                    path.startNewSubPath(x, closed ? area.getBottom() : y);
+
+                if (b > 0 || closed)
+                    path.lineTo(x, y);
+            }
+
+            if (closed)
+            {
+                path.lineTo(area.getRight(), area.getBottom());
+                path.closeSubPath();
+            }
+        };
+
+    // Input as a filled shadow, the processed output as the bright line on top
+    fillPath(spectrumInputPath, spectrum.input, true);
+    fillPath(spectrumOutputPath, spectrum.output, false);
+
+    g.setColour(Colors::textDim.withAlpha(0.18f));
+    g.fillPath(spectrumInputPath);
+
+    g.setGradientFill(spectrumGradient);
+    g.strokePath(spectrumOutputPath, juce::PathStrokeType(2.0f));
 }
 
 //==============================================================================
-void LusionSmartReverbAudioProcessorEditor::drawMeters(juce::Graphics& g)
+void LusionSmartReverbAudioProcessorEditor::drawMeterBackgrounds(juce::Graphics& g)
 {
-    auto meterArea = juce::Rectangle<int>(getWidth() - 100, 280, 60, 280);
+    g.setFont(juce::Font(11.0f, juce::Font::bold));
 
-    // RMS Meter
+    for (auto [bar, name] : { std::pair<juce::Rectangle<int>, const char*>{ rmsBarArea, "INPUT" },
+                              std::pair<juce::Rectangle<int>, const char*>{ duckBarArea, "DUCK" } })
     {
-        auto rmsBar = meterArea.removeFromTop(130);
-
         g.setColour(Colors::panelLight);
-        g.fillRoundedRectangle(rmsBar.toFloat(), 6.0f);
+        g.fillRoundedRectangle(bar.toFloat(), 6.0f);
+
+        g.setColour(Colors::textDim);
+        g.drawText(name, bar.getX(), bar.getBottom() + 5,
+            bar.getWidth(), 20, juce::Justification::centred);
+    }
+}
 
-        float fillHeight = rmsSmoothed * rmsBar.getHeight();
+void LusionSmartReverbAudioProcessorEditor::drawMeters(juce::Graphics& g)
+{
+    // RMS Meter
+    {
+        const auto rmsBar = rmsBarArea;
+
+        // Clamped so nothing is drawn outside the invalidated meter area
+        float fillHeight = juce::jmin(1.0f, rmsSmoothed) * rmsBar.getHeight();
         auto fillRect = rmsBar.toFloat();
         fillRect = fillRect.removeFromBottom(fillHeight);
 
-        juce::ColourGradient meterGrad(
-            Colors::accent, fillRect.getCentreX(), fillRect.getBottom(),
-            Colors::meter, fillRect.getCentreX(), fillRect.getY(), false);
-
-        g.setGradientFill(meterGrad);
+        g.setGradientFill(meterGradient);
         g.fillRoundedRectangle(fillRect, 6.0f);
 
-        g.setColour(Colors::textDim);
-        g.setFont(juce::Font(11.0f, juce::Font::bold));
-        g.drawText("INPUT", rmsBar.getX(), rmsBar.getBottom() + 5,
-            rmsBar.getWidth(), 20, juce::Justification::centred);
+        // Peak marker
+        float peakY = rmsBar.getBottom() - juce::jmin(1.0f, peakSmoothed) * rmsBar.getHeight();
+        g.setColour(Colors::text.withAlpha(0.7f));
+        g.fillRect((float)rmsBar.getX() + 4.0f, peakY - 1.0f, (float)rmsBar.getWidth() - 8.0f, 2.0f);
     }
 
-    meterArea.removeFromTop(20);
-
     // Duck Meter
     {
-        auto duckBar = meterArea;
+        const auto duckBar = duckBarArea;
 
-        g.setColour(Colors::panelLight);
-        g.fillRoundedRectangle(duckBar.toFloat(), 6.0f);
-
-        float fillHeight = duckSmoothed * duckBar.getHeight();
+        float fillHeight = juce::jmin(1.0f, duckSmoothed) * duckBar.getHeight();
         auto fillRect = duckBar.toFloat();
         fillRect = fillRect.removeFromBottom(fillHeight);
 
         g.setColour(Colors::warning);
         g.fillRoundedRectangle(fillRect, 6.0f);
-
-        g.setColour(Colors::textDim);
-        g.setFont(juce::Font(11.0f, juce::Font::bold));
-        g.drawText("DUCK", duckBar.getX(), duckBar.getBottom() + 5,
-            duckBar.getWidth(), 20, juce::Justification::centred);
     }
 }
 
@@ -422,6 +735,33 @@ void LusionSmartReverbAudioProcessorEditor::resized()
 {
     auto area = getLocalBounds();
 
+    // Visualization and meters
+    vizArea = juce::Rectangle<int>(40, 120, getWidth() - 80, 120);
+    meterArea = juce::Rectangle<int>(getWidth() - 100, 280, 60, 280);
+
+    auto meterBars = meterArea;
+    rmsBarArea = meterBars.removeFromTop(130);
+    meterBars.removeFromTop(20);
+    duckBarArea = meterBars;
+
+    spectrumArea = vizArea.toFloat().reduced(4.0f, 8.0f);
+
+    // Gradients span whole areas, so they only change with the layout
+    waveformGradient = juce::ColourGradient(
+        Colors::accent.withAlpha(0.4f), vizArea.getCentreX(), vizArea.getY(),
+        Colors::meter.withAlpha(0.4f), vizArea.getCentreX(), vizArea.getBottom(), false);
+
+    spectrumGradient = juce::ColourGradient(
+        Colors::accent, spectrumArea.getCentreX(), spectrumArea.getY(),
+        Colors::meter, spectrumArea.getCentreX(), spectrumArea.getBottom(), false);
+
+    meterGradient = juce::ColourGradient(
+        Colors::accent, rmsBarArea.getCentreX(), rmsBarArea.getBottom(),
+        Colors::meter, rmsBarArea.getCentreX(), rmsBarArea.getY(), false);
+
+    // Static layer follows the new size on the next paint
+    staticLayer = {};
+
     // Control section
     auto controlArea = area.removeFromBottom(280).reduced(40, 20);
 
@@ -449,4 +789,6 @@ void LusionSmartReverbAudioProcessorEditor::resized()
     // Position mode controls
     autoButton.setBounds(550, 35, 140, 32);
     modeSelector.setBounds(700, 35, 160, 32);
+    engineSelector.setBounds(700, 75, 160, 28);
+    loadIRButton.setBounds(550, 75, 140, 28);
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 ﻿#pragma once
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "KnobFilmstripCache.h"
+#include "AllocationCounter.h"
 
 //==============================================================================
 // Modern Rotary Slider with Custom Look
@@ -17,13 +19,26 @@ public:
             true);
     }
 
+    // One blit of a cached frame plus the value text; see KnobFilmstripCache
     void paint(juce::Graphics& g) override;
+    void resized() override;
 
     void setLabel(const juce::String& newLabel) { label = newLabel; }
     juce::String getLabel() const { return label; }
 
 private:
+    // Renders the knob artwork (everything but the value text) for one position
+    static void drawKnob(juce::Graphics& g, juce::Rectangle<float> bounds, float sliderPos);
+
     juce::String label;
+
+    juce::SharedResourcePointer<KnobFilmstripCache> filmstripCache;
+    KnobFilmstripCache::Filmstrip::Ptr filmstrip;
+
+    // Value text, laid out once per shown value (hundredths)
+    juce::Font valueFont{ 16.0f, juce::Font::bold };
+    juce::GlyphArrangement valueGlyphs;
+    int glyphValue = std::numeric_limits<int>::min();
 };
 
 //==============================================================================
@@ -53,17 +68,37 @@ public:
 
 private:
     void timerCallback() override;
+
+    // Per-frame work, allocation-free in steady state. Both return true if
+    // label text had to be reformatted.
+    bool updateFrame();
+    bool updateValueLabels();
+
+    // Static layer: everything that only changes on resize, scale, AUTO or
+    // MODE. Rendered once into staticLayer and blitted by paint().
+    void renderStaticLayer(float scale);
+    int getStaticLayerKey() const;
     void drawBackground(juce::Graphics& g);
     void drawHeader(juce::Graphics& g);
+    void drawMeterBackgrounds(juce::Graphics& g);
+    void drawVisualizationBackground(juce::Graphics& g);
+
+    // Dynamic layer, redrawn only inside meterArea and vizArea
     void drawMeters(juce::Graphics& g);
     void drawVisualization(juce::Graphics& g);
 
+    // Picks the timer rate from whether anything visible is still moving
+    void updateFrameRate(bool moving);
+
     LusionSmartReverbAudioProcessor& processor;
 
     // Controls
     ModernRotarySlider wetSlider, decaySlider, widthSlider;
     ModernToggleButton autoButton{ "AUTO MODE" };
     juce::ComboBox modeSelector;
+    juce::ComboBox engineSelector;
+    juce::TextButton loadIRButton{ "LOAD IR" };
+    std::unique_ptr<juce::FileChooser> irChooser;
 
     juce::Label wetLabel, decayLabel, widthLabel;
     juce::Label valueLabels[3];
@@ -76,14 +111,58 @@ private:
     std::unique_ptr<SA> wetAttachment, decayAttachment, widthAttachment;
     std::unique_ptr<BA> autoAttachment;
     std::unique_ptr<CA> modeAttachment;
+    std::unique_ptr<CA> engineAttachment;
+
+    // Takes every meter frame queued since the last UI frame
+    void drainMeterFrames();
+    void drawSpectrum(juce::Graphics& g);
+    void addToWaveform(const MeterFrame& frame);
+
+    // Cached static layer, at the display scale it was rendered for
+    juce::Image staticLayer;
+    float staticLayerScale = 0.0f;
+    int staticLayerKey = -1;
+
+    // The only regions the timer invalidates
+    juce::Rectangle<int> vizArea, meterArea, rmsBarArea, duckBarArea;
+    juce::Rectangle<float> spectrumArea;
+
+    // Reused by every frame instead of being built in paint()
+    juce::Path waveformPath, spectrumInputPath, spectrumOutputPath;
+    juce::ColourGradient waveformGradient, spectrumGradient, meterGradient;
+
+    static constexpr int activeFrameRate = 60;
+    static constexpr int idleFrameRate = 10;
+    static constexpr int hiddenFrameRate = 4;
+
+    // Frames in a row with nothing on screen changing
+    int stillFrames = 0;
+    bool frameMoved = false;
+
+    // Label values as last formatted, in hundredths
+    int shownValues[3] = { std::numeric_limits<int>::min(),
+                           std::numeric_limits<int>::min(),
+                           std::numeric_limits<int>::min() };
 
     // Visual state
     float rmsSmoothed = 0.0f;
+    float peakSmoothed = 0.0f;
     float duckSmoothed = 0.0f;
-    float animationPhase = 0.0f;
 
+    // Latest meter frame values
+    float targetRms = 0.0f, targetPeak = 0.0f, targetDuck = 0.0f;
+    float appliedWet = 0.0f, appliedDecay = 0.0f;
+    bool hasAppliedValues = false;
+
+    // One waveform point per column of audio time, the loudest block in it
     std::vector<float> waveformData;
     int waveformIndex = 0;
+    double columnSamples = 0.0;
+    float columnLevel = 0.0f;
+    bool waveformMoved = false;
+
+    // Latest spectra from the analysis thread
+    SpectrumAnalyzer::Spectrum spectrum;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LusionSmartReverbAudioProcessorEditor)
 };
\ No newline at end of file
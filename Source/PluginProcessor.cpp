@@ -16,11 +16,46 @@ static juce::AudioProcessorValueTreeState::ParameterLayout createParameters()
     params.push_back(std::make_unique<juce::AudioParameterBool>(
         "AUTO", "Auto", false));
     params.push_back(std::make_unique<juce::AudioParameterChoice>(
-        "MODE", "Mode", juce::StringArray{ "Short", "Long", "Tail" }, 1));
+        "MODE", "Mode", juce::StringArray{ "Short", "Long", "Tail", "Convolution" }, 1));
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        "ENGINE", "Engine", juce::StringArray{ "Classic", "FDN" }, 0));
+
+    // Runs the tank at a half or a quarter of the sample rate. Not automatable:
+    // every change alters the reported latency.
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        "ECO", "Eco", juce::StringArray{ "Off", "2x", "4x" }, 0,
+        juce::AudioParameterChoiceAttributes().withAutomatable(false)));
+
+    // Hands processing to a pool of worker threads shared by all instances,
+    // one host block late. Not automatable either, for the same reason.
+    params.push_back(std::make_unique<juce::AudioParameterBool>(
+        "WORKER", "Worker Thread", false,
+        juce::AudioParameterBoolAttributes().withAutomatable(false)));
 
     return { params.begin(), params.end() };
 }
 
+namespace
+{
+    constexpr float minDecaySeconds = 0.2f;
+    constexpr float maxDecaySeconds = 6.0f;
+
+    // Beyond mono and stereo, with the same layout in as out
+    const juce::Array<juce::AudioChannelSet>& getSurroundLayouts()
+    {
+        static const juce::Array<juce::AudioChannelSet> layouts{
+            juce::AudioChannelSet::create5point0(),
+            juce::AudioChannelSet::create5point1(),
+            juce::AudioChannelSet::create7point0(),
+            juce::AudioChannelSet::create7point1(),
+            juce::AudioChannelSet::create7point0point4(),
+            juce::AudioChannelSet::create7point1point4()
+        };
+
+        return layouts;
+    }
+}
+
 //============================================================
 LusionSmartReverbAudioProcessor::LusionSmartReverbAudioProcessor()
     : AudioProcessor(
@@ -29,90 +64,378 @@ LusionSmartReverbAudioProcessor::LusionSmartReverbAudioProcessor()
         .withOutput("Output", juce::AudioChannelSet::stereo(), true)),
     apvts(*this, nullptr, "PARAMETERS", createParameters())
 {
+    wetParam = apvts.getRawParameterValue("WET");
+    decayParam = apvts.getRawParameterValue("DECAY");
+    widthParam = apvts.getRawParameterValue("WIDTH");
+    autoParam = apvts.getRawParameterValue("AUTO");
+    modeParam = apvts.getRawParameterValue("MODE");
+    engineParam = apvts.getRawParameterValue("ENGINE");
+    ecoParam = apvts.getRawParameterValue("ECO");
+    workerParam = apvts.getRawParameterValue("WORKER");
+
+    apvts.addParameterListener("ECO", this);
+    apvts.addParameterListener("WORKER", this);
+
+    // The CPU check behind the kernel choice can read system files, so it
+    // runs here rather than on the first audio callback
+    DspKernels::initialise();
 }
 
-LusionSmartReverbAudioProcessor::~LusionSmartReverbAudioProcessor() {}
+LusionSmartReverbAudioProcessor::~LusionSmartReverbAudioProcessor()
+{
+    apvts.removeParameterListener("ECO", this);
+    apvts.removeParameterListener("WORKER", this);
+    cancelPendingUpdate();
+}
 
 //============================================================
 void LusionSmartReverbAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    reverb.prepare(sampleRate, samplesPerBlock);
-    duckEnv.reset(sampleRate, 0.08);
-    duckEnv.setCurrentAndTargetValue(0.0f);
+    prepareReverb(sampleRate, samplesPerBlock);
+
+    ducking.prepare(sampleRate, controlBlockSize);
+    silence.prepare(sampleRate);
+    analyzer.setSampleRate(sampleRate);
+
+    levels.prepare(sampleRate, getChannelLayoutOfBus(true, 0),
+                   juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels()), controlBlockSize);
 }
 
 void LusionSmartReverbAudioProcessor::releaseResources()
 {
+    floatOffloader.release();
+    doubleOffloader.release();
     reverb.reset();
+    ducking.reset();
+    silence.reset();
+    levels.reset();
 }
 
 bool LusionSmartReverbAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
 {
-    return layouts.getMainOutputChannelSet() == juce::AudioChannelSet::mono()
-        || layouts.getMainOutputChannelSet() == juce::AudioChannelSet::stereo();
+    const auto& output = layouts.getMainOutputChannelSet();
+
+    if (output == juce::AudioChannelSet::mono() || output == juce::AudioChannelSet::stereo())
+        return true;
+
+    // Surround tanks are per channel, so the input has to match
+    return output.size() > 2
+        && output == getLayoutForChannelCount(output.size())
+        && layouts.getMainInputChannelSet() == output;
+}
+
+juce::AudioChannelSet LusionSmartReverbAudioProcessor::getLayoutForChannelCount(int numChannels)
+{
+    if (numChannels == 1)
+        return juce::AudioChannelSet::mono();
+
+    if (numChannels == 2)
+        return juce::AudioChannelSet::stereo();
+
+    for (const auto& layout : getSurroundLayouts())
+        if (layout.size() == numChannels)
+            return layout;
+
+    return juce::AudioChannelSet::disabled();
+}
+
+void LusionSmartReverbAudioProcessor::prepareReverb(double sampleRate, int maxBlockSize)
+{
+    // Nothing may still be running on a worker while the engine is rebuilt
+    floatOffloader.release();
+    doubleOffloader.release();
+
+    // Mono and stereo share the stereo setup (a mono output can still come
+    // with a stereo input); wider layouts get their own tanks
+    const auto output = getChannelLayoutOfBus(false, 0);
+    const auto layout = output.size() > 2 ? output : juce::AudioChannelSet::stereo();
+
+    // Everything runs in control blocks, whatever the host buffer size
+    reverb.prepare(sampleRate, controlBlockSize, getEcoFactor(), layout);
+
+    workerPrepared = isWorkerEnabled();
+
+    if (workerPrepared)
+    {
+        const int numChannels = juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels());
+
+        if (isUsingDoublePrecision())
+            doubleOffloader.prepare(numChannels, maxBlockSize);
+        else
+            floatOffloader.prepare(numChannels, maxBlockSize);
+    }
+
+    setLatencySamples(reverb.getLatencySamples() + floatOffloader.getLatencySamples()
+                      + doubleOffloader.getLatencySamples());
 }
 
 //============================================================
 void LusionSmartReverbAudioProcessor::processBlock(
     juce::AudioBuffer<float>& buffer,
     juce::MidiBuffer&)
+{
+    processBuffer(buffer);
+}
+
+void LusionSmartReverbAudioProcessor::processBlock(
+    juce::AudioBuffer<double>& buffer,
+    juce::MidiBuffer&)
+{
+    processBuffer(buffer);
+}
+
+template <>
+BlockOffloader<float>& LusionSmartReverbAudioProcessor::getOffloader() noexcept { return floatOffloader; }
+
+template <>
+BlockOffloader<double>& LusionSmartReverbAudioProcessor::getOffloader() noexcept { return doubleOffloader; }
+
+template <typename SampleType>
+void LusionSmartReverbAudioProcessor::processBuffer(juce::AudioBuffer<SampleType>& buffer)
+{
+    auto& offloader = getOffloader<SampleType>();
+
+    // With WORKER on, blocks run on the shared pool and come back one host
+    // block later
+    if (offloader.isActive())
+        offloader.process(buffer);
+    else
+        processControlBlocks(buffer);
+}
+
+template <typename SampleType>
+void LusionSmartReverbAudioProcessor::processControlBlocks(juce::AudioBuffer<SampleType>& buffer)
 {
     juce::ScopedNoDenormals noDenormals;
 
     const int numChannels = buffer.getNumChannels();
     const int numSamples = buffer.getNumSamples();
 
-    rmsLevel = 0.0f;
-    peakLevel = 0.0f;
-
-    for (int ch = 0; ch < numChannels; ++ch)
+    // Level analysis, AUTO and parameter changes run once per control block,
+    // and the reverb processes one control block at a time, so neither the
+    // sound nor the cost per second depends on the host's buffer size
+    for (int start = 0; start < numSamples; start += controlBlockSize)
     {
-        rmsLevel += buffer.getRMSLevel(ch, 0, numSamples);
-        peakLevel += buffer.getMagnitude(ch, 0, numSamples);
+        const int n = juce::jmin(controlBlockSize, numSamples - start);
+        juce::AudioBuffer<SampleType> block(buffer.getArrayOfWritePointers(), numChannels, start, n);
+
+        analyzer.captureInput(block);
+
+        levels.process(block);
+        updateEngineSettings(numChannels);
+
+        const float* wetScale = ducking.process(block, 0, n);
+        const bool inputAudible = SilenceGate::isAudible(levels.getBlockPeak());
+
+        // Once the tail has died away the engine sleeps, and silent input
+        // costs no more than clearing the block
+        if (silence.shouldProcess(inputAudible))
+        {
+            reverb.process(block, wetScale);
+
+            if (silence.update(inputAudible, block, reverb.getLongestPathSeconds()))
+                reverb.reset();
+        }
+        else
+        {
+            block.clear();
+        }
+
+        analyzer.captureOutput(block);
+        pushMeterFrame(n);
     }
+}
+
+void LusionSmartReverbAudioProcessor::pushMeterFrame(int numSamples) noexcept
+{
+    MeterFrame frame;
+    frame.numSamples = numSamples;
+    frame.rms = levels.getRmsLevel();
+    frame.peak = levels.getPeakLevel();
+    frame.duck = ducking.getDuckAmount();
+    frame.wet = reverb.getWet();
+    frame.decay = reverb.getDecay();
+
+    // A full queue just means no editor is reading
+    meterFifo.push(frame);
+}
 
-    rmsLevel /= juce::jmax(1, numChannels);
-    peakLevel /= juce::jmax(1, numChannels);
+void LusionSmartReverbAudioProcessor::updateEngineSettings(int numChannels)
+{
+    const auto params = readParameters();
 
-    float wet = apvts.getRawParameterValue("WET")->load();
-    float decay = apvts.getRawParameterValue("DECAY")->load();
-    float width = apvts.getRawParameterValue("WIDTH")->load();
+    float wet = params.wet;
+    float decay = params.decay;
+    float width = params.width;
 
-    const bool autoOn = apvts.getRawParameterValue("AUTO")->load() > 0.5f;
-    const int  mode = (int)apvts.getRawParameterValue("MODE")->load();
+    const bool autoOn = params.autoOn;
+    const int  mode = params.mode;
+    const int  engine = params.engine;
 
     if (autoOn)
     {
         if (mode == 0) { wet = 0.25f; decay = 0.8f; }
         else if (mode == 1) { wet = 0.40f; decay = 2.2f; }
-        else { wet = 0.55f; decay = 4.5f; }
+        else if (mode == 2) { wet = 0.55f; decay = 4.5f; }
+        else { wet = 0.35f; decay = 2.2f; }
+
+        const float rms = levels.getRmsLevel();
+
+        if (rms > 0.30f) { wet *= 0.65f; decay *= 0.7f; }
+        else if (rms < 0.12f) { wet *= 1.2f;  decay *= 1.3f; }
 
-        if (rmsLevel > 0.30f) { wet *= 0.65f; decay *= 0.7f; }
-        else if (rmsLevel < 0.12f) { wet *= 1.2f;  decay *= 1.3f; }
+        // Transient material keeps its attacks clear with a shorter tail;
+        // loud, dense material (little crest left) would wash out under a
+        // full-level one
+        const float crest = levels.getCrestFactor();
 
-        if (peakLevel > rmsLevel * 2.5f)
+        if (crest > 2.5f)
             decay *= 0.75f;
+        else if (crest < 2.0f && levels.getLoudness() > -14.0f)
+            wet *= 0.85f;
 
         width = (numChannels == 1 ? 0.7f : 0.9f);
     }
 
     wet = juce::jlimit(0.05f, 0.8f, wet);
-    decay = juce::jlimit(0.2f, 6.0f, decay);
+    decay = juce::jlimit(minDecaySeconds, maxDecaySeconds, decay);
     width = juce::jlimit(0.3f, 1.0f, width);
 
-    const float duckTarget =
-        juce::jlimit(0.0f, 1.0f, (rmsLevel - 0.08f) * 2.0f);
+    // The engine ignores unchanged values, so this costs nothing while the
+    // controls (or AUTO's choice) stay put
+    reverb.setAlgorithm(getAlgorithm(mode, engine));
 
-    duckEnv.setTargetValue(duckTarget);
-    duckAmount = duckEnv.getNextValue();
-
-    const float duckedWet = wet * (1.0f - duckAmount * 0.7f);
-
-    reverb.setWet(duckedWet);
+    reverb.setWet(wet);
     reverb.setDecay(decay);
     reverb.setWidth(width);
+}
+
+LusionSmartReverbAudioProcessor::ParameterSnapshot LusionSmartReverbAudioProcessor::readParameters() const noexcept
+{
+    return { wetParam->load(),
+             decayParam->load(),
+             widthParam->load(),
+             autoParam->load() > 0.5f,
+             (int)modeParam->load(),
+             (int)engineParam->load() };
+}
 
-    reverb.process(buffer);
+ReverbEngine::Algorithm LusionSmartReverbAudioProcessor::getAlgorithm(int mode, int engine)
+{
+    if (mode == 3)
+        return ReverbEngine::Algorithm::convolution;
+
+    return engine == 1 ? ReverbEngine::Algorithm::fdn
+                       : ReverbEngine::Algorithm::classic;
+}
+
+int LusionSmartReverbAudioProcessor::getEcoFactor() const noexcept
+{
+    return 1 << juce::jlimit(0, 2, (int)ecoParam->load());
+}
+
+bool LusionSmartReverbAudioProcessor::isWorkerEnabled() const noexcept
+{
+    return workerParam->load() > 0.5f;
+}
+
+void LusionSmartReverbAudioProcessor::parameterChanged(const juce::String&, float)
+{
+    triggerAsyncUpdate();
+}
+
+void LusionSmartReverbAudioProcessor::handleAsyncUpdate()
+{
+    // Not prepared yet, or nothing to do: prepareToPlay reads both itself
+    if (getSampleRate() <= 0.0
+        || (getEcoFactor() == reverb.getEcoFactor() && isWorkerEnabled() == workerPrepared))
+        return;
+
+    suspendProcessing(true);
+    prepareReverb(getSampleRate(), getBlockSize());
+    suspendProcessing(false);
+}
+
+//============================================================
+double LusionSmartReverbAudioProcessor::getTailSeconds(float attenuationDb) const
+{
+    const auto params = readParameters();
+
+    const float decay = params.autoOn ? maxDecaySeconds
+                                      : juce::jlimit(minDecaySeconds, maxDecaySeconds, params.decay);
+
+    return reverb.getTailSeconds(getAlgorithm(params.mode, params.engine), decay, attenuationDb);
+}
+
+double LusionSmartReverbAudioProcessor::getTailLengthSeconds() const
+{
+    // Down to the silence gate's threshold from full scale: the point at
+    // which we stop running ourselves
+    return getTailSeconds(-SilenceGate::thresholdDb);
+}
+
+double LusionSmartReverbAudioProcessor::getControlSettleSeconds(float attenuationDb) const
+{
+    return juce::jmax(levels.getSettleSeconds(attenuationDb), ducking.getSettleSeconds(attenuationDb));
+}
+
+void LusionSmartReverbAudioProcessor::advanceWithoutAudio(const juce::AudioBuffer<float>& input)
+{
+    // Same control-block slicing, and the same denormal handling for the
+    // analysis filter's state, as processBlock
+    juce::ScopedNoDenormals noDenormals;
+    const int numSamples = input.getNumSamples();
+
+    for (int start = 0; start < numSamples; start += controlBlockSize)
+    {
+        const int n = juce::jmin(controlBlockSize, numSamples - start);
+        const juce::AudioBuffer<float> block(const_cast<float* const*>(input.getArrayOfReadPointers()),
+                                             input.getNumChannels(), start, n);
+
+        levels.process(block);
+        ducking.process(block, 0, n);
+    }
+}
+
+//============================================================
+juce::MemoryBlock LusionSmartReverbAudioProcessor::createProcessingSnapshot() const
+{
+    juce::MemoryOutputStream out;
+
+    ducking.saveState(out);
+    silence.saveState(out);
+    levels.saveState(out);
+
+    const auto engineState = reverb.createSnapshot();
+    out.write(engineState.getData(), engineState.getSize());
+
+    return out.getMemoryBlock();
+}
+
+bool LusionSmartReverbAudioProcessor::restoreProcessingSnapshot(const juce::MemoryBlock& snapshot)
+{
+    juce::MemoryInputStream in(snapshot, false);
+
+    if (!(ducking.restoreState(in) && silence.restoreState(in) && levels.restoreState(in)))
+    {
+        ducking.reset();
+        silence.reset();
+        levels.reset();
+        return false;
+    }
+
+    const auto position = (size_t)in.getPosition();
+
+    if (!reverb.restoreSnapshot(static_cast<const char*>(snapshot.getData()) + position,
+                                snapshot.getSize() - position))
+    {
+        ducking.reset();
+        silence.reset();
+        levels.reset();
+        return false;
+    }
+
+    return true;
 }
 
 //============================================================
@@ -127,7 +450,10 @@ void LusionSmartReverbAudioProcessor::setStateInformation(const void* data, int
 {
     std::unique_ptr<juce::XmlElement> xml(getXmlFromBinary(data, sizeInBytes));
     if (xml)
+    {
         apvts.replaceState(juce::ValueTree::fromXml(*xml));
+        restoreImpulseResponseFromState();
+    }
 }
 
 // ===== PRESET HELPERS =====
@@ -135,7 +461,10 @@ void LusionSmartReverbAudioProcessor::loadPresetFromXml(const juce::String& xmlT
 {
     std::unique_ptr<juce::XmlElement> xml(juce::XmlDocument::parse(xmlText));
     if (xml)
+    {
         apvts.replaceState(juce::ValueTree::fromXml(*xml));
+        restoreImpulseResponseFromState();
+    }
 }
 
 juce::String LusionSmartReverbAudioProcessor::getStateAsXmlString()
@@ -147,6 +476,22 @@ juce::String LusionSmartReverbAudioProcessor::getStateAsXmlString()
     return {};
 }
 
+// ===== CONVOLUTION IR =====
+void LusionSmartReverbAudioProcessor::loadImpulseResponse(const juce::File& file)
+{
+    // Kept in the state tree so sessions and presets remember the IR
+    apvts.state.setProperty("IR_PATH", file.getFullPathName(), nullptr);
+    reverb.loadImpulseResponse(file);
+}
+
+void LusionSmartReverbAudioProcessor::restoreImpulseResponseFromState()
+{
+    const juce::String path = apvts.state.getProperty("IR_PATH").toString();
+
+    if (path.isNotEmpty() && juce::File(path) != reverb.getImpulseResponseFile())
+        reverb.loadImpulseResponse(juce::File(path));
+}
+
 
 //============================================================
 // ✅ THIS WAS MISSING — CAUSING ALL LINKER ERRORS
@@ -1,8 +1,17 @@
 ﻿#pragma once
 #include <JuceHeader.h>
 #include "ReverbEngine.h"
+#include "DuckEnvelope.h"
+#include "SilenceGate.h"
+#include "LevelAnalyzer.h"
+#include "MeterFifo.h"
+#include "SpectrumAnalyzer.h"
+#include "WorkerPool.h"
+#include "DspKernels.h"
 
-class LusionSmartReverbAudioProcessor : public juce::AudioProcessor
+class LusionSmartReverbAudioProcessor : public juce::AudioProcessor,
+                                        private juce::AudioProcessorValueTreeState::Listener,
+                                        private juce::AsyncUpdater
 {
 public:
     LusionSmartReverbAudioProcessor();
@@ -12,6 +21,10 @@ public:
     void releaseResources() override;
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+
+    // Both precisions run natively; see ReverbEngine::process
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override { return true; }
@@ -20,7 +33,7 @@ public:
     bool acceptsMidi() const override { return false; }
     bool producesMidi() const override { return false; }
     bool isMidiEffect() const override { return false; }
-    double getTailLengthSeconds() const override { return 5.0; }
+    double getTailLengthSeconds() const override;
 
     int getNumPrograms() override { return 1; }
     int getCurrentProgram() override { return 0; }
@@ -35,20 +48,131 @@ public:
     void loadPresetFromXml (const juce::String& xmlText);
     juce::String getStateAsXmlString();
 
-    // Read-only meters
-    float getDuckAmount() const { return duckAmount; }
-    float getRmsLevel()  const { return rmsLevel; }
+    // ===== Convolution IR =====
+    void loadImpulseResponse (const juce::File& file);
+    juce::File getImpulseResponseFile() const { return reverb.getImpulseResponseFile(); }
+    bool isImpulseResponseLoading() const { return reverb.isImpulseResponseLoading(); }
+
+    // ===== Channel layouts =====
+    // Mono, stereo, 5.0, 5.1, 7.0, 7.1, 7.0.4 or 7.1.4 by channel count, as
+    // isBusesLayoutSupported accepts them; disabled for any other count
+    static juce::AudioChannelSet getLayoutForChannelCount(int numChannels);
+
+    // ===== Offline rendering =====
+    // Longest time the output can keep ringing after the input stops, until
+    // it has decayed by attenuationDb. With AUTO on this assumes the longest
+    // DECAY AUTO can choose.
+    double getTailSeconds(float attenuationDb) const;
+
+    // Time the level detector and duck envelope need before their starting
+    // state no longer matters to within attenuationDb
+    double getControlSettleSeconds(float attenuationDb) const;
+
+    // Runs only the level analysis and duck envelope over a block of input,
+    // as processBlock would, without touching the reverb
+    void advanceWithoutAudio(const juce::AudioBuffer<float>& input);
+
+    // ===== Worker pool =====
+    // Blocks that missed the worker pool's deadline since WORKER was last
+    // prepared, and went out inline or dry; any thread
+    int getNumMissedWorkerDeadlines() const noexcept
+    {
+        return floatOffloader.getNumMissedDeadlines() + doubleOffloader.getNumMissedDeadlines();
+    }
+
+    // Bit-exact snapshot of the processing state (reverb engine, duck
+    // envelope, silence gate and level analysis), so a render can resume
+    // mid-file or start from a cached, warmed-up state. Parameters are not
+    // included; use getStateInformation.
+    // Needs WORKER off, as renders have it.
+    juce::MemoryBlock createProcessingSnapshot() const;
+    bool restoreProcessingSnapshot(const juce::MemoryBlock& snapshot);
+
+    // One frame per control block for the editor's meters; the editor is the
+    // only reader
+    MeterFifo& getMeterFifo() noexcept { return meterFifo; }
+
+    // Input and output spectra; the editor starts and stops the analysis
+    SpectrumAnalyzer& getSpectrumAnalyzer() noexcept { return analyzer; }
 
     juce::AudioProcessorValueTreeState apvts;
 
 private:
+    // One read of every parameter, taken at the start of a block
+    struct ParameterSnapshot
+    {
+        float wet, decay, width;
+        bool autoOn;
+        int mode, engine;
+    };
+
+    ParameterSnapshot readParameters() const noexcept;
+
+    // processBlock works in slices of this many samples; see processBlock
+    static constexpr int controlBlockSize = 32;
+
+    void restoreImpulseResponseFromState();
+
+    void updateEngineSettings(int numChannels);
+    void pushMeterFrame(int numSamples) noexcept;
+
+    // Both processBlock overloads: hands the buffer to the offloader if
+    // WORKER is on, else runs it here
+    template <typename SampleType>
+    void processBuffer(juce::AudioBuffer<SampleType>& buffer);
+
+    // Everything processBlock does, on whichever thread runs the block
+    template <typename SampleType>
+    void processControlBlocks(juce::AudioBuffer<SampleType>& buffer);
+
+    template <typename SampleType>
+    BlockOffloader<SampleType>& getOffloader() noexcept;
+
+    static ReverbEngine::Algorithm getAlgorithm(int mode, int engine);
+
+    // ECO as a resampling factor: 1, 2 or 4
+    int getEcoFactor() const noexcept;
+
+    // Prepares the engine for the current output layout and ECO, and the
+    // offloader for the current precision if WORKER is on, and reports their
+    // latency
+    void prepareReverb(double sampleRate, int maxBlockSize);
+
+    bool isWorkerEnabled() const noexcept;
+
+    // ECO and WORKER change the latency, so they re-prepare on the message
+    // thread with processing suspended rather than switching mid-block
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    void handleAsyncUpdate() override;
+
+    // Looked up once here rather than by name on every block
+    std::atomic<float>* wetParam = nullptr;
+    std::atomic<float>* decayParam = nullptr;
+    std::atomic<float>* widthParam = nullptr;
+    std::atomic<float>* autoParam = nullptr;
+    std::atomic<float>* modeParam = nullptr;
+    std::atomic<float>* engineParam = nullptr;
+    std::atomic<float>* ecoParam = nullptr;
+    std::atomic<float>* workerParam = nullptr;
+
+    // WORKER as of the last prepareReverb; the offloader can still be
+    // inactive if the pool had no room for it
+    bool workerPrepared = false;
+
     ReverbEngine reverb;
 
-    float rmsLevel  = 0.0f;
-    float peakLevel = 0.0f;
+    LevelAnalyzer levels;
+    DuckEnvelope ducking;
+    SilenceGate silence;
+
+    MeterFifo meterFifo;
+    SpectrumAnalyzer analyzer;
 
-    juce::SmoothedValue<float> duckEnv { 0.0f };
-    float duckAmount = 0.0f;
+    // Last, so they are destroyed first: they finish any block still running
+    // on a worker while everything that block uses is still here. Only the
+    // one for the prepared precision is ever active.
+    BlockOffloader<float> floatOffloader{ [this](juce::AudioBuffer<float>& block) { processControlBlocks(block); } };
+    BlockOffloader<double> doubleOffloader{ [this](juce::AudioBuffer<double>& block) { processControlBlocks(block); } };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LusionSmartReverbAudioProcessor)
 };
@@ -1,59 +1,403 @@
 ﻿#include "ReverbEngine.h"
 
-void ReverbEngine::prepare(double sampleRate, int)
+namespace
 {
-    reverb.setSampleRate(sampleRate);
+    constexpr juce::uint32 snapshotMagic = 0x4c535253; // "LSRS"
+    constexpr juce::uint32 snapshotVersion = 6;
 
-    params.roomSize = 0.5f;
-    params.damping = 0.5f;
-    params.wetLevel = 0.3f;
-    params.dryLevel = 0.7f;
-    params.width = 1.0f;
-    params.freezeMode = 0.0f;
+    // Raw values are only meaningful to a build with the same layout
+    constexpr juce::uint32 snapshotLayout =
+        (juce::uint32)(sizeof(juce::SmoothedValue<float>) << 8)
+        | (juce::uint32)juce::dsp::SIMDRegister<float>::SIMDNumElements;
+}
+
+void ReverbEngine::prepare(double sampleRate, int samplesPerBlock, int newEcoFactor,
+                           const juce::AudioChannelSet& layout)
+{
+    hostSampleRate = sampleRate;
+    ecoFactor = (newEcoFactor == 2 || newEcoFactor == 4) ? newEcoFactor : 1;
+    numChannels = juce::jlimit(1, maxChannels, layout.size());
+
+    double tankRate = sampleRate;
+    int tankBlockSize = samplesPerBlock;
+
+    if (ecoFactor > 1)
+    {
+        eco.prepare(ecoFactor, samplesPerBlock, numChannels);
+        tankRate = sampleRate / ecoFactor;
+        tankBlockSize = eco.getMaxLowRateBlockSize();
+    }
+
+    freeverb.prepare(tankRate, tankBlockSize);
+    fdn.prepare(tankRate, tankBlockSize);
+    convolution.prepare(tankRate, tankBlockSize);
+
+    freeverb.setDryEnabled(ecoFactor == 1);
+    fdn.setDryEnabled(ecoFactor == 1);
+    convolution.setDryEnabled(ecoFactor == 1);
+
+    if (isMultichannel())
+    {
+        surround.prepare(tankRate, tankBlockSize, numChannels,
+                         layout.getChannelIndexForType(juce::AudioChannelSet::LFE));
+        surround.setDryEnabled(ecoFactor == 1);
+    }
+
+    wetLevel = 0.3f;
+    decaySeconds = 3.0f;
+    width = 1.0f;
+
+    ecoDryGain.reset(sampleRate, 0.01);
+    updateEcoDryGain();
+    ecoDryGain.setCurrentAndTargetValue(ecoDryGain.getTargetValue());
+
+    markChanged(allChanged);
+
+    for (auto tank : { Algorithm::classic, Algorithm::fdn, Algorithm::convolution })
+        applyPendingChanges(tank);
 
-    reverb.setParameters(params);
+    surround.setWet(wetLevel);
+    surround.setDecay(decaySeconds);
+    surround.setWidth(width);
+
+    selectKernels(numChannels);
 }
 
 void ReverbEngine::reset()
 {
-    reverb.reset();
+    freeverb.reset();
+    fdn.reset();
+    convolution.reset();
+
+    if (isMultichannel())
+        surround.reset();
+
+    if (ecoFactor > 1)
+        eco.reset();
+
+    ecoDryGain.setCurrentAndTargetValue(ecoDryGain.getTargetValue());
+}
+
+void ReverbEngine::setAlgorithm(Algorithm newAlgorithm)
+{
+    if (newAlgorithm == algorithm)
+        return;
+
+    // Catch up on settings first, so the reset starts from them
+    applyPendingChanges(newAlgorithm);
+
+    // Start the newly selected tank from silence rather than stale state
+    if (newAlgorithm == Algorithm::fdn)
+        fdn.reset();
+    else if (newAlgorithm == Algorithm::convolution)
+        convolution.reset();
+    else
+        freeverb.reset();
+
+    algorithm = newAlgorithm;
+    selectKernels(kernelChannels);
 }
 
 void ReverbEngine::setWet(float value)
 {
-    params.wetLevel = juce::jlimit(0.0f, 1.0f, value);
-    params.dryLevel = 1.0f - params.wetLevel;
-    reverb.setParameters(params);
+    if (value != wetLevel)
+    {
+        wetLevel = value;
+        markChanged(wetChanged);
+        updateEcoDryGain();
+        surround.setWet(value);
+    }
 }
 
 void ReverbEngine::setDecay(float seconds)
 {
-    // Map 0.1 – 6.0 seconds → JUCE roomSize (0–1)
-    params.roomSize = juce::jlimit(0.05f, 1.0f, seconds / 6.0f);
-    reverb.setParameters(params);
+    if (seconds != decaySeconds)
+    {
+        decaySeconds = seconds;
+        markChanged(decayChanged);
+        surround.setDecay(seconds);
+    }
 }
 
 void ReverbEngine::setWidth(float value)
 {
-    params.width = juce::jlimit(0.0f, 1.0f, value);
-    reverb.setParameters(params);
+    if (value != width)
+    {
+        width = value;
+        markChanged(widthChanged);
+        surround.setWidth(value);
+    }
+}
+
+void ReverbEngine::updateEcoDryGain() noexcept
+{
+    // Same dry law as the tanks
+    ecoDryGain.setTargetValue((1.0f - juce::jlimit(0.0f, 1.0f, wetLevel)) * 2.0f);
 }
 
-void ReverbEngine::process(juce::AudioBuffer<float>& buffer)
+void ReverbEngine::markChanged(juce::uint8 change) noexcept
 {
-    const int numChannels = buffer.getNumChannels();
-    const int numSamples = buffer.getNumSamples();
+    for (auto& pending : pendingChanges)
+        pending |= change;
+}
+
+void ReverbEngine::applyPendingChanges(Algorithm tank) noexcept
+{
+    auto& pending = pendingChanges[(int)tank];
+
+    if (pending == 0)
+        return;
 
-    if (numChannels == 1)
+    // Freeverb maps 0.1 – 6.0 seconds onto its room size,
+    // the FDN takes DECAY as its RT60 directly. The IR sets its own decay.
+    if (tank == Algorithm::classic)
     {
-        reverb.processMono(buffer.getWritePointer(0), numSamples);
+        if (pending & wetChanged)   freeverb.setWet(wetLevel);
+        if (pending & decayChanged) freeverb.setDecay(decaySeconds);
+        if (pending & widthChanged) freeverb.setWidth(width);
+    }
+    else if (tank == Algorithm::fdn)
+    {
+        if (pending & wetChanged)   fdn.setWet(wetLevel);
+        if (pending & decayChanged) fdn.setDecay(decaySeconds);
+        if (pending & widthChanged) fdn.setWidth(width);
     }
     else
     {
-        reverb.processStereo(
-            buffer.getWritePointer(0),
-            buffer.getWritePointer(1),
-            numSamples
-        );
+        if (pending & wetChanged)   convolution.setWet(wetLevel);
+        if (pending & widthChanged) convolution.setWidth(width);
+    }
+
+    pending = 0;
+}
+
+juce::MemoryBlock ReverbEngine::createSnapshot() const
+{
+    juce::MemoryOutputStream out;
+
+    SnapshotIO::write(out, snapshotMagic);
+    SnapshotIO::write(out, snapshotVersion);
+    SnapshotIO::write(out, snapshotLayout);
+    SnapshotIO::write(out, algorithm);
+    SnapshotIO::write(out, wetLevel);
+    SnapshotIO::write(out, decaySeconds);
+    SnapshotIO::write(out, width);
+    SnapshotIO::writeArray(out, pendingChanges, 3);
+    SnapshotIO::write(out, ecoFactor);
+    SnapshotIO::write(out, ecoDryGain);
+    SnapshotIO::write(out, numChannels);
+
+    if (ecoFactor > 1)
+        eco.saveState(out);
+
+    freeverb.saveState(out, algorithm == Algorithm::classic);
+    fdn.saveState(out, algorithm == Algorithm::fdn);
+    convolution.saveState(out, algorithm == Algorithm::convolution);
+    surround.saveState(out, isMultichannel());
+
+    return out.getMemoryBlock();
+}
+
+bool ReverbEngine::restoreSnapshot(const void* data, size_t numBytes)
+{
+    juce::MemoryInputStream in(data, numBytes, false);
+
+    juce::uint32 magic = 0, version = 0, layout = 0;
+    Algorithm saved = Algorithm::classic;
+
+    if (!(SnapshotIO::read(in, magic) && magic == snapshotMagic
+          && SnapshotIO::read(in, version) && version == snapshotVersion
+          && SnapshotIO::read(in, layout) && layout == snapshotLayout
+          && SnapshotIO::read(in, saved)))
+        return false;
+
+    float savedWet = 0.0f, savedDecay = 0.0f, savedWidth = 0.0f;
+    juce::uint8 savedChanges[3] = {};
+    int savedEcoFactor = 0, savedChannels = 0;
+    auto savedEcoDryGain = ecoDryGain;
+
+    if (!(SnapshotIO::read(in, savedWet) && SnapshotIO::read(in, savedDecay) && SnapshotIO::read(in, savedWidth)
+          && SnapshotIO::readArray(in, savedChanges, 3)
+          && SnapshotIO::read(in, savedEcoFactor) && savedEcoFactor == ecoFactor
+          && SnapshotIO::read(in, savedEcoDryGain)
+          && SnapshotIO::read(in, savedChannels) && savedChannels == numChannels))
+        return false;
+
+    if (saved != Algorithm::classic && saved != Algorithm::fdn && saved != Algorithm::convolution)
+        return false;
+
+    const bool ok = (ecoFactor == 1 || eco.restoreState(in))
+                 && freeverb.restoreState(in)
+                 && fdn.restoreState(in)
+                 && convolution.restoreState(in)
+                 && surround.restoreState(in)
+                 && in.isExhausted();
+
+    if (!ok)
+    {
+        reset();
+        return false;
     }
+
+    algorithm = saved;
+    wetLevel = savedWet;
+    decaySeconds = savedDecay;
+    width = savedWidth;
+    ecoDryGain = savedEcoDryGain;
+    std::copy(savedChanges, savedChanges + 3, pendingChanges);
+    selectKernels(kernelChannels);
+    return true;
 }
+
+double ReverbEngine::getTailSeconds(Algorithm tank, float decaySeconds, float attenuationDb) const
+{
+    if (isMultichannel())
+        return surround.getTailSeconds(decaySeconds, attenuationDb);
+
+    if (tank == Algorithm::convolution)
+        return convolution.getTailSeconds();
+
+    if (tank == Algorithm::fdn)
+        return fdn.getTailSeconds(decaySeconds, attenuationDb);
+
+    return freeverb.getTailSeconds(decaySeconds, attenuationDb);
+}
+
+double ReverbEngine::getLongestPathSeconds() const
+{
+    const double resampling = getLatencySamples() / hostSampleRate;
+
+    if (isMultichannel())
+        return surround.getLongestPathSeconds() + resampling;
+
+    // The IR can have silent stretches anywhere up to its end
+    if (algorithm == Algorithm::convolution)
+        return convolution.getTailSeconds() + resampling;
+
+    if (algorithm == Algorithm::fdn)
+        return fdn.getLongestPathSeconds() + resampling;
+
+    return freeverb.getLongestPathSeconds() + resampling;
+}
+
+void ReverbEngine::selectKernels(int numBufferChannels) noexcept
+{
+    kernelChannels = numBufferChannels;
+
+    const auto layout = isMultichannel() ? Layout::surround
+                      : juce::jmin(numBufferChannels, numChannels) == 1 ? Layout::mono
+                      : Layout::stereo;
+
+    if (ecoFactor > 1)
+    {
+        floatKernel = findKernel<float, true>(layout, algorithm);
+        doubleKernel = findKernel<double, true>(layout, algorithm);
+    }
+    else
+    {
+        floatKernel = findKernel<float, false>(layout, algorithm);
+        doubleKernel = findKernel<double, false>(layout, algorithm);
+    }
+}
+
+template <typename SampleType, bool isEco>
+ReverbEngine::Kernel<SampleType> ReverbEngine::findKernel(Layout layout, Algorithm tank) noexcept
+{
+    // The multichannel bank stands in for every algorithm
+    if (layout == Layout::surround)
+        return &ReverbEngine::processKernel<SampleType, Algorithm::classic, Layout::surround, isEco>;
+
+    const bool mono = layout == Layout::mono;
+
+    if (tank == Algorithm::convolution)
+        return mono ? &ReverbEngine::processKernel<SampleType, Algorithm::convolution, Layout::mono, isEco>
+                    : &ReverbEngine::processKernel<SampleType, Algorithm::convolution, Layout::stereo, isEco>;
+
+    if (tank == Algorithm::fdn)
+        return mono ? &ReverbEngine::processKernel<SampleType, Algorithm::fdn, Layout::mono, isEco>
+                    : &ReverbEngine::processKernel<SampleType, Algorithm::fdn, Layout::stereo, isEco>;
+
+    return mono ? &ReverbEngine::processKernel<SampleType, Algorithm::classic, Layout::mono, isEco>
+                : &ReverbEngine::processKernel<SampleType, Algorithm::classic, Layout::stereo, isEco>;
+}
+
+template <typename SampleType>
+void ReverbEngine::process(juce::AudioBuffer<SampleType>& buffer, const float* wetScale)
+{
+    // prepare() picks kernels for the prepared layout; a mono bus on the
+    // stereo setup picks again on its first block
+    if (buffer.getNumChannels() != kernelChannels)
+        selectKernels(buffer.getNumChannels());
+
+    if constexpr (std::is_same_v<SampleType, float>)
+        (this->*floatKernel)(buffer, wetScale);
+    else
+        (this->*doubleKernel)(buffer, wetScale);
+}
+
+template <typename SampleType, ReverbEngine::Algorithm tank, ReverbEngine::Layout layout, bool isEco>
+void ReverbEngine::processKernel(juce::AudioBuffer<SampleType>& buffer, const float* wetScale)
+{
+    applyPendingChanges(algorithm);
+
+    if constexpr (! isEco)
+    {
+        processTank<tank, layout>(buffer.getArrayOfWritePointers(), buffer.getNumChannels(),
+                                  buffer.getNumSamples(), wetScale);
+    }
+    else
+    {
+        // The tank makes wet only, at the low rate; ducking and the dry signal
+        // go on after upsampling, delayed to line up with it
+        const int numLowRate = eco.down(buffer, wetScale);
+
+        const int numTankChannels = juce::jmin(buffer.getNumChannels(), numChannels);
+        float* lowRate[maxChannels] = {};
+
+        for (int ch = 0; ch < numTankChannels; ++ch)
+            lowRate[ch] = eco.getLowRateChannel(ch);
+
+        if (numLowRate > 0)
+            processTank<tank, layout>(lowRate, numTankChannels, numLowRate, nullptr);
+
+        eco.mix(buffer, numLowRate, ecoDryGain);
+    }
+}
+
+template <ReverbEngine::Algorithm tank, ReverbEngine::Layout layout, typename SampleType>
+void ReverbEngine::processTank(SampleType* const* channels, int numTankChannels, int numSamples, const float* wetScale)
+{
+    const auto run = [&](auto& t)
+        {
+            if constexpr (layout == Layout::mono)
+                t.processMono(channels[0], numSamples, wetScale);
+            else
+                t.processStereo(channels[0], channels[1], numSamples, wetScale);
+        };
+
+    juce::ignoreUnused(numTankChannels);
+
+    if constexpr (layout == Layout::surround)
+    {
+        // The bank runs all the channels it was prepared for or none
+        jassert(numTankChannels >= numChannels);
+
+        if (numTankChannels >= numChannels)
+            surround.process(channels, numSamples, wetScale);
+    }
+    else if constexpr (tank == Algorithm::convolution)
+    {
+        run(convolution);
+    }
+    else if constexpr (tank == Algorithm::fdn)
+    {
+        run(fdn);
+    }
+    else
+    {
+        run(freeverb);
+    }
+}
+
+template void ReverbEngine::process(juce::AudioBuffer<float>&, const float*);
+template void ReverbEngine::process(juce::AudioBuffer<double>&, const float*);
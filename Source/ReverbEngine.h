@@ -1,19 +1,148 @@
 #pragma once
 #include <JuceHeader.h>
+#include "FreeverbBank.h"
+#include "FdnReverb.h"
+#include "ConvolutionReverb.h"
+#include "HalfBandResampler.h"
+#include "MultichannelBank.h"
 
 class ReverbEngine
 {
 public:
-    void prepare(double sampleRate, int samplesPerBlock);
+    // Classic = Freeverb comb/allpass bank, Fdn = 8-line SIMD feedback delay network,
+    // Convolution = partitioned FFT convolution with a loaded impulse response
+    enum class Algorithm { classic, fdn, convolution };
+
+    static constexpr int maxChannels = MultichannelBank::maxChannels;
+
+    // ecoFactor 2 or 4 runs the tanks at sampleRate / ecoFactor behind
+    // half-band resamplers (see EcoResampler), for less CPU per voice at the
+    // cost of getLatencySamples() and top-octave detail in the wet signal.
+    //
+    // Mono and stereo layouts run the selected algorithm. Anything wider
+    // (5.1, 7.1.4, ...) runs a MultichannelBank whatever the algorithm: the
+    // FDN and convolution tanks only exist in mono and stereo.
+    void prepare(double sampleRate, int samplesPerBlock, int ecoFactor = 1,
+                 const juce::AudioChannelSet& layout = juce::AudioChannelSet::stereo());
     void reset();
 
+    void setAlgorithm(Algorithm newAlgorithm);
+    Algorithm getAlgorithm() const { return algorithm; }
+
+    int getEcoFactor() const noexcept { return ecoFactor; }
+
+    // True when the prepared layout is wider than stereo
+    bool isMultichannel() const noexcept { return numChannels > 2; }
+
+    // Delay of the whole output, dry included, in host-rate samples
+    int getLatencySamples() const noexcept { return ecoFactor > 1 ? eco.getLatencySamples() : 0; }
+
+    void loadImpulseResponse(const juce::File& file) { convolution.loadImpulseResponse(file); }
+    juce::File getImpulseResponseFile() const { return convolution.getImpulseResponseFile(); }
+    bool isImpulseResponseLoading() const { return convolution.isLoading(); }
+
+    // Cheap to call every block: unchanged values are ignored, and changes
+    // reach a tank only when it next processes (or is switched to). Each
+    // tank then ramps its coefficients per sample.
     void setWet(float value);
     void setDecay(float seconds);
     void setWidth(float value);
 
-    void process(juce::AudioBuffer<float>& buffer);
+    // Latest values passed to the setters
+    float getWet() const noexcept { return wetLevel; }
+    float getDecay() const noexcept { return decaySeconds; }
+
+    // Seconds until the given tank has decayed by attenuationDb after its
+    // input stops, if it were running with this DECAY. Multichannel layouts
+    // always answer for the MultichannelBank.
+    double getTailSeconds(Algorithm tank, float decaySeconds, float attenuationDb) const;
+
+    // Longest the current tank can hold on to input without any of it
+    // showing at the output, eco resamplers included. Once the output has
+    // been quiet for this long with no input, so is everything inside.
+    double getLongestPathSeconds() const;
+
+    // wetScale, if given, holds one wet gain per sample of the buffer
+    // (see DuckEnvelope); it is applied on top of the wet level.
+    //
+    // Compiled for float and double buffers. The tanks keep their state in
+    // float either way; with double buffers the dry signal and the final mix
+    // stay in double, so nothing is converted beyond what the tanks take in.
+    //
+    // Runs through a kernel compiled for the sample type, tank, channel
+    // layout and eco mode, picked by prepare() and setAlgorithm() rather
+    // than per block.
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer, const float* wetScale = nullptr);
+
+    // Bit-exact snapshot of everything that carries over between blocks:
+    // delay lines, positions, filter memories, smoothers and, in eco mode,
+    // the resamplers. Only the active tank's buffers are stored, since
+    // switching tanks resets them anyway. Snapshots are for the same build,
+    // sample rate, eco factor and channel count, and both calls must happen
+    // on the processing thread (or while it is stopped). A snapshot that
+    // doesn't match is rejected, leaving the engine reset if that was only
+    // found part-way through.
+    juce::MemoryBlock createSnapshot() const;
+    bool restoreSnapshot(const void* data, size_t numBytes);
 
 private:
-    juce::Reverb reverb;
-    juce::Reverb::Parameters params;
+    enum Change : juce::uint8
+    {
+        wetChanged   = 1 << 0,
+        decayChanged = 1 << 1,
+        widthChanged = 1 << 2,
+        allChanged   = wetChanged | decayChanged | widthChanged
+    };
+
+    // How the tank sees the buffer: mono and stereo run the selected
+    // algorithm, surround always the MultichannelBank
+    enum class Layout { mono, stereo, surround };
+
+    template <typename SampleType>
+    using Kernel = void (ReverbEngine::*)(juce::AudioBuffer<SampleType>&, const float*);
+
+    void markChanged(juce::uint8 change) noexcept;
+    void applyPendingChanges(Algorithm tank) noexcept;
+    void updateEcoDryGain() noexcept;
+
+    // Picks the kernels for the current tank and eco mode, for buffers of
+    // numBufferChannels channels
+    void selectKernels(int numBufferChannels) noexcept;
+
+    template <typename SampleType, bool isEco>
+    static Kernel<SampleType> findKernel(Layout layout, Algorithm tank) noexcept;
+
+    template <typename SampleType, Algorithm tank, Layout layout, bool isEco>
+    void processKernel(juce::AudioBuffer<SampleType>& buffer, const float* wetScale);
+
+    template <Algorithm tank, Layout layout, typename SampleType>
+    void processTank(SampleType* const* channels, int numTankChannels, int numSamples, const float* wetScale);
+
+    Algorithm algorithm = Algorithm::classic;
+    double hostSampleRate = 44100.0;
+
+    float wetLevel = 0.3f, decaySeconds = 3.0f, width = 1.0f;
+
+    // Settings each tank (indexed by Algorithm) hasn't been given yet
+    juce::uint8 pendingChanges[3] = {};
+
+    FreeverbBank freeverb;
+    FdnReverb fdn;
+    ConvolutionReverb convolution;
+
+    // Replaces all three above for layouts wider than stereo. Settings go
+    // straight to it: its setters only retarget smoothers.
+    int numChannels = 2;
+    MultichannelBank surround;
+
+    // Eco mode: the tanks only produce wet, and the dry signal is mixed in
+    // here after upsampling, with the same law the tanks use
+    int ecoFactor = 1;
+    EcoResampler eco;
+    juce::SmoothedValue<float> ecoDryGain;
+
+    Kernel<float> floatKernel = nullptr;
+    Kernel<double> doubleKernel = nullptr;
+    int kernelChannels = 0;     // buffer channel count the kernels are for
 };
@@ -0,0 +1,40 @@
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+// The processing path is compiled for float and double host buffers, while
+// the tanks, analysis and control signals keep their state in float. These
+// bring host samples across where a float copy is needed anyway, so double
+// blocks never take a separate conversion pass.
+//==============================================================================
+namespace SampleConversion
+{
+    template <typename SampleType>
+    void toFloat(float* dest, const SampleType* source, int numSamples) noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            juce::FloatVectorOperations::copy(dest, source, numSamples);
+        }
+        else
+        {
+            for (int i = 0; i < numSamples; ++i)
+                dest[i] = (float)source[i];
+        }
+    }
+
+    // |source|, as float
+    template <typename SampleType>
+    void absToFloat(float* dest, const SampleType* source, int numSamples) noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            juce::FloatVectorOperations::abs(dest, source, numSamples);
+        }
+        else
+        {
+            for (int i = 0; i < numSamples; ++i)
+                dest[i] = (float)std::abs(source[i]);
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#include "SilenceGate.h"
+
+namespace
+{
+    // Below decibelsToGain's default floor of -100 dB, which would give 0
+    const float thresholdGain = juce::Decibels::decibelsToGain(SilenceGate::thresholdDb,
+                                                               SilenceGate::thresholdDb - 1.0f);
+}
+
+//==============================================================================
+void SilenceGate::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    reset();
+}
+
+void SilenceGate::reset()
+{
+    asleep = false;
+    quietSamples = 0;
+}
+
+//==============================================================================
+template <typename SampleType>
+bool SilenceGate::isAudible(const juce::AudioBuffer<SampleType>& block) noexcept
+{
+    const int numSamples = block.getNumSamples();
+
+    for (int ch = 0; ch < block.getNumChannels(); ++ch)
+        if (block.getMagnitude(ch, 0, numSamples) >= (SampleType)thresholdGain)
+            return true;
+
+    return false;
+}
+
+bool SilenceGate::isAudible(float peak) noexcept
+{
+    return peak >= thresholdGain;
+}
+
+bool SilenceGate::shouldProcess(bool inputAudible) noexcept
+{
+    if (inputAudible)
+        asleep = false;
+
+    return !asleep;
+}
+
+template <typename SampleType>
+bool SilenceGate::update(bool inputAudible, const juce::AudioBuffer<SampleType>& output, double holdSeconds) noexcept
+{
+    jassert(!asleep);
+
+    // Judged at the output, where dry and wet both count
+    if (inputAudible || isAudible(output))
+    {
+        quietSamples = 0;
+        return false;
+    }
+
+    quietSamples += output.getNumSamples();
+
+    if (quietSamples <= (juce::int64)std::ceil(holdSeconds * sampleRate))
+        return false;
+
+    asleep = true;
+    quietSamples = 0;
+    return true;
+}
+
+template bool SilenceGate::isAudible(const juce::AudioBuffer<float>&) noexcept;
+template bool SilenceGate::isAudible(const juce::AudioBuffer<double>&) noexcept;
+template bool SilenceGate::update(bool, const juce::AudioBuffer<float>&, double) noexcept;
+template bool SilenceGate::update(bool, const juce::AudioBuffer<double>&, double) noexcept;
+
+//==============================================================================
+void SilenceGate::saveState(juce::OutputStream& out) const
+{
+    SnapshotIO::write(out, asleep);
+    SnapshotIO::write(out, quietSamples);
+}
+
+bool SilenceGate::restoreState(juce::InputStream& in)
+{
+    return SnapshotIO::read(in, asleep) && SnapshotIO::read(in, quietSamples);
+}
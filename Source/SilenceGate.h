@@ -0,0 +1,53 @@
+#pragma once
+#include <JuceHeader.h>
+#include "SnapshotIO.h"
+
+//==============================================================================
+// Decides when the reverb can stop running because nothing is left to hear.
+//
+// The engine goes to sleep once its input has been below the threshold, and
+// its output has stayed there, for longer than the engine can hold on to a
+// sample without any of it reaching the output (see
+// ReverbEngine::getLongestPathSeconds). By then everything still circulating
+// is below the threshold too, so the caller clears the engine and outputs
+// silence without running it.
+//
+// It wakes on the first block with audible input and that block runs in
+// full. The engine starts it from a cleared state, so the output is exactly
+// what a running engine that had been cleared would give: no onset is lost
+// or late.
+//==============================================================================
+class SilenceGate
+{
+public:
+    static constexpr float thresholdDb = -120.0f;
+
+    void prepare(double sampleRate);
+    void reset();
+
+    // True if any sample on any channel reaches the threshold
+    template <typename SampleType>
+    static bool isAudible(const juce::AudioBuffer<SampleType>& block) noexcept;
+
+    // The same test on a block's largest magnitude, where one has been
+    // measured already
+    static bool isAudible(float peak) noexcept;
+
+    // Before a block: wakes up if the input is audible. Returns whether the
+    // engine has to run the block.
+    bool shouldProcess(bool inputAudible) noexcept;
+
+    // After the engine has run a block. Returns true if the gate has just
+    // gone to sleep, in which case the caller clears the engine.
+    template <typename SampleType>
+    bool update(bool inputAudible, const juce::AudioBuffer<SampleType>& output, double holdSeconds) noexcept;
+
+    void saveState(juce::OutputStream& out) const;
+    bool restoreState(juce::InputStream& in);
+
+private:
+    double sampleRate = 44100.0;
+
+    bool asleep = false;
+    juce::int64 quietSamples = 0;
+};
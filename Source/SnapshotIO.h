@@ -0,0 +1,41 @@
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+// Binary helpers for engine snapshots.
+//
+// Snapshots are read back by the same build (checkpoints, warmed-up states
+// for offline renders), so values go in as their raw in-memory bytes. That
+// keeps restores bit-exact, smoothers and SIMD registers included.
+//==============================================================================
+namespace SnapshotIO
+{
+    template <typename Type>
+    void write(juce::OutputStream& out, const Type& value)
+    {
+        static_assert(std::is_trivially_copyable<Type>::value, "Only plain values can be snapshotted");
+        out.write(&value, sizeof(Type));
+    }
+
+    template <typename Type>
+    bool read(juce::InputStream& in, Type& value)
+    {
+        static_assert(std::is_trivially_copyable<Type>::value, "Only plain values can be snapshotted");
+        return in.read(&value, (int)sizeof(Type)) == (int)sizeof(Type);
+    }
+
+    template <typename Type>
+    void writeArray(juce::OutputStream& out, const Type* data, size_t count)
+    {
+        static_assert(std::is_trivially_copyable<Type>::value, "Only plain values can be snapshotted");
+        out.write(data, count * sizeof(Type));
+    }
+
+    template <typename Type>
+    bool readArray(juce::InputStream& in, Type* data, size_t count)
+    {
+        static_assert(std::is_trivially_copyable<Type>::value, "Only plain values can be snapshotted");
+        const auto numBytes = (int)(count * sizeof(Type));
+        return in.read(data, numBytes) == numBytes;
+    }
+}
@@ -0,0 +1,260 @@
+#include "SpectrumAnalyzer.h"
+
+namespace
+{
+    // How fast a band falls back after a peak
+    constexpr float releaseDecibelsPerSecond = 40.0f;
+
+    // Hann window gain: a full-scale sine peaks at fftSize / 4
+    constexpr float fullScaleMagnitude = SpectrumAnalyzer::fftSize / 4.0f;
+}
+
+//==============================================================================
+SpectrumAnalyzer::SpectrumAnalyzer()
+    : juce::Thread("Spectrum Analyzer")
+{
+    ringData.allocate((size_t)(numSlots * ringSize), true);
+
+    for (int i = 0; i < numSlots; ++i)
+        slots[i] = ringData.get() + i * ringSize;
+
+    history.allocate((size_t)(2 * fftSize), true);
+    fftData.allocate((size_t)(2 * fftSize), true);
+
+    inputLevels.fill(minDecibels);
+    outputLevels.fill(minDecibels);
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+    stop();
+}
+
+//==============================================================================
+void SpectrumAnalyzer::start()
+{
+    if (running.load())
+        return;
+
+    // Nothing is consuming while the thread is stopped, so it is safe to drop
+    // whatever is left over from last time here
+    ring.finishedRead(ring.getNumReady());
+
+    juce::FloatVectorOperations::clear(history.get(), 2 * fftSize);
+    historyFill = 0;
+
+    inputLevels.fill(minDecibels);
+    outputLevels.fill(minDecibels);
+
+    running.store(true);
+    startThread();
+}
+
+void SpectrumAnalyzer::stop()
+{
+    running.store(false);
+    stopThread(2000);
+}
+
+//==============================================================================
+template <typename SampleType>
+void SpectrumAnalyzer::captureInput(const juce::AudioBuffer<SampleType>& block) noexcept
+{
+    reserved = 0;
+
+    const int numSamples = block.getNumSamples();
+
+    if (!running.load(std::memory_order_relaxed) || numSamples == 0 || ring.getFreeSpace() < numSamples)
+        return;
+
+    ring.prepareToWrite(numSamples, start1, size1, start2, size2);
+    copyChannels(block, slots, start1, size1, start2, size2);
+    reserved = numSamples;
+}
+
+template <typename SampleType>
+void SpectrumAnalyzer::captureOutput(const juce::AudioBuffer<SampleType>& block) noexcept
+{
+    if (reserved == 0)
+        return;
+
+    jassert(block.getNumSamples() == reserved);
+
+    copyChannels(block, slots + 2, start1, size1, start2, size2);
+    ring.finishedWrite(reserved);
+    reserved = 0;
+}
+
+template <typename SampleType>
+void SpectrumAnalyzer::copyChannels(const juce::AudioBuffer<SampleType>& block, float* const* destinations,
+                                    int firstStart, int firstSize, int secondStart, int secondSize) noexcept
+{
+    using FVO = juce::FloatVectorOperations;
+
+    for (int slot = 0; slot < 2; ++slot)
+    {
+        float* dest = destinations[slot];
+
+        if (block.getNumChannels() == 0)
+        {
+            FVO::clear(dest + firstStart, firstSize);
+            FVO::clear(dest + secondStart, secondSize);
+            continue;
+        }
+
+        // Mono fills both slots, so the reader can always fold L and R
+        const auto* source = block.getReadPointer(juce::jmin(slot, block.getNumChannels() - 1));
+
+        SampleConversion::toFloat(dest + firstStart, source, firstSize);
+        SampleConversion::toFloat(dest + secondStart, source + firstSize, secondSize);
+    }
+}
+
+template void SpectrumAnalyzer::captureInput(const juce::AudioBuffer<float>&) noexcept;
+template void SpectrumAnalyzer::captureInput(const juce::AudioBuffer<double>&) noexcept;
+template void SpectrumAnalyzer::captureOutput(const juce::AudioBuffer<float>&) noexcept;
+template void SpectrumAnalyzer::captureOutput(const juce::AudioBuffer<double>&) noexcept;
+
+//==============================================================================
+bool SpectrumAnalyzer::pullSpectrum(Spectrum& dest) noexcept
+{
+    if ((middle.load(std::memory_order_acquire) & freshFlag) == 0)
+        return false;
+
+    frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & ~freshFlag;
+    dest = spectra[(size_t)frontIndex];
+    return true;
+}
+
+void SpectrumAnalyzer::publish() noexcept
+{
+    backIndex = middle.exchange(backIndex | freshFlag, std::memory_order_acq_rel) & ~freshFlag;
+}
+
+float SpectrumAnalyzer::getFrequencyPosition(float frequency) noexcept
+{
+    return std::log(frequency / minFrequency) / std::log(maxFrequency / minFrequency);
+}
+
+//==============================================================================
+void SpectrumAnalyzer::run()
+{
+    using FVO = juce::FloatVectorOperations;
+
+    float* input = history.get();
+    float* output = history.get() + fftSize;
+
+    while (!threadShouldExit())
+    {
+        // Take a hop at a time, folding each stream's L and R into the newest
+        // end of its history
+        while (ring.getNumReady() > 0 && !threadShouldExit())
+        {
+            const auto scope = ring.read(juce::jmin(ring.getNumReady(), hopSize - historyFill));
+
+            for (auto [start, size] : { std::pair<int, int>{ scope.startIndex1, scope.blockSize1 },
+                                        std::pair<int, int>{ scope.startIndex2, scope.blockSize2 } })
+            {
+                const int offset = fftSize - hopSize + historyFill;
+
+                FVO::add(input + offset, slots[0] + start, slots[1] + start, size);
+                FVO::add(output + offset, slots[2] + start, slots[3] + start, size);
+
+                historyFill += size;
+            }
+
+            if (historyFill == hopSize)
+            {
+                FVO::multiply(input + fftSize - hopSize, 0.5f, hopSize);
+                FVO::multiply(output + fftSize - hopSize, 0.5f, hopSize);
+
+                analyse();
+
+                std::memmove(input, input + hopSize, sizeof(float) * (size_t)(fftSize - hopSize));
+                std::memmove(output, output + hopSize, sizeof(float) * (size_t)(fftSize - hopSize));
+                historyFill = 0;
+            }
+        }
+
+        wait(5);
+    }
+}
+
+void SpectrumAnalyzer::analyse()
+{
+    const double rate = sampleRate.load();
+
+    if (rate != bandRate)
+        updateBands(rate);
+
+    auto& spectrum = spectra[(size_t)backIndex];
+
+    computeBands(history.get(), inputLevels, spectrum.input);
+    computeBands(history.get() + fftSize, outputLevels, spectrum.output);
+
+    publish();
+}
+
+void SpectrumAnalyzer::updateBands(double rate)
+{
+    bandRate = rate;
+
+    const float binsPerHertz = (float)(fftSize / rate);
+    const float ratio = maxFrequency / minFrequency;
+
+    for (int b = 0; b <= numBands; ++b)
+        bandEdges[(size_t)b] = minFrequency * std::pow(ratio, (float)b / numBands) * binsPerHertz;
+
+    releasePerHop = releaseDecibelsPerSecond * (float)(hopSize / rate);
+}
+
+void SpectrumAnalyzer::computeBands(const float* samples, std::array<float, numBands>& levels,
+                                    std::array<float, numBands>& bands)
+{
+    juce::FloatVectorOperations::copy(fftData.get(), samples, fftSize);
+    window.multiplyWithWindowingTable(fftData.get(), (size_t)fftSize);
+    fft.performFrequencyOnlyForwardTransform(fftData.get(), true);
+
+    const float* magnitude = fftData.get();
+    constexpr int nyquistBin = fftSize / 2;
+
+    for (int b = 0; b < numBands; ++b)
+    {
+        const float lower = bandEdges[(size_t)b];
+        const float upper = bandEdges[(size_t)b + 1];
+
+        float bandMagnitude = 0.0f;
+
+        if (lower >= (float)nyquistBin)
+        {
+            // Above Nyquist at this sample rate
+        }
+        else if (upper - lower < 1.0f)
+        {
+            // Low bands are narrower than a bin: read between the two
+            // nearest bins instead
+            const float centre = std::sqrt(lower * upper);
+            const int bin = juce::jmin((int)centre, nyquistBin - 1);
+            const float fraction = centre - (float)bin;
+
+            bandMagnitude = magnitude[bin] + fraction * (magnitude[bin + 1] - magnitude[bin]);
+        }
+        else
+        {
+            // Wider bands show the strongest bin they cover, so a tone reads
+            // at its true level whichever band it lands in
+            const int first = juce::roundToInt(lower);
+            const int last = juce::jlimit(first + 1, nyquistBin + 1, juce::roundToInt(upper));
+
+            bandMagnitude = juce::FloatVectorOperations::findMaximum(magnitude + first, last - first);
+        }
+
+        const float decibels = juce::Decibels::gainToDecibels(bandMagnitude / fullScaleMagnitude, minDecibels);
+
+        // Jump up to peaks, fall back at a fixed rate
+        auto& level = levels[(size_t)b];
+        level = juce::jmax(decibels, level - releasePerHop);
+
+        bands[(size_t)b] = juce::jlimit(0.0f, 1.0f, (level - minDecibels) / -minDecibels);
+    }
+}
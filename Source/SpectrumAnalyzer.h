@@ -0,0 +1,108 @@
+#pragma once
+#include <JuceHeader.h>
+#include "SampleConversion.h"
+
+//==============================================================================
+// Input and output spectra for the editor's analyzer panel.
+//
+// The audio thread only copies samples into a preallocated ring (one slot per
+// channel of input and output, at most two each). A background thread pulls
+// them out in hops, runs Hann-windowed FFTs and folds the bins into a fixed
+// set of log-spaced bands, and the editor picks up the newest finished
+// spectrum through a triple buffer. Nothing on the audio or message thread
+// allocates, locks or transforms.
+//
+// The analysis thread only runs between start() and stop(), i.e. while an
+// editor is open; otherwise the audio thread skips the copies as well.
+//==============================================================================
+class SpectrumAnalyzer : private juce::Thread
+{
+public:
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 4;
+    static constexpr int numBands = 96;
+
+    static constexpr float minFrequency = 20.0f;
+    static constexpr float maxFrequency = 20000.0f;
+    static constexpr float minDecibels = -90.0f;
+
+    // Ready-to-draw levels per band, 0 (minDecibels or below) to 1 (0 dBFS)
+    struct Spectrum
+    {
+        std::array<float, numBands> input{}, output{};
+    };
+
+    SpectrumAnalyzer();
+    ~SpectrumAnalyzer() override;
+
+    // Any thread; the band layout follows on the next analysis
+    void setSampleRate(double newSampleRate) noexcept { sampleRate.store(newSampleRate); }
+
+    // Message thread
+    void start();
+    void stop();
+
+    // Audio thread, once per block: the input before processing, then the
+    // output of the same block. Blocks that don't fit are skipped whole, so
+    // input and output always stay aligned.
+    // Float and double blocks alike; the analysis runs in float.
+    template <typename SampleType>
+    void captureInput(const juce::AudioBuffer<SampleType>& block) noexcept;
+
+    template <typename SampleType>
+    void captureOutput(const juce::AudioBuffer<SampleType>& block) noexcept;
+
+    // Message thread: copies the newest spectrum into dest if one has arrived
+    // since the last call
+    bool pullSpectrum(Spectrum& dest) noexcept;
+
+    // Where a frequency sits along the band axis, 0 (minFrequency) to 1
+    // (maxFrequency), for drawing grid lines
+    static float getFrequencyPosition(float frequency) noexcept;
+
+private:
+    static constexpr int ringSize = 1 << 14;
+    static constexpr int numSlots = 4; // input L/R, output L/R
+
+    void run() override;
+    void analyse();
+    void updateBands(double rate);
+    void computeBands(const float* samples, std::array<float, numBands>& levels, std::array<float, numBands>& bands);
+    void publish() noexcept;
+
+    template <typename SampleType>
+    static void copyChannels(const juce::AudioBuffer<SampleType>& block, float* const* destinations,
+                             int firstStart, int firstSize, int secondStart, int secondSize) noexcept;
+
+    std::atomic<double> sampleRate{ 44100.0 };
+    std::atomic<bool> running{ false };
+
+    // Audio thread -> analysis thread
+    juce::AbstractFifo ring{ ringSize };
+    juce::HeapBlock<float> ringData;
+    float* slots[numSlots] = {};
+
+    // Audio thread only: space reserved by captureInput
+    int reserved = 0, start1 = 0, size1 = 0, start2 = 0, size2 = 0;
+
+    // Analysis thread only
+    juce::dsp::FFT fft{ fftOrder };
+    juce::dsp::WindowingFunction<float> window{ (size_t)fftSize, juce::dsp::WindowingFunction<float>::hann, false };
+    juce::HeapBlock<float> history;     // [input | output], fftSize each
+    juce::HeapBlock<float> fftData;     // 2 * fftSize, as juce::dsp::FFT needs
+    int historyFill = 0;
+    double bandRate = 0.0;
+    std::array<float, numBands + 1> bandEdges{};  // band boundaries, in FFT bins
+    std::array<float, numBands> inputLevels{}, outputLevels{};
+    float releasePerHop = 0.0f;
+
+    // Analysis thread -> message thread triple buffer. The writer owns
+    // back, the reader owns front, and they swap through middle.
+    std::array<Spectrum, 3> spectra;
+    int backIndex = 0, frontIndex = 2;
+    std::atomic<int> middle{ 1 };
+    static constexpr int freshFlag = 4;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumAnalyzer)
+};
@@ -0,0 +1,445 @@
+#include "WorkerPool.h"
+
+//==============================================================================
+class WorkerPool::Worker : public juce::Thread
+{
+public:
+    explicit Worker(WorkerPool& p) : juce::Thread("Reverb Worker"), pool(p) {}
+
+    ~Worker() override
+    {
+        stopThread(4000);
+    }
+
+    void run() override
+    {
+        // Jobs are audio processing, with the same FTZ/DAZ as the host's thread
+        juce::ScopedNoDenormals noDenormals;
+
+        while (!threadShouldExit())
+        {
+            Entry entry;
+
+            if (pool.pop(entry))
+            {
+                pool.runQueued(entry);
+                continue;
+            }
+
+            // Announce the sleep before the last look at the queue, so a
+            // submit either sees a sleeper to wake or leaves a job to find
+            pool.numSleeping.fetch_add(1);
+
+            if (pool.pop(entry))
+            {
+                pool.numSleeping.fetch_sub(1);
+                pool.runQueued(entry);
+                continue;
+            }
+
+            pool.wakeUp.wait(50);
+            pool.numSleeping.fetch_sub(1);
+        }
+    }
+
+private:
+    WorkerPool& pool;
+};
+
+//==============================================================================
+WorkerPool::WorkerPool()
+{
+    for (size_t i = 0; i < queueSize; ++i)
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+
+    // Leave one core for the host's own audio thread
+    const int numWorkers = juce::jmax(1, juce::SystemStats::getNumPhysicalCpus() - 1);
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto* worker = workers.add(new Worker(*this));
+
+        if (!worker->startRealtimeThread(juce::Thread::RealtimeOptions{}.withPriority(9)))
+            worker->startThread(juce::Thread::Priority::highest);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    for (auto* worker : workers)
+        worker->signalThreadShouldExit();
+
+    for (int i = 0; i < workers.size(); ++i)
+        wakeUp.signal();
+
+    workers.clear();
+}
+
+//==============================================================================
+int WorkerPool::attach(Job& job) noexcept
+{
+    for (int i = 0; i < maxJobs; ++i)
+    {
+        auto& slot = slots[(size_t)i];
+        bool expected = false;
+
+        if (slot.attached.compare_exchange_strong(expected, true, std::memory_order_acquire))
+        {
+            slot.job.store(&job, std::memory_order_release);
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void WorkerPool::detach(int index) noexcept
+{
+    jassert(juce::isPositiveAndBelow(index, maxJobs));
+    auto& slot = slots[(size_t)index];
+
+    // Move the generation on, so no entry still in the queue can start the
+    // job, but not under a worker that already has
+    for (auto ticket = slot.ticket.load(std::memory_order_acquire);;)
+    {
+        if (getState(ticket) == running)
+        {
+            juce::Thread::sleep(1);
+            ticket = slot.ticket.load(std::memory_order_acquire);
+        }
+        else if (slot.ticket.compare_exchange_weak(ticket, makeTicket(getGeneration(ticket) + 1, idle),
+                                                   std::memory_order_acq_rel))
+        {
+            break;
+        }
+    }
+
+    slot.job.store(nullptr, std::memory_order_relaxed);
+    slot.attached.store(false, std::memory_order_release);
+}
+
+bool WorkerPool::submit(int index) noexcept
+{
+    jassert(juce::isPositiveAndBelow(index, maxJobs));
+    auto& slot = slots[(size_t)index];
+
+    const auto ticket = slot.ticket.load(std::memory_order_relaxed);
+    jassert(getState(ticket) == idle);
+
+    // Release: the worker that starts the job must see the block it was given
+    const auto generation = getGeneration(ticket) + 1;
+    slot.ticket.store(makeTicket(generation, queued), std::memory_order_release);
+
+    if (!push({ index, generation }))
+    {
+        slot.ticket.store(makeTicket(generation, idle), std::memory_order_relaxed);
+        return false;
+    }
+
+    if (numSleeping.load() > 0)
+        wakeUp.signal();
+
+    return true;
+}
+
+WorkerPool::Collected WorkerPool::collect(int index) noexcept
+{
+    jassert(juce::isPositiveAndBelow(index, maxJobs));
+    auto& slot = slots[(size_t)index];
+
+    auto ticket = slot.ticket.load(std::memory_order_acquire);
+
+    // Nobody has started it: take it back. Losing the race means a worker
+    // just has, and the state is looked at again.
+    while (getState(ticket) == queued)
+        if (slot.ticket.compare_exchange_weak(ticket, makeTicket(getGeneration(ticket), idle), std::memory_order_acquire))
+            return Collected::notStarted;
+
+    if (getState(ticket) == running)
+        return Collected::running;
+
+    jassert(getState(ticket) == done);
+    slot.ticket.store(makeTicket(getGeneration(ticket), idle), std::memory_order_relaxed);
+    return Collected::finished;
+}
+
+void WorkerPool::runQueued(Entry entry) noexcept
+{
+    auto& slot = slots[(size_t)entry.slot];
+    auto expected = makeTicket(entry.generation, queued);
+
+    // Lost to collect(), or a stale entry for a job that has moved on or
+    // been detached
+    if (!slot.ticket.compare_exchange_strong(expected, makeTicket(entry.generation, running), std::memory_order_acquire))
+        return;
+
+    // detach() waits while the job is running, so it stays attached
+    slot.job.load(std::memory_order_acquire)->run();
+    slot.ticket.store(makeTicket(entry.generation, done), std::memory_order_release);
+}
+
+//==============================================================================
+bool WorkerPool::push(Entry entry) noexcept
+{
+    auto position = pushPosition.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        auto& cell = cells[position & (queueSize - 1)];
+        const auto sequence = cell.sequence.load(std::memory_order_acquire);
+        const auto difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)position;
+
+        if (difference == 0)
+        {
+            if (pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                cell.entry = entry;
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            return false;
+        }
+        else
+        {
+            position = pushPosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool WorkerPool::pop(Entry& entry) noexcept
+{
+    auto position = popPosition.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        auto& cell = cells[position & (queueSize - 1)];
+        const auto sequence = cell.sequence.load(std::memory_order_acquire);
+        const auto difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)(position + 1);
+
+        if (difference == 0)
+        {
+            if (popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                entry = cell.entry;
+                cell.sequence.store(position + queueSize, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            return false;
+        }
+        else
+        {
+            position = popPosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+BlockOffloader<SampleType>::BlockOffloader(Callback blockCallback)
+    : callback(std::move(blockCallback))
+{
+    job.owner = this;
+}
+
+template <typename SampleType>
+BlockOffloader<SampleType>::~BlockOffloader()
+{
+    release();
+}
+
+template <typename SampleType>
+void BlockOffloader<SampleType>::prepare(int newNumChannels, int maxBlockSize)
+{
+    release();
+
+    numChannels = juce::jmax(1, newNumChannels);
+    latency = juce::jmax(1, maxBlockSize);
+
+    job.block.setSize(numChannels, latency);
+    dry.setSize(numChannels, latency);
+
+    output.setSize(numChannels, 2 * latency);
+    output.clear();
+    outputStart = 0;
+    outputFill = latency;
+
+    inlineBlocksLeft = 0;
+    missedDeadlines.store(0, std::memory_order_relaxed);
+
+    pool = std::make_unique<juce::SharedResourcePointer<WorkerPool>>();
+    slot = (*pool)->attach(job);
+
+    // Every slot is taken: the processor runs its blocks itself
+    if (slot < 0)
+        pool.reset();
+}
+
+template <typename SampleType>
+void BlockOffloader<SampleType>::release()
+{
+    if (pool != nullptr)
+        (*pool)->detach(slot);
+
+    slot = -1;
+    inFlight = late = false;
+    pool.reset();
+}
+
+//==============================================================================
+template <typename SampleType>
+void BlockOffloader<SampleType>::process(juce::AudioBuffer<SampleType>& buffer) noexcept
+{
+    jassert(isActive());
+
+    const int numSamples = buffer.getNumSamples();
+
+    for (int start = 0; start < numSamples; start += latency)
+        processSlice(buffer, start, juce::jmin(latency, numSamples - start));
+}
+
+template <typename SampleType>
+void BlockOffloader<SampleType>::processSlice(juce::AudioBuffer<SampleType>& buffer, int start, int numSamples) noexcept
+{
+    // The previous block is due now
+    finishInFlight();
+
+    const int numBufferChannels = juce::jmin(numChannels, buffer.getNumChannels());
+
+    dry.setSize(numChannels, numSamples, false, false, true);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        if (ch < numBufferChannels)
+            dry.copyFrom(ch, 0, buffer, ch, start, numSamples);
+        else
+            dry.clear(ch, 0, numSamples);
+    }
+
+    if (late)
+    {
+        // The callback is still busy with an earlier block
+        recordMiss();
+        pushOutput(dry);
+        popOutput(buffer, start, numSamples);
+        return;
+    }
+
+    job.block.setSize(numChannels, numSamples, false, false, true);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        job.block.copyFrom(ch, 0, dry, ch, 0, numSamples);
+
+    if (inlineBlocksLeft > 0)
+    {
+        --inlineBlocksLeft;
+        callback(job.block);
+        pushOutput(job.block);
+    }
+    else if ((*pool)->submit(slot))
+    {
+        inFlight = true;
+    }
+    else
+    {
+        // Queue full: the pool is saturated
+        callback(job.block);
+        pushOutput(job.block);
+    }
+
+    popOutput(buffer, start, numSamples);
+}
+
+template <typename SampleType>
+void BlockOffloader<SampleType>::finishInFlight() noexcept
+{
+    if (late)
+    {
+        // Its time has passed; only the callback being free again matters
+        if ((*pool)->collect(slot) == WorkerPool::Collected::running)
+            return;
+
+        late = false;
+    }
+
+    if (!inFlight)
+        return;
+
+    inFlight = false;
+
+    switch ((*pool)->collect(slot))
+    {
+        case WorkerPool::Collected::finished:
+            pushOutput(job.block);
+            break;
+
+        case WorkerPool::Collected::notStarted:
+            recordMiss();
+            callback(job.block);
+            pushOutput(job.block);
+            break;
+
+        case WorkerPool::Collected::running:
+            recordMiss();
+            late = true;
+            pushOutput(dry);
+            break;
+    }
+}
+
+template <typename SampleType>
+void BlockOffloader<SampleType>::recordMiss() noexcept
+{
+    missedDeadlines.fetch_add(1, std::memory_order_relaxed);
+    inlineBlocksLeft = inlineBlocksAfterMiss;
+}
+
+template <typename SampleType>
+void BlockOffloader<SampleType>::pushOutput(const juce::AudioBuffer<SampleType>& block) noexcept
+{
+    const int numSamples = block.getNumSamples();
+    const int capacity = output.getNumSamples();
+
+    jassert(outputFill + numSamples <= capacity);
+
+    const int writePos = (outputStart + outputFill) % capacity;
+    const int first = juce::jmin(numSamples, capacity - writePos);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        output.copyFrom(ch, writePos, block, ch, 0, first);
+        output.copyFrom(ch, 0, block, ch, first, numSamples - first);
+    }
+
+    outputFill += numSamples;
+}
+
+template <typename SampleType>
+void BlockOffloader<SampleType>::popOutput(juce::AudioBuffer<SampleType>& buffer, int start, int numSamples) noexcept
+{
+    jassert(numSamples <= outputFill);
+
+    const int capacity = output.getNumSamples();
+    const int first = juce::jmin(numSamples, capacity - outputStart);
+    const int numBufferChannels = juce::jmin(numChannels, buffer.getNumChannels());
+
+    for (int ch = 0; ch < numBufferChannels; ++ch)
+    {
+        buffer.copyFrom(ch, start, output, ch, outputStart, first);
+        buffer.copyFrom(ch, start + first, output, ch, 0, numSamples - first);
+    }
+
+    for (int ch = numBufferChannels; ch < buffer.getNumChannels(); ++ch)
+        buffer.clear(ch, start, numSamples);
+
+    outputStart = (outputStart + numSamples) % capacity;
+    outputFill -= numSamples;
+}
+
+template class BlockOffloader<float>;
+template class BlockOffloader<double>;
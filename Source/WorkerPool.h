@@ -0,0 +1,200 @@
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+// Process-wide pool of worker threads that plugin instances can hand their
+// processing to, so a big session's instances spread over cores the host
+// doesn't schedule audio onto.
+//
+// Submitting and collecting never lock, allocate or wait. A job is attached
+// to one of the pool's own slots, and the queue holds slot numbers, never
+// pointers into the owner. Each slot's state is a single atomic, stamped with
+// a generation that moves on with every submit and detach, which the
+// submitting thread and the workers race for: a job no worker has started
+// can always be taken back and run where it is, and a queue entry left over
+// from an earlier submit or a detached job is recognised and dropped. Idle
+// workers sleep and are only signalled when one actually is asleep.
+//
+// Access it through juce::SharedResourcePointer<WorkerPool>; the threads run
+// for as long as anything holds it.
+//==============================================================================
+class WorkerPool
+{
+public:
+    class Job
+    {
+    public:
+        virtual ~Job() = default;
+
+        // On a worker. A job that no worker got to is handed back by
+        // collect() for its owner to run.
+        virtual void run() noexcept = 0;
+    };
+
+    enum class Collected
+    {
+        finished,       // a worker ran it in time
+        notStarted,     // taken back, for the caller to run
+        running         // a worker is still on it; collect again later
+    };
+
+    WorkerPool();
+    ~WorkerPool();
+
+    int getNumWorkers() const noexcept { return workers.size(); }
+
+    // Off the audio thread: gives the job a slot, or returns -1 if every slot
+    // is taken
+    int attach(Job& job) noexcept;
+
+    // Off the audio thread: waits for a worker that is running the job, drops
+    // any result and frees the slot. Queue entries for it are left to go
+    // stale, so the job can be destroyed as soon as this returns.
+    void detach(int slot) noexcept;
+
+    // Queues an attached job that isn't already in flight. Returns false,
+    // leaving the job idle, if the queue is full.
+    bool submit(int slot) noexcept;
+
+    // Never waits. Once finished or taken back the job is idle again; while
+    // it is running, nothing it uses may be touched.
+    Collected collect(int slot) noexcept;
+
+private:
+    class Worker;
+
+    static constexpr size_t queueSize = 1024;
+    static constexpr int maxJobs = (int)queueSize;
+
+    enum State { idle, queued, running, done };
+
+    // A slot's state in the low two bits, its generation above them
+    static juce::uint64 makeTicket(juce::uint64 generation, int state) noexcept { return (generation << 2) | (juce::uint64)state; }
+    static juce::uint64 getGeneration(juce::uint64 ticket) noexcept { return ticket >> 2; }
+    static int getState(juce::uint64 ticket) noexcept { return (int)(ticket & 3); }
+
+    struct Entry
+    {
+        int slot = -1;
+        juce::uint64 generation = 0;
+    };
+
+    bool push(Entry entry) noexcept;
+    bool pop(Entry& entry) noexcept;
+    void runQueued(Entry entry) noexcept;
+
+    struct Slot
+    {
+        std::atomic<juce::uint64> ticket{ 0 };
+        std::atomic<Job*> job{ nullptr };
+        std::atomic<bool> attached{ false };
+    };
+
+    std::array<Slot, maxJobs> slots;
+
+    // Bounded multi-producer, multi-consumer ring (Vyukov): a cell's
+    // sequence number says whether it is waiting for a push or a pop. A
+    // taken-back or detached job may leave a stale entry behind; whoever
+    // pops it finds the slot's ticket has moved on and drops it.
+    struct Cell
+    {
+        std::atomic<size_t> sequence{ 0 };
+        Entry entry;
+    };
+
+    std::array<Cell, queueSize> cells;
+    alignas(64) std::atomic<size_t> pushPosition{ 0 };
+    alignas(64) std::atomic<size_t> popPosition{ 0 };
+
+    juce::OwnedArray<Worker> workers;
+    std::atomic<int> numSleeping{ 0 };
+    juce::WaitableEvent wakeUp;
+
+    JUCE_DECLARE_NON_COPYABLE(WorkerPool)
+};
+
+//==============================================================================
+// Runs a block callback on the WorkerPool, one block behind the caller, for
+// float or double blocks.
+//
+// Each call hands the block's input to a worker and returns output from the
+// blocks before it, through a FIFO that starts with getLatencySamples() of
+// silence, so the delay is exactly that whatever the block sizes.
+//
+// The audio thread never waits for a worker. A block that is due and no
+// worker has started is taken back and run inline. A block a worker is still
+// running has missed its deadline: its dry input goes out in its place, and
+// so does every later block's until the worker is done, as the callback
+// can't run twice at once; the late result is dropped. After either kind of
+// miss the next few blocks run inline, still through the FIFO, before the
+// pool is tried again.
+//==============================================================================
+template <typename SampleType>
+class BlockOffloader
+{
+public:
+    using Callback = std::function<void(juce::AudioBuffer<SampleType>&)>;
+
+    explicit BlockOffloader(Callback callback);
+    ~BlockOffloader();
+
+    // With processing stopped: joins the pool and allocates for blocks of up
+    // to maxBlockSize samples, which becomes the latency. Stays inactive if
+    // the pool has no slot left.
+    void prepare(int numChannels, int maxBlockSize);
+
+    // With processing stopped: waits for a block still running on a worker,
+    // drops it and leaves the pool. process() must not be called again until
+    // prepare().
+    void release();
+
+    bool isActive() const noexcept { return pool != nullptr; }
+    int getLatencySamples() const noexcept { return isActive() ? latency : 0; }
+
+    // Blocks that missed their deadline since prepare(); any thread
+    int getNumMissedDeadlines() const noexcept { return missedDeadlines.load(std::memory_order_relaxed); }
+
+    // Audio thread. Longer blocks than prepared for are split up.
+    void process(juce::AudioBuffer<SampleType>& buffer) noexcept;
+
+private:
+    struct BlockJob : WorkerPool::Job
+    {
+        void run() noexcept override { owner->callback(block); }
+
+        BlockOffloader* owner = nullptr;
+        juce::AudioBuffer<SampleType> block;
+    };
+
+    void processSlice(juce::AudioBuffer<SampleType>& buffer, int start, int numSamples) noexcept;
+    void finishInFlight() noexcept;
+    void recordMiss() noexcept;
+    void pushOutput(const juce::AudioBuffer<SampleType>& block) noexcept;
+    void popOutput(juce::AudioBuffer<SampleType>& buffer, int start, int numSamples) noexcept;
+
+    // Blocks run inline after a missed deadline
+    static constexpr int inlineBlocksAfterMiss = 32;
+
+    Callback callback;
+    std::unique_ptr<juce::SharedResourcePointer<WorkerPool>> pool;
+
+    BlockJob job;
+    int slot = -1;
+
+    // Submitted and due at the next slice; or overdue, with its dry input
+    // already sent in its place, and still running on a worker
+    bool inFlight = false, late = false;
+    int inlineBlocksLeft = 0;
+
+    // The input of the slice in flight, which stands in for it if it is late
+    juce::AudioBuffer<SampleType> dry;
+    std::atomic<int> missedDeadlines{ 0 };
+
+    int numChannels = 0, latency = 0;
+
+    // Finished output, oldest first, in a ring of 2 * latency
+    juce::AudioBuffer<SampleType> output;
+    int outputStart = 0, outputFill = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(BlockOffloader)
+};
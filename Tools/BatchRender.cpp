@@ -0,0 +1,257 @@
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+
+//==============================================================================
+// LusionBatchRender
+//
+// Renders every file in a manifest through the plugin, one file per worker
+// thread:
+//
+//   LusionBatchRender --manifest=stems.txt --preset=hall.xml --out=renders
+//                     [--threads=N] [--block=512] [--tail=0] [--bits=24]
+//                     [--format=wav|flac]
+//                     [--chunks=N|auto] [--floor=-100] [--verify] [--isa=sse2]
+//
+// Manifest lines are "input" or "input<TAB>output"; blank lines and lines
+// starting with '#' are skipped. Without an explicit output, files go to
+// --out with the same name and the --format extension. Two lines that would
+// write the same file (say, inputs of one name from different directories)
+// end the run before anything is rendered; give one an explicit output.
+//
+// With --chunks, files are rendered one after another instead, each split
+// into N time chunks that run in parallel (auto = one per thread). Every
+// stitched file reports its measured seam deviation, which must stay below
+// --floor (dBFS); --verify also compares against a full serial render.
+//
+// The kernels are bit-identical on every instruction set (see DspKernels), so
+// --isa is only needed to time one against another or to rule them out.
+//==============================================================================
+namespace
+{
+    struct Job
+    {
+        juce::File input, output;
+    };
+
+    void printUsage()
+    {
+        std::cout << "Usage: LusionBatchRender --manifest=<file> [--preset=<xml>] [--out=<dir>]\n"
+                     "                         [--threads=N] [--block=N] [--tail=<seconds>]\n"
+                     "                         [--bits=N] [--format=wav|flac]\n"
+                     "                         [--chunks=N|auto] [--floor=<dBFS>] [--verify] [--isa=<name>]\n";
+    }
+
+    juce::Array<Job> parseManifest(const juce::File& manifest, const juce::File& outDir, const juce::String& extension)
+    {
+        juce::Array<Job> jobs;
+        juce::StringArray lines;
+        manifest.readLines(lines);
+
+        const auto base = manifest.getParentDirectory();
+
+        for (auto line : lines)
+        {
+            line = line.trim();
+
+            if (line.isEmpty() || line.startsWithChar('#'))
+                continue;
+
+            const auto input = base.getChildFile(line.upToFirstOccurrenceOf("\t", false, false).trim());
+            const auto target = line.fromFirstOccurrenceOf("\t", false, false).trim();
+
+            const auto output = target.isNotEmpty()
+                ? base.getChildFile(target)
+                : outDir.getChildFile(input.getFileNameWithoutExtension() + extension);
+
+            jobs.add({ input, output });
+        }
+
+        return jobs;
+    }
+
+    // The first job whose output an earlier job already writes, or -1. Jobs
+    // render concurrently, so the later file would silently replace the
+    // earlier one.
+    int findDuplicateOutput(const juce::Array<Job>& jobs, int& earlier)
+    {
+        std::map<juce::String, int> outputs;
+
+        for (int i = 0; i < jobs.size(); ++i)
+        {
+            auto path = jobs[i].output.getFullPathName();
+
+            if (!juce::File::areFileNamesCaseSensitive())
+                path = path.toLowerCase();
+
+            const auto inserted = outputs.emplace(path, i);
+
+            if (!inserted.second)
+            {
+                earlier = inserted.first->second;
+                return i;
+            }
+        }
+
+        return -1;
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;
+    juce::ArgumentList args(argc, argv);
+
+    // Missing files and bad option values end the run with a message
+    return juce::ConsoleApplication::invokeCatchingFailures([&]
+    {
+        if (!args.containsOption("--manifest"))
+        {
+            printUsage();
+            return 1;
+        }
+
+        const auto manifest = args.getExistingFileForOption("--manifest");
+        const auto outDir = args.containsOption("--out")
+            ? juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--out"))
+            : juce::File::getCurrentWorkingDirectory();
+
+        const auto extension = "." + (args.containsOption("--format") ? args.getValueForOption("--format") : juce::String("wav"));
+
+        RenderOptions options;
+
+        if (args.containsOption("--preset"))
+        {
+            options.presetXml = args.getExistingFileForOption("--preset").loadFileAsString();
+
+            if (juce::XmlDocument::parse(options.presetXml) == nullptr)
+            {
+                std::cerr << "Preset is not valid XML\n";
+                return 1;
+            }
+        }
+
+        if (args.containsOption("--block"))
+            options.blockSize = args.getValueForOption("--block").getIntValue();
+        if (args.containsOption("--tail"))
+            options.tailSeconds = args.getValueForOption("--tail").getDoubleValue();
+        if (args.containsOption("--bits"))
+            options.bitsPerSample = args.getValueForOption("--bits").getIntValue();
+
+        const int numThreads = args.containsOption("--threads")
+            ? juce::jmax(1, args.getValueForOption("--threads").getIntValue())
+            : juce::SystemStats::getNumCpus();
+
+        if (args.containsOption("--chunks"))
+        {
+            const auto chunks = args.getValueForOption("--chunks");
+            options.numChunks = chunks == "auto" ? numThreads : juce::jmax(1, chunks.getIntValue());
+        }
+
+        if (args.containsOption("--floor"))
+            options.errorFloorDb = args.getValueForOption("--floor").getFloatValue();
+
+        options.verifyAgainstSerial = args.containsOption("--verify");
+
+        if (args.containsOption("--isa") && !DspKernels::setActiveIsa(args.getValueForOption("--isa").toRawUTF8()))
+        {
+            std::cerr << "Instruction set " << args.getValueForOption("--isa") << " is not available\n";
+            return 1;
+        }
+
+        const auto jobs = parseManifest(manifest, outDir, extension);
+
+        if (jobs.isEmpty())
+        {
+            std::cerr << "Nothing to render in " << manifest.getFullPathName() << "\n";
+            return 1;
+        }
+
+        int earlier = -1;
+
+        if (const int duplicate = findDuplicateOutput(jobs, earlier); duplicate >= 0)
+        {
+            std::cerr << jobs[earlier].input.getFullPathName() << " and " << jobs[duplicate].input.getFullPathName()
+                      << " would both render to " << jobs[duplicate].output.getFullPathName()
+                      << "; give one of them an explicit output in the manifest\n";
+            return 1;
+        }
+
+        outDir.createDirectory();
+
+        const OfflineRenderer renderer(options);
+
+        std::atomic<int> numDone{ 0 }, numFailed{ 0 };
+        std::atomic<juce::int64> totalMicroseconds{ 0 };
+        juce::CriticalSection printLock;
+
+        const auto report = [&](const Job& job, const RenderResult& result)
+            {
+                const juce::ScopedLock sl(printLock);
+                ++numDone;
+
+                if (result.numChunks > 1)
+                {
+                    std::cout << "    " << result.numChunks << " chunks, preroll "
+                              << juce::String(result.prerollSeconds, 1) << " s + "
+                              << juce::String(result.controlPrerollSeconds, 1) << " s levels only, seam deviation "
+                              << juce::String(result.seamDeviationDb, 1) << " dBFS";
+
+                    if (result.serialVerified)
+                        std::cout << ", serial deviation " << juce::String(result.serialDeviationDb, 1) << " dBFS";
+
+                    std::cout << "\n";
+                }
+
+                if (result.ok)
+                {
+                    totalMicroseconds += (juce::int64)(result.numSamples / result.sampleRate * 1.0e6);
+
+                    std::cout << "[" << numDone << "/" << jobs.size() << "] "
+                              << job.output.getFileName() << "  "
+                              << juce::String(result.getRealtimeFactor(), 1) << "x realtime\n";
+                }
+                else
+                {
+                    ++numFailed;
+                    std::cerr << "FAILED " << job.input.getFileName() << ": " << result.error << "\n";
+                }
+            };
+
+        const int poolSize = options.numChunks > 1 ? numThreads : juce::jmin(numThreads, jobs.size());
+
+        std::cout << "Rendering " << jobs.size() << " files with the "
+                  << DspKernels::getName(DspKernels::getActiveIsa()) << " kernels\n";
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+
+        {
+            juce::ThreadPool pool(poolSize);
+
+            if (options.numChunks > 1)
+            {
+                // One file at a time, its chunks spread over the whole pool
+                for (const auto& job : jobs)
+                    report(job, renderer.renderChunked(job.input, job.output, pool));
+            }
+            else
+            {
+                for (const auto& job : jobs)
+                    pool.addJob([&, job] { report(job, renderer.render(job.input, job.output)); });
+
+                while (pool.getNumJobs() > 0)
+                    juce::Thread::sleep(50);
+            }
+        }
+
+        const double wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+        const double audioSeconds = (double)totalMicroseconds.load() * 1.0e-6;
+
+        std::cout << "\nRendered " << (jobs.size() - numFailed.load()) << " of " << jobs.size() << " files, "
+                  << juce::String(audioSeconds / 60.0, 1) << " min of audio in "
+                  << juce::String(wallSeconds, 1) << " s ("
+                  << juce::String(wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0, 1) << "x realtime, "
+                  << poolSize << " threads)\n";
+
+        return numFailed.load() == 0 ? 0 : 2;
+    });
+}
@@ -0,0 +1,473 @@
+#include <JuceHeader.h>
+#include "BenchmarkSupport.h"
+
+//==============================================================================
+// LusionBenchmark
+//
+// Times ReverbEngine::process and the full processBlock over a grid of block
+// sizes, sample rates, channel counts and AUTO settings:
+//
+//   LusionBenchmark [--out=results.json] [--label=<text>] [--baseline=old.json]
+//                   [--threshold=5] [--seconds=1] [--repeats=5]
+//                   [--blocks=1,64,512] [--rates=48000,96000] [--channels=1,2,6]
+//                   [--targets=engine,processor] [--algorithms=classic,fdn]
+//                   [--eco=1,2,4] [--precision=float,double] [--isa=sse2,avx2]
+//                   [--ir=<file>]
+//
+// Every case is reported as ns per sample frame (all channels) and as the
+// share of one core it would take to run in realtime. The timed loop copies
+// each block of input in first, as a host does, so the smallest blocks
+// include that overhead too.
+//
+// --out writes JSON with one entry per case, keyed by a stable id, in a fixed
+// order so two runs diff cleanly. --baseline compares against such a file
+// and lists every case that moved by more than --threshold percent.
+// Convolution cases need an impulse response (--ir). --eco adds cases with the
+// tanks running at a half or a quarter of the sample rate. --channels takes
+// any count the plugin has a layout for (1, 2, 5, 6, 7, 8, 11, 12); past
+// stereo every algorithm runs the multichannel bank. --precision=double runs
+// the same cases on double buffers, as a 64-bit host would hand them over.
+// --isa runs every case once per kernel instruction set (see DspKernels);
+// without it the cases run on whichever one the plugin would choose.
+//==============================================================================
+namespace
+{
+    struct Case
+    {
+        juce::String target;    // "engine" or "processor"
+        ReverbEngine::Algorithm algorithm;
+        bool autoOn;            // processor only
+        double sampleRate;
+        int numChannels;
+        int blockSize;
+        int ecoFactor;          // 1 = full rate
+        bool doublePrecision;
+        DspKernels::Isa isa;
+        bool isaInId;           // only when --isa was given
+
+        juce::String getId() const
+        {
+            auto id = target + "/" + BenchmarkSupport::getAlgorithmName(algorithm);
+
+            if (target == "processor")
+                id << (autoOn ? "/auto" : "/manual");
+
+            // Full-rate ids stay as they were, so old baselines still match
+            if (ecoFactor > 1)
+                id << "/eco" << ecoFactor;
+
+            if (doublePrecision)
+                id << "/double";
+
+            if (isaInId)
+                id << "/" << DspKernels::getName(isa);
+
+            id << "/" << juce::String((int)sampleRate) << "/";
+
+            if (numChannels <= 2)
+                id << (numChannels == 1 ? "mono" : "stereo");
+            else
+                id << numChannels << "ch";
+
+            return id << "/" << blockSize;
+        }
+    };
+
+    struct Measurement
+    {
+        double nsPerSample = 0.0;       // median over the repeats
+        double nsPerSampleMin = 0.0;
+
+        double getCorePercent(double sampleRate) const
+        {
+            return nsPerSample * sampleRate * 1.0e-7;
+        }
+    };
+
+    template <typename SampleType>
+    using BlockFunction = std::function<void(juce::AudioBuffer<SampleType>&)>;
+
+    void printUsage()
+    {
+        std::cout << "Usage: LusionBenchmark [--out=<json>] [--label=<text>] [--baseline=<json>] [--threshold=<percent>]\n"
+                     "                       [--seconds=<audio seconds per repeat>] [--repeats=N]\n"
+                     "                       [--blocks=N,N,...] [--rates=N,N,...] [--channels=N,N,...]\n"
+                     "                       [--targets=engine,processor] [--algorithms=classic,fdn,convolution]\n"
+                     "                       [--eco=1,2,4] [--precision=float,double] [--isa=N,N,...] [--ir=<file>]\n"
+                     "Kernel instruction sets on this machine: " << BenchmarkSupport::getAvailableIsaNames() << "\n";
+    }
+
+    template <typename SampleType>
+    Measurement measure(const Case& c, const BlockFunction<SampleType>& process,
+                        const juce::AudioBuffer<SampleType>& signal, double seconds, int repeats)
+    {
+        juce::AudioBuffer<SampleType> block(c.numChannels, c.blockSize);
+
+        const int signalLength = signal.getNumSamples() - c.blockSize;
+        const auto numBlocks = juce::jmax((juce::int64)1, (juce::int64)(seconds * c.sampleRate / c.blockSize));
+        int position = 0;
+
+        const auto runBlocks = [&](juce::int64 count)
+            {
+                for (juce::int64 i = 0; i < count; ++i)
+                {
+                    for (int ch = 0; ch < c.numChannels; ++ch)
+                        block.copyFrom(ch, 0, signal, ch, position, c.blockSize);
+
+                    process(block);
+
+                    position += c.blockSize;
+
+                    if (position > signalLength)
+                        position = 0;
+                }
+            };
+
+        // Fill the tank and caches before timing anything
+        runBlocks(numBlocks / 4 + 1);
+
+        std::vector<double> nsPerSample;
+
+        for (int r = 0; r < repeats; ++r)
+        {
+            const auto start = juce::Time::getHighResolutionTicks();
+            runBlocks(numBlocks);
+            const auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+            nsPerSample.push_back(elapsed * 1.0e9 / (double)(numBlocks * c.blockSize));
+        }
+
+        std::sort(nsPerSample.begin(), nsPerSample.end());
+
+        Measurement m;
+        m.nsPerSample = BenchmarkSupport::getPercentile(nsPerSample, 50.0);
+        m.nsPerSampleMin = nsPerSample.front();
+        return m;
+    }
+
+    template <typename SampleType>
+    bool runCaseAs(const Case& c, const juce::AudioBuffer<SampleType>& signal, const juce::File& impulseResponse,
+                   double seconds, int repeats, Measurement& result)
+    {
+        juce::ScopedNoDenormals noDenormals;
+        DspKernels::setActiveIsa(c.isa);
+
+        if (c.target == "engine")
+        {
+            ReverbEngine engine;
+            engine.prepare(c.sampleRate, c.blockSize, c.ecoFactor,
+                           LusionSmartReverbAudioProcessor::getLayoutForChannelCount(c.numChannels));
+            engine.setAlgorithm(c.algorithm);
+            engine.setWet(0.4f);
+            engine.setDecay(2.2f);
+            engine.setWidth(1.0f);
+            engine.reset();
+
+            if (c.algorithm == ReverbEngine::Algorithm::convolution)
+            {
+                engine.loadImpulseResponse(impulseResponse);
+
+                while (engine.isImpulseResponseLoading())
+                    juce::Thread::sleep(2);
+            }
+
+            result = measure<SampleType>(c, [&](juce::AudioBuffer<SampleType>& b) { engine.process(b); },
+                                         signal, seconds, repeats);
+            return true;
+        }
+
+        auto processor = BenchmarkSupport::createProcessor(c.numChannels, c.sampleRate, c.blockSize,
+                                                           c.algorithm, c.autoOn, impulseResponse, c.ecoFactor,
+                                                           false, c.doublePrecision);
+
+        if (processor == nullptr)
+            return false;
+
+        juce::MidiBuffer midi;
+        result = measure<SampleType>(c, [&](juce::AudioBuffer<SampleType>& b) { processor->processBlock(b, midi); },
+                                     signal, seconds, repeats);
+
+        processor->releaseResources();
+        return true;
+    }
+
+    bool runCase(const Case& c, const juce::AudioBuffer<float>& signal, const juce::File& impulseResponse,
+                 double seconds, int repeats, Measurement& result)
+    {
+        if (!c.doublePrecision)
+            return runCaseAs(c, signal, impulseResponse, seconds, repeats, result);
+
+        // Converted once up front, so only the plugin's own work is timed
+        juce::AudioBuffer<double> doubleSignal;
+        doubleSignal.makeCopyOf(signal);
+
+        return runCaseAs(c, doubleSignal, impulseResponse, seconds, repeats, result);
+    }
+
+    juce::var toJson(const Case& c, const Measurement& m)
+    {
+        auto entry = std::make_unique<juce::DynamicObject>();
+
+        entry->setProperty("id", c.getId());
+        entry->setProperty("target", c.target);
+        entry->setProperty("algorithm", BenchmarkSupport::getAlgorithmName(c.algorithm));
+
+        if (c.target == "processor")
+            entry->setProperty("auto", c.autoOn);
+
+        entry->setProperty("sampleRate", c.sampleRate);
+        entry->setProperty("channels", c.numChannels);
+        entry->setProperty("blockSize", c.blockSize);
+        entry->setProperty("eco", c.ecoFactor);
+        entry->setProperty("precision", c.doublePrecision ? "double" : "float");
+        entry->setProperty("isa", DspKernels::getName(c.isa));
+        entry->setProperty("nsPerSample", m.nsPerSample);
+        entry->setProperty("nsPerSampleMin", m.nsPerSampleMin);
+        entry->setProperty("realtimeCorePercent", m.getCorePercent(c.sampleRate));
+
+        return juce::var(entry.release());
+    }
+
+    void compareWithBaseline(const juce::var& baseline, const juce::Array<juce::var>& results, double thresholdPercent)
+    {
+        std::map<juce::String, double> before;
+
+        if (auto* entries = baseline["results"].getArray())
+            for (const auto& entry : *entries)
+                before[entry["id"].toString()] = (double)entry["nsPerSample"];
+
+        int numCompared = 0, numSlower = 0, numFaster = 0;
+        double logRatioSum = 0.0;
+
+        std::cout << "\nChanges against " << baseline["label"].toString() << " above "
+                  << juce::String(thresholdPercent, 1) << "%:\n";
+
+        for (const auto& entry : results)
+        {
+            const auto it = before.find(entry["id"].toString());
+
+            if (it == before.end() || it->second <= 0.0)
+                continue;
+
+            const double ratio = (double)entry["nsPerSample"] / it->second;
+            const double changePercent = (ratio - 1.0) * 100.0;
+
+            ++numCompared;
+            logRatioSum += std::log(ratio);
+
+            if (std::abs(changePercent) < thresholdPercent)
+                continue;
+
+            (changePercent > 0.0 ? numSlower : numFaster)++;
+
+            std::cout << "  " << entry["id"].toString().paddedRight(' ', 44)
+                      << juce::String(it->second, 2).paddedLeft(' ', 10) << " -> "
+                      << juce::String((double)entry["nsPerSample"], 2).paddedLeft(' ', 10) << " ns/sample  "
+                      << (changePercent > 0.0 ? "+" : "") << juce::String(changePercent, 1) << "%\n";
+        }
+
+        if (numCompared == 0)
+        {
+            std::cout << "  no cases in common\n";
+            return;
+        }
+
+        std::cout << numCompared << " cases compared, " << numSlower << " slower, " << numFaster
+                  << " faster, geometric mean " << juce::String((std::exp(logRatioSum / numCompared) - 1.0) * 100.0, 1)
+                  << "%\n";
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;
+    juce::ArgumentList args(argc, argv);
+
+    return juce::ConsoleApplication::invokeCatchingFailures([&]
+    {
+        if (args.containsOption("--help|-h"))
+        {
+            printUsage();
+            return 0;
+        }
+
+        const auto option = [&](const char* name, const juce::String& fallback)
+            {
+                return args.containsOption(name) ? args.getValueForOption(name) : fallback;
+            };
+
+        const double seconds = juce::jmax(0.01, option("--seconds", "1").getDoubleValue());
+        const int repeats = juce::jmax(1, option("--repeats", "5").getIntValue());
+
+        const auto blockSizes = BenchmarkSupport::parseIntList(option("--blocks", "1,2,4,8,16,32,64,128,256,512,1024,2048,4096"));
+        const auto sampleRates = BenchmarkSupport::parseDoubleList(option("--rates", "44100,48000,88200,96000,176400,192000"));
+        const auto channelCounts = BenchmarkSupport::parseIntList(option("--channels", "1,2"));
+        const auto targets = juce::StringArray::fromTokens(option("--targets", "engine,processor"), ",", {});
+        const auto ecoFactors = BenchmarkSupport::parseIntList(option("--eco", "1"));
+        const auto precisions = juce::StringArray::fromTokens(option("--precision", "float"), ",", {});
+
+        const auto impulseResponse = args.containsOption("--ir") ? args.getExistingFileForOption("--ir") : juce::File();
+
+        juce::Array<ReverbEngine::Algorithm> algorithms;
+
+        for (const auto& name : juce::StringArray::fromTokens(option("--algorithms", impulseResponse.existsAsFile()
+                                                                                         ? "classic,fdn,convolution"
+                                                                                         : "classic,fdn"), ",", {}))
+        {
+            ReverbEngine::Algorithm algorithm;
+
+            if (!BenchmarkSupport::parseAlgorithm(name, algorithm))
+                juce::ConsoleApplication::fail("Unknown algorithm " + name);
+
+            if (algorithm == ReverbEngine::Algorithm::convolution && !impulseResponse.existsAsFile())
+                juce::ConsoleApplication::fail("Convolution cases need --ir=<file>");
+
+            algorithms.add(algorithm);
+        }
+
+        for (const auto& target : targets)
+            if (target != "engine" && target != "processor")
+                juce::ConsoleApplication::fail("Unknown target " + target);
+
+        for (auto blockSize : blockSizes)
+            if (blockSize < 1)
+                juce::ConsoleApplication::fail("Block sizes must be at least 1");
+
+        for (auto channels : channelCounts)
+            if (LusionSmartReverbAudioProcessor::getLayoutForChannelCount(channels).isDisabled())
+                juce::ConsoleApplication::fail("No layout has " + juce::String(channels) + " channels");
+
+        for (auto factor : ecoFactors)
+            if (factor != 1 && factor != 2 && factor != 4)
+                juce::ConsoleApplication::fail("Eco factors must be 1, 2 or 4");
+
+        for (const auto& precision : precisions)
+            if (precision != "float" && precision != "double")
+                juce::ConsoleApplication::fail("Unknown precision " + precision);
+
+        for (auto rate : sampleRates)
+            if (rate <= 0.0)
+                juce::ConsoleApplication::fail("Sample rates must be positive");
+
+        juce::Array<DspKernels::Isa> isas;
+
+        for (const auto& name : juce::StringArray::fromTokens(option("--isa", ""), ",", {}))
+        {
+            DspKernels::Isa isa;
+
+            if (!BenchmarkSupport::parseIsa(name, isa))
+                juce::ConsoleApplication::fail("Instruction set " + name + " is not available (have "
+                                               + BenchmarkSupport::getAvailableIsaNames() + ")");
+
+            isas.add(isa);
+        }
+
+        const bool isaInId = !isas.isEmpty();
+
+        if (isas.isEmpty())
+            isas.add(DspKernels::getActiveIsa());
+
+        juce::Array<Case> cases;
+
+        for (const auto& target : targets)
+            for (auto algorithm : algorithms)
+                for (bool autoOn : { false, true })
+                {
+                    if (autoOn && target == "engine")
+                        continue;
+
+                    for (const auto& precision : precisions)
+                        for (auto isa : isas)
+                            for (auto factor : ecoFactors)
+                                for (auto rate : sampleRates)
+                                    for (auto channels : channelCounts)
+                                        for (auto blockSize : blockSizes)
+                                            cases.add({ target, algorithm, autoOn, rate, channels, blockSize, factor,
+                                                        precision == "double", isa, isaInId });
+                }
+
+        const auto machine = BenchmarkSupport::describeMachine();
+
+        std::cout << machine["cpu"].toString() << ", " << machine["build"].toString() << " build, "
+                  << (isaInId ? option("--isa", "") : machine["isa"].toString()) << " kernels, "
+                  << cases.size() << " cases x " << repeats << " x " << seconds << " s of audio\n\n";
+
+       #if JUCE_DEBUG
+        std::cout << "Warning: debug build, numbers are not representative\n\n";
+       #endif
+
+        juce::Array<juce::var> results;
+        std::map<std::pair<double, int>, juce::AudioBuffer<float>> signals;
+
+        for (const auto& c : cases)
+        {
+            // One deterministic signal per rate, a few seconds long: stereo
+            // (mono cases take its first channel), or as wide as the layout
+            const int signalChannels = juce::jmax(2, c.numChannels);
+            auto& signal = signals[{ c.sampleRate, signalChannels }];
+
+            if (signal.getNumSamples() == 0)
+            {
+                signal.setSize(signalChannels, (int)(c.sampleRate * 4.0) + 4096);
+                BenchmarkSupport::fillTestSignal(signal, c.sampleRate, 1);
+            }
+
+            Measurement m;
+
+            if (!runCase(c, signal, impulseResponse, seconds, repeats, m))
+            {
+                std::cerr << "Skipped " << c.getId() << ": layout not supported\n";
+                continue;
+            }
+
+            results.add(toJson(c, m));
+
+            std::cout << c.getId().paddedRight(' ', 44)
+                      << juce::String(m.nsPerSample, 2).paddedLeft(' ', 10) << " ns/sample"
+                      << juce::String(m.getCorePercent(c.sampleRate), 3).paddedLeft(' ', 10) << "% core\n";
+        }
+
+        auto report = std::make_unique<juce::DynamicObject>();
+        report->setProperty("tool", "LusionBenchmark");
+        report->setProperty("formatVersion", 1);
+        report->setProperty("label", option("--label", juce::Time::getCurrentTime().toISO8601(true)));
+        report->setProperty("machine", machine);
+        report->setProperty("secondsPerRepeat", seconds);
+        report->setProperty("repeats", repeats);
+        report->setProperty("results", results);
+
+        const juce::var reportVar(report.release());
+
+        if (args.containsOption("--out"))
+        {
+            const auto out = args.getFileForOption("--out");
+
+            if (!BenchmarkSupport::writeJson(reportVar, out))
+                juce::ConsoleApplication::fail("Can't write " + out.getFullPathName());
+
+            std::cout << "\nWrote " << out.getFullPathName() << "\n";
+        }
+
+        if (args.containsOption("--baseline"))
+        {
+            const auto baseline = juce::JSON::parse(args.getExistingFileForOption("--baseline"));
+
+            if (baseline["tool"].toString() != "LusionBenchmark")
+                juce::ConsoleApplication::fail("Baseline is not a LusionBenchmark report");
+
+            if (baseline["machine"]["cpu"] != machine["cpu"] || baseline["machine"]["build"] != machine["build"])
+                std::cout << "\nWarning: baseline was recorded on " << baseline["machine"]["cpu"].toString()
+                          << " (" << baseline["machine"]["build"].toString() << " build)\n";
+
+            // Reports from before the kernels were dispatched have no isa
+            if (!isaInId && baseline["machine"].hasProperty("isa") && baseline["machine"]["isa"] != machine["isa"])
+                std::cout << "\nWarning: baseline ran the " << baseline["machine"]["isa"].toString()
+                          << " kernels, this run " << machine["isa"].toString() << "\n";
+
+            compareWithBaseline(baseline, results, option("--threshold", "5").getDoubleValue());
+        }
+
+        return 0;
+    });
+}
@@ -0,0 +1,197 @@
+#include "BenchmarkSupport.h"
+
+namespace BenchmarkSupport
+{
+    juce::String getAlgorithmName(ReverbEngine::Algorithm algorithm)
+    {
+        switch (algorithm)
+        {
+            case ReverbEngine::Algorithm::fdn:         return "fdn";
+            case ReverbEngine::Algorithm::convolution: return "convolution";
+            case ReverbEngine::Algorithm::classic:
+            default:                                   return "classic";
+        }
+    }
+
+    bool parseAlgorithm(const juce::String& name, ReverbEngine::Algorithm& algorithm)
+    {
+        for (auto candidate : { ReverbEngine::Algorithm::classic,
+                                ReverbEngine::Algorithm::fdn,
+                                ReverbEngine::Algorithm::convolution })
+        {
+            if (name.trim().equalsIgnoreCase(getAlgorithmName(candidate)))
+            {
+                algorithm = candidate;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool parseIsa(const juce::String& name, DspKernels::Isa& isa)
+    {
+        for (auto candidate : { DspKernels::Isa::baseline, DspKernels::Isa::avx2, DspKernels::Isa::avx512 })
+        {
+            if (name.trim().equalsIgnoreCase(DspKernels::getName(candidate)) && DspKernels::isAvailable(candidate))
+            {
+                isa = candidate;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    juce::String getAvailableIsaNames()
+    {
+        juce::StringArray names;
+
+        for (auto isa : { DspKernels::Isa::baseline, DspKernels::Isa::avx2, DspKernels::Isa::avx512 })
+            if (DspKernels::isAvailable(isa))
+                names.add(DspKernels::getName(isa));
+
+        return names.joinIntoString(",");
+    }
+
+    void setParameter(juce::AudioProcessorValueTreeState& apvts, const juce::String& id, float plainValue)
+    {
+        if (auto* param = apvts.getParameter(id))
+            param->setValueNotifyingHost(param->convertTo0to1(plainValue));
+    }
+
+    std::unique_ptr<LusionSmartReverbAudioProcessor> createProcessor(int numChannels, double sampleRate, int blockSize,
+                                                                     ReverbEngine::Algorithm algorithm, bool autoOn,
+                                                                     const juce::File& impulseResponse,
+                                                                     int ecoFactor, bool worker, bool doublePrecision)
+    {
+        auto processor = std::make_unique<LusionSmartReverbAudioProcessor>();
+
+        const auto set = LusionSmartReverbAudioProcessor::getLayoutForChannelCount(numChannels);
+
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add(set);
+        layout.outputBuses.add(set);
+
+        if (!processor->setBusesLayout(layout))
+            return nullptr;
+
+        auto& apvts = processor->apvts;
+
+        // MODE "Long" for the algorithmic tanks, "Convolution" otherwise
+        setParameter(apvts, "MODE", algorithm == ReverbEngine::Algorithm::convolution ? 3.0f : 1.0f);
+        setParameter(apvts, "ENGINE", algorithm == ReverbEngine::Algorithm::fdn ? 1.0f : 0.0f);
+        setParameter(apvts, "AUTO", autoOn ? 1.0f : 0.0f);
+        setParameter(apvts, "ECO", ecoFactor == 4 ? 2.0f : ecoFactor == 2 ? 1.0f : 0.0f);
+        setParameter(apvts, "WORKER", worker ? 1.0f : 0.0f);
+
+        processor->setProcessingPrecision(doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                          : juce::AudioProcessor::singlePrecision);
+        processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor->prepareToPlay(sampleRate, blockSize);
+
+        if (algorithm == ReverbEngine::Algorithm::convolution)
+            processor->loadImpulseResponse(impulseResponse);
+
+        while (processor->isImpulseResponseLoading())
+            juce::Thread::sleep(2);
+
+        return processor;
+    }
+
+    void fillTestSignal(juce::AudioBuffer<float>& buffer, double sampleRate, juce::int64 seed)
+    {
+        juce::Random random(seed);
+
+        const int numSamples = buffer.getNumSamples();
+        int burstStart = 0;
+
+        while (burstStart < numSamples)
+        {
+            // 50 - 400 ms bursts between -30 and -3 dBFS
+            const int length = juce::jmax(1, (int)(sampleRate * (0.05 + 0.35 * random.nextDouble())));
+            const float level = juce::Decibels::decibelsToGain(-30.0f + 27.0f * random.nextFloat());
+            const float decayPerSample = std::exp(-4.0f / (float)length);
+
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            {
+                auto* data = buffer.getWritePointer(ch);
+                float envelope = level;
+
+                for (int i = burstStart; i < juce::jmin(numSamples, burstStart + length); ++i)
+                {
+                    data[i] = envelope * (2.0f * random.nextFloat() - 1.0f);
+                    envelope *= decayPerSample;
+                }
+            }
+
+            burstStart += length;
+        }
+    }
+
+    juce::var describeMachine()
+    {
+        auto machine = std::make_unique<juce::DynamicObject>();
+
+        machine->setProperty("cpu", juce::SystemStats::getCpuModel());
+        machine->setProperty("cpuVendor", juce::SystemStats::getCpuVendor());
+        machine->setProperty("cpuMHz", juce::SystemStats::getCpuSpeedInMegahertz());
+        machine->setProperty("logicalCores", juce::SystemStats::getNumCpus());
+        machine->setProperty("physicalCores", juce::SystemStats::getNumPhysicalCpus());
+        machine->setProperty("os", juce::SystemStats::getOperatingSystemName());
+        machine->setProperty("juce", juce::SystemStats::getJUCEVersion());
+        machine->setProperty("simdWidth", (int)juce::dsp::SIMDRegister<float>::SIMDNumElements);
+        machine->setProperty("isa", DspKernels::getName(DspKernels::getActiveIsa()));
+        machine->setProperty("isaAvailable", getAvailableIsaNames());
+
+       #if JUCE_DEBUG
+        machine->setProperty("build", "debug");
+       #else
+        machine->setProperty("build", "release");
+       #endif
+
+        return juce::var(machine.release());
+    }
+
+    bool writeJson(const juce::var& report, const juce::File& file)
+    {
+        return file.replaceWithText(juce::JSON::toString(report) + "\n");
+    }
+
+    double getPercentile(const std::vector<double>& sorted, double percentile)
+    {
+        if (sorted.empty())
+            return 0.0;
+
+        const double position = juce::jlimit(0.0, 1.0, percentile / 100.0) * (double)(sorted.size() - 1);
+        const auto index = (size_t)position;
+        const double fraction = position - (double)index;
+
+        if (index + 1 >= sorted.size())
+            return sorted.back();
+
+        return sorted[index] + fraction * (sorted[index + 1] - sorted[index]);
+    }
+
+    juce::Array<int> parseIntList(const juce::String& text)
+    {
+        juce::Array<int> values;
+
+        for (const auto& token : juce::StringArray::fromTokens(text, ",", {}))
+            if (token.trim().isNotEmpty())
+                values.add(token.trim().getIntValue());
+
+        return values;
+    }
+
+    juce::Array<double> parseDoubleList(const juce::String& text)
+    {
+        juce::Array<double> values;
+
+        for (const auto& token : juce::StringArray::fromTokens(text, ",", {}))
+            if (token.trim().isNotEmpty())
+                values.add(token.trim().getDoubleValue());
+
+        return values;
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+//==============================================================================
+// Shared by the benchmark and load-test tools: building processors the way a
+// realtime host would, deterministic test material, and the machine details
+// every JSON report starts with.
+//==============================================================================
+namespace BenchmarkSupport
+{
+    // Algorithm names used on the command line and in reports
+    juce::String getAlgorithmName(ReverbEngine::Algorithm algorithm);
+    bool parseAlgorithm(const juce::String& name, ReverbEngine::Algorithm& algorithm);
+
+    // Kernel instruction sets (see DspKernels), by the same names. parseIsa
+    // only accepts one this build and CPU can run.
+    bool parseIsa(const juce::String& name, DspKernels::Isa& isa);
+    juce::String getAvailableIsaNames();
+
+    // Sets a parameter from its plain (unnormalised) value
+    void setParameter(juce::AudioProcessorValueTreeState& apvts, const juce::String& id, float plainValue);
+
+    // A realtime (not offline) processor with the given layout and algorithm,
+    // prepared and with any convolution IR fully loaded. Returns null if the
+    // layout isn't supported. ecoFactor sets the ECO parameter (1, 2 or 4),
+    // worker the WORKER one; doublePrecision prepares it for double buffers.
+    std::unique_ptr<LusionSmartReverbAudioProcessor> createProcessor(int numChannels, double sampleRate, int blockSize,
+                                                                     ReverbEngine::Algorithm algorithm, bool autoOn,
+                                                                     const juce::File& impulseResponse,
+                                                                     int ecoFactor = 1, bool worker = false,
+                                                                     bool doublePrecision = false);
+
+    // Noise bursts with varying level and decay, so the level detector, the
+    // duck envelope and AUTO all see something like programme material.
+    // The same seed always gives the same signal.
+    void fillTestSignal(juce::AudioBuffer<float>& buffer, double sampleRate, juce::int64 seed);
+
+    // CPU, OS and build details, so results from different machines or
+    // builds are never compared by mistake. "isa" is the kernel instruction
+    // set in use when it's called (see DspKernels).
+    juce::var describeMachine();
+
+    bool writeJson(const juce::var& report, const juce::File& file);
+
+    // Linear-interpolated percentile (0-100) of an already sorted array
+    double getPercentile(const std::vector<double>& sorted, double percentile);
+
+    juce::Array<int> parseIntList(const juce::String& text);
+    juce::Array<double> parseDoubleList(const juce::String& text);
+}
@@ -0,0 +1,812 @@
+#include <JuceHeader.h>
+#include "BenchmarkSupport.h"
+
+//==============================================================================
+// LusionCheck
+//
+// Correctness checks that need no host, audio device or reference files:
+//
+//   LusionCheck [--checks=convolver,freeverb,snapshot,kernels] [--seed=1]
+//
+// convolver  PartitionedConvolver against direct time-domain convolution, for
+//            body partitions of 512 to 2048 samples with heads from 32
+//            samples up to the whole partition, on float and double input
+//            handed over in calls of random length. Every output sample must
+//            be within 1e-5 of the direct result's peak (-100 dB).
+//
+// freeverb   FreeverbBank against juce::Reverb at the settings ReverbEngine
+//            used to give it, at every rate the tank runs at: hosts from 8 to
+//            384 kHz, at full rate and at the half and quarter rates of eco
+//            mode. Mono and stereo, random block sizes, WET, DECAY and WIDTH
+//            changed at random between blocks, and a tail of silence. Every
+//            output sample must be within 1e-5 of juce::Reverb's peak.
+//
+// snapshot   ReverbEngine::createSnapshot/restoreSnapshot and the processor's
+//            processing snapshot, for every algorithm, eco factor and layout
+//            (mono, stereo, 5.1, 7.1.4): a render is snapshotted half-way,
+//            a second instance that has been playing other material restores
+//            it, and the rest of its render must match the first bit for
+//            bit. WET, DECAY and WIDTH change at random between blocks, and
+//            the input ends in silence.
+//
+// kernels    Every entry of the DspKernels table, on every instruction set
+//            this build and CPU can run, against the baseline kernels: random
+//            sizes (including ones no register width divides) and random
+//            data, and every output and piece of state must match bit for
+//            bit. Instruction sets the CPU lacks are reported as skipped.
+//
+// Every case prints one line. The exit code is 1 if any of them failed.
+//==============================================================================
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: LusionCheck [--checks=convolver,freeverb,snapshot,kernels] [--seed=N]\n";
+    }
+
+    void report(const juce::String& name, bool passed, const juce::String& detail)
+    {
+        std::cout << "  " << name.paddedRight(' ', 48) << detail.paddedRight(' ', 40)
+                  << (passed ? "ok" : "FAILED") << "\n";
+    }
+
+    //==============================================================================
+    constexpr double convolverTolerance = 1.0e-5;
+
+    // An IR cut into split spectra the way ImpulseResponseCache does it
+    std::vector<float> createImpulseSpectra(const std::vector<float>& impulse, const juce::dsp::FFT& fft,
+                                            int partitionSize, int numPartitions)
+    {
+        const int spectrumSize = PartitionedConvolver::getSpectrumSize(partitionSize);
+        std::vector<float> spectra((size_t)(numPartitions * spectrumSize));
+        std::vector<float> work((size_t)(4 * partitionSize));
+
+        for (int p = 0; p < numPartitions; ++p)
+        {
+            std::fill(work.begin(), work.end(), 0.0f);
+
+            for (int i = 0; i < partitionSize && p * partitionSize + i < (int)impulse.size(); ++i)
+                work[(size_t)i] = impulse[(size_t)(p * partitionSize + i)];
+
+            fft.performRealOnlyForwardTransform(work.data(), true);
+            PartitionedConvolver::packSpectrum(work.data(), spectra.data() + p * spectrumSize, partitionSize);
+        }
+
+        return spectra;
+    }
+
+    template <typename SampleType>
+    bool checkConvolver(int partitionSize, int headSize, juce::Random& random)
+    {
+        constexpr int numPartitions = 5;
+
+        // A decaying noise IR that stops short of the last partition's end
+        std::vector<float> impulse((size_t)(numPartitions * partitionSize - 37));
+
+        for (size_t i = 0; i < impulse.size(); ++i)
+            impulse[i] = (2.0f * random.nextFloat() - 1.0f) * std::exp(-3.0f * (float)i / (float)impulse.size());
+
+        const juce::dsp::FFT fft(juce::roundToInt(std::log2(2 * partitionSize)));
+        const juce::dsp::FFT headFft(juce::roundToInt(std::log2(2 * headSize)));
+
+        const auto spectra = createImpulseSpectra(impulse, fft, partitionSize, numPartitions);
+        std::vector<float> headSpectra((size_t)PartitionedConvolver::getSpectrumSize(partitionSize));
+        PartitionedConvolver::createHeadSpectra(fft, spectra.data(), partitionSize, headFft, headSpectra.data(), headSize);
+
+        PartitionedConvolver convolver;
+        convolver.prepare(partitionSize, numPartitions, headSize);
+
+        const int numSamples = partitionSize * (numPartitions + 7);
+        std::vector<SampleType> input((size_t)numSamples);
+        std::vector<float> output((size_t)numSamples);
+
+        for (auto& x : input)
+            x = (SampleType)(2.0 * random.nextDouble() - 1.0);
+
+        // Calls up to twice the head, so some fill it and some cross it
+        for (int pos = 0; pos < numSamples;)
+        {
+            const int n = juce::jmin(numSamples - pos, 1 + random.nextInt(2 * headSize));
+            convolver.process(fft, spectra.data(), headFft, headSpectra.data(),
+                              input.data() + pos, output.data() + pos, n);
+            pos += n;
+        }
+
+        double maxError = 0.0, peak = 0.0;
+
+        for (int t = 0; t < numSamples; ++t)
+        {
+            double expected = 0.0;
+
+            for (int k = 0; k < (int)impulse.size() && k <= t; ++k)
+                expected += impulse[(size_t)k] * (double)input[(size_t)(t - k)];
+
+            maxError = juce::jmax(maxError, std::abs(expected - output[(size_t)t]));
+            peak = juce::jmax(peak, std::abs(expected));
+        }
+
+        const double relativeError = maxError / peak;
+        const bool passed = relativeError <= convolverTolerance;
+
+        report("convolver/" + juce::String(partitionSize) + "/" + juce::String(headSize)
+                   + (std::is_same<SampleType, double>::value ? "/double" : "/float"),
+               passed, "max error " + juce::String(relativeError, 2, true) + " of peak");
+
+        return passed;
+    }
+
+    int runConvolverChecks(juce::Random& random)
+    {
+        int numFailed = 0;
+
+        for (int partitionSize : { 512, 1024, 2048 })
+            for (int headSize : { 32, 64, 256, partitionSize })
+            {
+                numFailed += checkConvolver<float>(partitionSize, headSize, random) ? 0 : 1;
+                numFailed += checkConvolver<double>(partitionSize, headSize, random) ? 0 : 1;
+            }
+
+        return numFailed;
+    }
+
+    //==============================================================================
+    constexpr double freeverbTolerance = 1.0e-5;
+
+    bool checkFreeverb(double sampleRate, int numChannels, juce::Random& random)
+    {
+        constexpr int maxBlockSize = 512;
+
+        // ReverbEngine's mapping of WET, DECAY and WIDTH onto juce::Reverb
+        juce::Reverb::Parameters parameters;
+        parameters.roomSize = 0.5f;
+        parameters.damping = 0.5f;
+        parameters.wetLevel = 0.3f;
+        parameters.dryLevel = 0.7f;
+        parameters.width = 1.0f;
+
+        // Parameters first: setSampleRate snaps the smoothers to them, as
+        // FreeverbBank::prepare does
+        juce::Reverb reference;
+        reference.setParameters(parameters);
+        reference.setSampleRate(sampleRate);
+
+        FreeverbBank bank;
+        bank.prepare(sampleRate, maxBlockSize);
+
+        const int numSamples = (int)(sampleRate * 3.0);
+        const int inputLength = (int)(sampleRate * 2.0);
+
+        std::vector<float> expected((size_t)(2 * maxBlockSize)), actual((size_t)(2 * maxBlockSize));
+        double maxError = 0.0, peak = 0.0;
+
+        for (int pos = 0; pos < numSamples;)
+        {
+            const int n = juce::jmin(numSamples - pos, 1 + random.nextInt(maxBlockSize));
+
+            if (random.nextInt(4) == 0)
+            {
+                const float wet = random.nextFloat();
+                const float decay = 0.1f + 5.9f * random.nextFloat();
+                const float width = random.nextFloat();
+
+                parameters.wetLevel = wet;
+                parameters.dryLevel = 1.0f - wet;
+                parameters.roomSize = juce::jlimit(0.05f, 1.0f, decay / 6.0f);
+                parameters.width = width;
+                reference.setParameters(parameters);
+
+                bank.setWet(wet);
+                bank.setDecay(decay);
+                bank.setWidth(width);
+            }
+
+            for (int i = 0; i < 2 * n; ++i)
+                expected[(size_t)i] = actual[(size_t)i] = pos < inputLength ? random.nextFloat() - 0.5f : 0.0f;
+
+            if (numChannels == 1)
+            {
+                reference.processMono(expected.data(), n);
+                bank.processMono(actual.data(), n);
+            }
+            else
+            {
+                reference.processStereo(expected.data(), expected.data() + n, n);
+                bank.processStereo(actual.data(), actual.data() + n, n);
+            }
+
+            for (int i = 0; i < numChannels * n; ++i)
+            {
+                maxError = juce::jmax(maxError, (double)std::abs(expected[(size_t)i] - actual[(size_t)i]));
+                peak = juce::jmax(peak, (double)std::abs(expected[(size_t)i]));
+            }
+
+            pos += n;
+        }
+
+        const double relativeError = maxError / peak;
+        const bool passed = relativeError <= freeverbTolerance;
+
+        report("freeverb/" + juce::String(sampleRate, 0) + (numChannels == 1 ? "/mono" : "/stereo"),
+               passed, "max error " + juce::String(relativeError, 2, true) + " of peak");
+
+        return passed;
+    }
+
+    int runFreeverbChecks(juce::Random& random)
+    {
+        std::set<double> sampleRates;
+
+        for (double hostRate : { 8000.0, 11025.0, 16000.0, 22050.0, 32000.0, 44100.0, 48000.0,
+                                 88200.0, 96000.0, 176400.0, 192000.0, 352800.0, 384000.0 })
+            for (int ecoFactor : { 1, 2, 4 })
+                sampleRates.insert(hostRate / ecoFactor);
+
+        int numFailed = 0;
+
+        for (double sampleRate : sampleRates)
+            for (int numChannels : { 1, 2 })
+                numFailed += checkFreeverb(sampleRate, numChannels, random) ? 0 : 1;
+
+        return numFailed;
+    }
+
+    //==============================================================================
+    constexpr double snapshotSampleRate = 48000.0;
+    constexpr int snapshotBlockSize = 512;
+
+    // One block of a render, and the settings to apply before it
+    struct RenderStep
+    {
+        int start, numSamples;
+        bool changeSettings;
+        float wet, decay, width;
+    };
+
+    std::vector<RenderStep> createRenderPlan(int numSamples, juce::Random& random)
+    {
+        std::vector<RenderStep> plan;
+
+        for (int start = 0; start < numSamples;)
+        {
+            RenderStep step;
+            step.start = start;
+            step.numSamples = juce::jmin(numSamples - start, 1 + random.nextInt(snapshotBlockSize));
+
+            // The first step sets everything, so both instances start alike
+            step.changeSettings = plan.empty() || random.nextInt(8) == 0;
+            step.wet = random.nextFloat();
+            step.decay = 0.1f + 5.9f * random.nextFloat();
+            step.width = random.nextFloat();
+
+            plan.push_back(step);
+            start += step.numSamples;
+        }
+
+        return plan;
+    }
+
+    // The settings in effect after steps [0, end)
+    RenderStep getSettingsBefore(const std::vector<RenderStep>& plan, size_t end)
+    {
+        for (size_t s = end; s-- > 0;)
+            if (plan[s].changeSettings)
+                return plan[s];
+
+        return plan.front();
+    }
+
+    struct EngineUnderTest
+    {
+        EngineUnderTest(ReverbEngine::Algorithm algorithm, int ecoFactor, int numChannels, const juce::File& impulse)
+        {
+            engine.prepare(snapshotSampleRate, snapshotBlockSize, ecoFactor,
+                           LusionSmartReverbAudioProcessor::getLayoutForChannelCount(numChannels));
+            engine.setAlgorithm(algorithm);
+
+            if (algorithm == ReverbEngine::Algorithm::convolution)
+            {
+                engine.loadImpulseResponse(impulse);
+
+                while (engine.isImpulseResponseLoading())
+                    juce::Thread::sleep(2);
+            }
+        }
+
+        void process(juce::AudioBuffer<float>& block, const RenderStep& step)
+        {
+            if (step.changeSettings)
+            {
+                engine.setWet(step.wet);
+                engine.setDecay(step.decay);
+                engine.setWidth(step.width);
+            }
+
+            engine.process(block);
+        }
+
+        juce::MemoryBlock createSnapshot() const { return engine.createSnapshot(); }
+
+        // The engine's snapshot carries its settings too
+        bool restoreSnapshot(const juce::MemoryBlock& snapshot, const RenderStep&)
+        {
+            return engine.restoreSnapshot(snapshot.getData(), snapshot.getSize());
+        }
+
+        ReverbEngine engine;
+    };
+
+    struct ProcessorUnderTest
+    {
+        ProcessorUnderTest(ReverbEngine::Algorithm algorithm, int ecoFactor, int numChannels, const juce::File& impulse)
+            : processor(BenchmarkSupport::createProcessor(numChannels, snapshotSampleRate, snapshotBlockSize,
+                                                          algorithm, false, impulse, ecoFactor))
+        {
+            if (processor == nullptr)
+                juce::ConsoleApplication::fail("No processor for " + juce::String(numChannels) + " channels");
+        }
+
+        void applySettings(const RenderStep& step)
+        {
+            BenchmarkSupport::setParameter(processor->apvts, "WET", step.wet);
+            BenchmarkSupport::setParameter(processor->apvts, "DECAY", step.decay);
+            BenchmarkSupport::setParameter(processor->apvts, "WIDTH", step.width);
+        }
+
+        void process(juce::AudioBuffer<float>& block, const RenderStep& step)
+        {
+            if (step.changeSettings)
+                applySettings(step);
+
+            processor->processBlock(block, midi);
+        }
+
+        juce::MemoryBlock createSnapshot() const { return processor->createProcessingSnapshot(); }
+
+        // Parameters aren't part of a processing snapshot
+        bool restoreSnapshot(const juce::MemoryBlock& snapshot, const RenderStep& settings)
+        {
+            applySettings(settings);
+            return processor->restoreProcessingSnapshot(snapshot);
+        }
+
+        std::unique_ptr<LusionSmartReverbAudioProcessor> processor;
+        juce::MidiBuffer midi;
+    };
+
+    template <typename UnderTest>
+    void renderSteps(UnderTest& instance, const std::vector<RenderStep>& plan, size_t first, size_t last,
+                     const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output)
+    {
+        juce::AudioBuffer<float> block(input.getNumChannels(), snapshotBlockSize);
+
+        for (size_t s = first; s < last; ++s)
+        {
+            const auto& step = plan[s];
+            block.setSize(input.getNumChannels(), step.numSamples, false, false, true);
+
+            for (int ch = 0; ch < input.getNumChannels(); ++ch)
+                block.copyFrom(ch, 0, input, ch, step.start, step.numSamples);
+
+            instance.process(block, step);
+
+            for (int ch = 0; ch < input.getNumChannels(); ++ch)
+                output.copyFrom(ch, step.start, block, ch, 0, step.numSamples);
+        }
+    }
+
+    template <typename UnderTest>
+    bool checkSnapshot(const juce::String& target, ReverbEngine::Algorithm algorithm, int ecoFactor,
+                       int numChannels, const juce::File& impulse, juce::Random& random)
+    {
+        const int numSamples = (int)(snapshotSampleRate * 2.0);
+        const auto plan = createRenderPlan(numSamples, random);
+        const size_t cut = plan.size() / 2;
+
+        // Programme material, then silence for the tail and the silence gate
+        juce::AudioBuffer<float> input(numChannels, numSamples), other(numChannels, numSamples);
+        BenchmarkSupport::fillTestSignal(input, snapshotSampleRate, random.nextInt());
+        BenchmarkSupport::fillTestSignal(other, snapshotSampleRate, random.nextInt());
+        input.clear(numSamples * 3 / 4, numSamples / 4);
+
+        juce::AudioBuffer<float> expected(numChannels, numSamples), actual(numChannels, numSamples);
+        expected.clear();
+        actual.clear();
+
+        UnderTest original(algorithm, ecoFactor, numChannels, impulse);
+        renderSteps(original, plan, 0, cut, input, expected);
+        const auto snapshot = original.createSnapshot();
+        renderSteps(original, plan, cut, plan.size(), input, expected);
+
+        // The restoring instance has state of its own to overwrite
+        UnderTest restored(algorithm, ecoFactor, numChannels, impulse);
+        renderSteps(restored, plan, 0, cut, other, actual);
+
+        const bool accepted = restored.restoreSnapshot(snapshot, getSettingsBefore(plan, cut));
+
+        if (accepted)
+            renderSteps(restored, plan, cut, plan.size(), input, actual);
+
+        const int resumeAt = plan[cut].start;
+        int firstDifference = -1;
+
+        for (int i = resumeAt; i < numSamples && accepted && firstDifference < 0; ++i)
+            for (int ch = 0; ch < numChannels; ++ch)
+                if (std::memcmp(expected.getReadPointer(ch) + i, actual.getReadPointer(ch) + i, sizeof(float)) != 0)
+                    firstDifference = i;
+
+        const bool passed = accepted && firstDifference < 0;
+
+        juce::String detail;
+
+        if (!accepted)
+            detail = "snapshot rejected";
+        else if (firstDifference >= 0)
+            detail = "differs from sample " + juce::String(firstDifference - resumeAt) + " after the restore";
+        else
+            detail = "bit-identical over " + juce::String(numSamples - resumeAt) + " samples";
+
+        report("snapshot/" + target + "/" + BenchmarkSupport::getAlgorithmName(algorithm)
+                   + "/eco" + juce::String(ecoFactor) + "/"
+                   + (numChannels <= 2 ? juce::String(numChannels == 1 ? "mono" : "stereo")
+                                       : juce::String(numChannels) + "ch"),
+               passed, detail);
+
+        return passed;
+    }
+
+    // A second of decaying stereo noise for the convolution cases, as a WAV
+    // file the impulse response cache can load
+    void writeTestImpulse(const juce::File& file, juce::Random& random)
+    {
+        juce::AudioBuffer<float> impulse(2, (int)snapshotSampleRate);
+
+        for (int ch = 0; ch < impulse.getNumChannels(); ++ch)
+            for (int i = 0; i < impulse.getNumSamples(); ++i)
+                impulse.setSample(ch, i, (2.0f * random.nextFloat() - 1.0f)
+                                             * std::exp(-6.0f * (float)i / (float)impulse.getNumSamples()));
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::OutputStream> stream = file.createOutputStream();
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+
+        if (stream != nullptr)
+            writer = wav.createWriterFor(stream, juce::AudioFormatWriterOptions{}
+                                                     .withSampleRate(snapshotSampleRate)
+                                                     .withNumChannels(impulse.getNumChannels())
+                                                     .withBitsPerSample(24));
+
+        if (writer == nullptr || !writer->writeFromAudioSampleBuffer(impulse, 0, impulse.getNumSamples()))
+            juce::ConsoleApplication::fail("Can't write " + file.getFullPathName());
+    }
+
+    int runSnapshotChecks(juce::Random& random)
+    {
+        juce::TemporaryFile impulse(".wav");
+        writeTestImpulse(impulse.getFile(), random);
+
+        int numFailed = 0;
+
+        for (int numChannels : { 1, 2, 6, 12 })
+            for (auto algorithm : { ReverbEngine::Algorithm::classic, ReverbEngine::Algorithm::fdn,
+                                    ReverbEngine::Algorithm::convolution })
+            {
+                // Wider layouts run the MultichannelBank whatever the algorithm
+                if (numChannels > 2 && algorithm != ReverbEngine::Algorithm::classic)
+                    continue;
+
+                for (int ecoFactor : { 1, 2, 4 })
+                {
+                    numFailed += checkSnapshot<EngineUnderTest>("engine", algorithm, ecoFactor, numChannels,
+                                                                impulse.getFile(), random) ? 0 : 1;
+                    numFailed += checkSnapshot<ProcessorUnderTest>("processor", algorithm, ecoFactor, numChannels,
+                                                                   impulse.getFile(), random) ? 0 : 1;
+                }
+            }
+
+        return numFailed;
+    }
+
+    //==============================================================================
+    // Each kernel case builds one set of random inputs, runs it through both
+    // tables on copies and compares everything the kernel writes
+    std::vector<float> randomFloats(size_t size, juce::Random& random, float range = 1.0f)
+    {
+        std::vector<float> values(size);
+
+        for (auto& x : values)
+            x = range * (2.0f * random.nextFloat() - 1.0f);
+
+        return values;
+    }
+
+    bool sameBits(const std::vector<float>& a, const std::vector<float>& b)
+    {
+        return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+    }
+
+    bool checkCombSteps(const DspKernels::Table& reference, const DspKernels::Table& candidate, juce::Random& random)
+    {
+        const int numLanes = 4 * (1 + random.nextInt(8));
+        const int rowStride = numLanes + 4 * random.nextInt(3);
+        const int numRows = 1 + random.nextInt(32);
+
+        const auto tile = randomFloats((size_t)(rowStride * numRows), random);
+        const auto last = randomFloats((size_t)numLanes, random);
+        const auto damping = randomFloats((size_t)numRows, random, 0.5f);
+        const auto feedback = randomFloats((size_t)numRows, random);
+        const auto input = randomFloats((size_t)numRows, random);
+
+        auto tileA = tile, tileB = tile, lastA = last, lastB = last;
+        reference.combSteps(tileA.data(), rowStride, numRows, numLanes, lastA.data(),
+                            damping.data(), feedback.data(), input.data());
+        candidate.combSteps(tileB.data(), rowStride, numRows, numLanes, lastB.data(),
+                            damping.data(), feedback.data(), input.data());
+
+        return sameBits(tileA, tileB) && sameBits(lastA, lastB);
+    }
+
+    bool checkMultiplyAccumulate(const DspKernels::Table& reference, const DspKernels::Table& candidate,
+                                 juce::Random& random)
+    {
+        const int partitionSize = 1 << (2 + random.nextInt(10));
+        const size_t spectrumSize = (size_t)PartitionedConvolver::getSpectrumSize(partitionSize);
+
+        const auto x = randomFloats(spectrumSize, random);
+        const auto h = randomFloats(spectrumSize, random);
+        const auto acc = randomFloats(spectrumSize, random);
+
+        auto accA = acc, accB = acc;
+        reference.multiplyAccumulate(x.data(), h.data(), accA.data(), partitionSize);
+        candidate.multiplyAccumulate(x.data(), h.data(), accB.data(), partitionSize);
+
+        return sameBits(accA, accB);
+    }
+
+    bool checkDecimate(const DspKernels::Table& reference, const DspKernels::Table& candidate, juce::Random& random)
+    {
+        constexpr int numCoefficients = HalfBandFilter::numCoefficients;
+        const int numOutputs = 1 + random.nextInt(300);
+
+        // odd is read numCoefficients either side of each output
+        const auto even = randomFloats((size_t)numOutputs, random);
+        const auto odd = randomFloats((size_t)(numOutputs + 2 * numCoefficients), random);
+        const float* oddCentre = odd.data() + numCoefficients;
+
+        std::vector<float> outputA((size_t)numOutputs), outputB((size_t)numOutputs);
+        reference.decimate(even.data(), oddCentre, HalfBandFilter::coefficients, numCoefficients, numOutputs, outputA.data());
+        candidate.decimate(even.data(), oddCentre, HalfBandFilter::coefficients, numCoefficients, numOutputs, outputB.data());
+
+        return sameBits(outputA, outputB);
+    }
+
+    bool checkInterpolate(const DspKernels::Table& reference, const DspKernels::Table& candidate, juce::Random& random)
+    {
+        constexpr int numCoefficients = HalfBandFilter::numCoefficients;
+        const int numInputs = 1 + random.nextInt(300);
+
+        const auto history = randomFloats((size_t)(numInputs + 2 * numCoefficients), random);
+        const float* first = history.data() + numCoefficients;
+
+        std::vector<float> outputA((size_t)(2 * numInputs)), outputB((size_t)(2 * numInputs));
+        reference.interpolate(first, HalfBandFilter::coefficients, numCoefficients, numInputs, outputA.data());
+        candidate.interpolate(first, HalfBandFilter::coefficients, numCoefficients, numInputs, outputB.data());
+
+        return sameBits(outputA, outputB);
+    }
+
+    bool checkAnalyse(const DspKernels::Table& reference, const DspKernels::Table& candidate, juce::Random& random)
+    {
+        const int numChannels = 1 + random.nextInt(ReverbEngine::maxChannels);
+        const int numSamples = 1 + random.nextInt(200);
+
+        // Small matrices, so the filter stays bounded over the block
+        DspKernels::BlockFilter filter;
+
+        for (auto* matrix : { filter.output, filter.feedthrough, filter.transition, filter.input })
+            for (int i = 0; i < 16; ++i)
+                matrix[i] = 0.2f * (2.0f * random.nextFloat() - 1.0f);
+
+        for (auto& section : filter.sections)
+            for (auto& c : section)
+                c = 0.2f * (2.0f * random.nextFloat() - 1.0f);
+
+        std::vector<std::vector<float>> samples;
+        std::vector<const float*> channels;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            samples.push_back(randomFloats((size_t)numSamples, random));
+            channels.push_back(samples.back().data());
+        }
+
+        const auto state = randomFloats((size_t)(4 * numChannels), random);
+        auto stateA = state, stateB = state;
+        std::vector<float> resultsA((size_t)(3 * numChannels)), resultsB((size_t)(3 * numChannels));
+
+        reference.analyse(channels.data(), numChannels, numSamples, filter, stateA.data(), resultsA.data());
+        candidate.analyse(channels.data(), numChannels, numSamples, filter, stateB.data(), resultsB.data());
+
+        return sameBits(stateA, stateB) && sameBits(resultsA, resultsB);
+    }
+
+    bool checkFdnSteps(const DspKernels::Table& reference, const DspKernels::Table& candidate, juce::Random& random)
+    {
+        constexpr int numLines = DspKernels::FdnTank::numLines;
+        const int numSamples = 1 + random.nextInt(100);
+
+        // Ascending lengths, so the last line has the largest mask
+        DspKernels::FdnTank tank {};
+        int offsets[numLines];
+        size_t totalSize = 0;
+
+        for (int i = 0; i < numLines; ++i)
+        {
+            const int previous = i > 0 ? tank.delays[i - 1] : 0;
+            tank.delays[i] = previous + 1 + random.nextInt(40);
+            tank.masks[i] = juce::nextPowerOfTwo(tank.delays[i] + 1) - 1;
+            offsets[i] = (int)totalSize;
+            totalSize += (size_t)tank.masks[i] + 1;
+        }
+
+        tank.writePos = random.nextInt(tank.masks[numLines - 1] + 1);
+        tank.lineGainRampRemaining = random.nextInt(2) == 0 ? 0 : 1 + random.nextInt(numSamples);
+        tank.damping = random.nextFloat();
+
+        for (int i = 0; i < numLines; ++i)
+        {
+            tank.lowpass[i] = 2.0f * random.nextFloat() - 1.0f;
+            tank.lineGain[i] = random.nextFloat();
+            tank.lineGainTarget[i] = random.nextFloat();
+            tank.lineGainStep[i] = (tank.lineGainTarget[i] - tank.lineGain[i]) / 64.0f;
+            tank.injectL[i] = 2.0f * random.nextFloat() - 1.0f;
+            tank.injectR[i] = 2.0f * random.nextFloat() - 1.0f;
+            tank.tapL[i] = 2.0f * random.nextFloat() - 1.0f;
+            tank.tapR[i] = 2.0f * random.nextFloat() - 1.0f;
+        }
+
+        const auto lines = randomFloats(totalSize, random);
+        const auto inL = randomFloats((size_t)numSamples, random);
+        const auto inR = randomFloats((size_t)numSamples, random);
+
+        const auto run = [&](const DspKernels::Table& table, std::vector<float>& memory, std::vector<float>& out)
+            {
+                auto copy = tank;
+                memory = lines;
+
+                for (int i = 0; i < numLines; ++i)
+                    copy.lines[i] = memory.data() + offsets[i];
+
+                out.assign((size_t)(2 * numSamples), 0.0f);
+                table.fdnSteps(copy, inL.data(), inR.data(), out.data(), out.data() + numSamples, numSamples);
+
+                // Then the state the kernel moves on
+                out.insert(out.end(), std::begin(copy.lowpass), std::end(copy.lowpass));
+                out.insert(out.end(), std::begin(copy.lineGain), std::end(copy.lineGain));
+                return std::make_pair(copy.writePos, copy.lineGainRampRemaining);
+            };
+
+        std::vector<float> memoryA, memoryB, outA, outB;
+        const auto positionsA = run(reference, memoryA, outA);
+        const auto positionsB = run(candidate, memoryB, outB);
+
+        return positionsA == positionsB && sameBits(memoryA, memoryB) && sameBits(outA, outB);
+    }
+
+    int runKernelChecks(juce::Random& random)
+    {
+        using KernelCheck = bool (*)(const DspKernels::Table&, const DspKernels::Table&, juce::Random&);
+
+        const std::pair<const char*, KernelCheck> kernels[] = {
+            { "combSteps",          checkCombSteps },
+            { "multiplyAccumulate", checkMultiplyAccumulate },
+            { "decimate",           checkDecimate },
+            { "interpolate",        checkInterpolate },
+            { "analyse",            checkAnalyse },
+            { "fdnSteps",           checkFdnSteps },
+        };
+
+        constexpr int numCases = 200;
+
+        const auto previous = DspKernels::getActiveIsa();
+        DspKernels::setActiveIsa(DspKernels::Isa::baseline);
+        const auto& reference = DspKernels::get();
+
+        int numFailed = 0;
+
+        for (auto isa : { DspKernels::Isa::avx2, DspKernels::Isa::avx512 })
+        {
+            const juce::String prefix = juce::String("kernels/") + DspKernels::getName(isa) + "/";
+
+            if (!DspKernels::setActiveIsa(isa))
+            {
+                report(prefix + "*", true, "skipped, not available");
+                continue;
+            }
+
+            const auto& candidate = DspKernels::get();
+
+            for (const auto& kernel : kernels)
+            {
+                int numDifferent = 0;
+
+                for (int i = 0; i < numCases; ++i)
+                    numDifferent += kernel.second(reference, candidate, random) ? 0 : 1;
+
+                report(prefix + kernel.first, numDifferent == 0,
+                       numDifferent == 0 ? juce::String(numCases) + " cases bit-identical"
+                                         : juce::String(numDifferent) + " of " + juce::String(numCases) + " differ");
+
+                numFailed += numDifferent == 0 ? 0 : 1;
+            }
+        }
+
+        DspKernels::setActiveIsa(previous);
+        return numFailed;
+    }
+
+    //==============================================================================
+    // Each returns how many of its cases failed
+    struct Check
+    {
+        const char* name;
+        int (*run)(juce::Random&);
+    };
+
+    const Check checks[] = {
+        { "convolver", runConvolverChecks },
+        { "freeverb",  runFreeverbChecks },
+        { "snapshot",  runSnapshotChecks },
+        { "kernels",   runKernelChecks },
+    };
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;
+    juce::ArgumentList args(argc, argv);
+
+    return juce::ConsoleApplication::invokeCatchingFailures([&]
+    {
+        if (args.containsOption("--help|-h"))
+        {
+            printUsage();
+            return 0;
+        }
+
+        juce::StringArray names;
+
+        for (const auto& check : checks)
+            names.add(check.name);
+
+        auto selected = args.containsOption("--checks")
+            ? juce::StringArray::fromTokens(args.getValueForOption("--checks"), ",", {})
+            : names;
+
+        selected.trim();
+
+        for (const auto& name : selected)
+            if (!names.contains(name))
+                juce::ConsoleApplication::fail("Unknown check " + name + " (have " + names.joinIntoString(",") + ")");
+
+        const auto seed = args.containsOption("--seed") ? args.getValueForOption("--seed").getLargeIntValue() : (juce::int64)1;
+        int numFailed = 0;
+
+        for (const auto& check : checks)
+        {
+            if (!selected.contains(check.name))
+                continue;
+
+            // Each check gets the same numbers whichever others run
+            juce::Random random(seed);
+
+            std::cout << check.name << "\n";
+            numFailed += check.run(random);
+        }
+
+        std::cout << "\n" << (numFailed == 0 ? juce::String("All checks passed")
+                                             : juce::String(numFailed) + " failed") << "\n";
+
+        return numFailed == 0 ? 0 : 1;
+    });
+}
@@ -0,0 +1,711 @@
+#include <JuceHeader.h>
+#include "BenchmarkSupport.h"
+
+#if JUCE_LINUX
+ #include <linux/perf_event.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#endif
+
+//==============================================================================
+// LusionLoadTest
+//
+// Runs N plugin instances inside a simulated host audio callback, for each N
+// in a list, and reports how close the callback comes to its deadline:
+//
+//   LusionLoadTest [--instances=1,8,64,256,512] [--rate=48000] [--block=256]
+//                  [--variable=0.3] [--jitter=0.1] [--seconds=10]
+//                  [--threads=1] [--switch-rate=0.02] [--free-run]
+//                  [--tolerance=0] [--worker] [--isa=avx2] [--out=load.json]
+//                  [--label=<text>]
+//
+// Like a real host:
+//   - callbacks are paced at the audio rate, with a random wake-up delay of
+//     up to --jitter of the period that eats into the deadline
+//   - a --variable share of callbacks get a random size up to --block
+//     instead of the full buffer
+//   - every instance has its own input and its own parameter automation:
+//     WET, DECAY and WIDTH sweep continuously, and AUTO or ENGINE flip about
+//     --switch-rate times per second
+//   - --threads spreads the instances over that many audio threads
+//
+// A callback misses its deadline when it ends later than one period after
+// it was due. Latency is the processing time of the callback itself. On
+// Linux, hardware cache misses are counted per callback (when perf events
+// are permitted); elsewhere, or without permission, the cost per instance
+// relative to N=1 is the only sign of cache pressure.
+//
+// --free-run skips the pacing and jitter and runs callbacks back to back.
+// --worker turns on every instance's WORKER parameter, so the callback only
+// hands blocks to the shared worker pool and collects the previous ones. The
+// blocks the pool didn't finish in time, which the instances ran inline or
+// let through dry, are reported as late blocks.
+// --isa runs every instance on one kernel instruction set (see DspKernels)
+// instead of the one the plugin would choose.
+//==============================================================================
+namespace
+{
+    struct Settings
+    {
+        double sampleRate = 48000.0;
+        int maxBlockSize = 256;
+        double variableFraction = 0.3;
+        double jitter = 0.1;
+        double seconds = 10.0;
+        int numThreads = 1;
+        double switchesPerSecond = 0.02;
+        bool paced = true;
+        bool worker = false;
+    };
+
+    //==============================================================================
+    // Counts last-level cache misses and references of the calling thread
+    class CacheMissCounter
+    {
+    public:
+        CacheMissCounter()
+        {
+           #if JUCE_LINUX
+            missesFd = open(PERF_COUNT_HW_CACHE_MISSES);
+            referencesFd = open(PERF_COUNT_HW_CACHE_REFERENCES);
+           #endif
+        }
+
+        ~CacheMissCounter()
+        {
+           #if JUCE_LINUX
+            for (int fd : { missesFd, referencesFd })
+                if (fd >= 0)
+                    close(fd);
+           #endif
+        }
+
+        bool isAvailable() const { return missesFd >= 0 && referencesFd >= 0; }
+
+        juce::uint64 getMisses() const     { return read(missesFd); }
+        juce::uint64 getReferences() const { return read(referencesFd); }
+
+    private:
+       #if JUCE_LINUX
+        static int open(juce::uint64 config)
+        {
+            perf_event_attr attr{};
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = config;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+
+            return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+
+        static juce::uint64 read(int fd)
+        {
+            juce::uint64 value = 0;
+
+            if (fd >= 0 && ::read(fd, &value, sizeof(value)) != (ssize_t)sizeof(value))
+                value = 0;
+
+            return value;
+        }
+       #else
+        static juce::uint64 read(int) { return 0; }
+       #endif
+
+        int missesFd = -1, referencesFd = -1;
+
+        JUCE_DECLARE_NON_COPYABLE(CacheMissCounter)
+    };
+
+    //==============================================================================
+    class Instance
+    {
+    public:
+        Instance(int index, const Settings& settings, const juce::AudioBuffer<float>& input)
+            : random(index + 1), signal(input)
+        {
+            const auto algorithm = random.nextBool() ? ReverbEngine::Algorithm::fdn : ReverbEngine::Algorithm::classic;
+
+            processor = BenchmarkSupport::createProcessor(2, settings.sampleRate, settings.maxBlockSize,
+                                                          algorithm, random.nextBool(), {}, 1, settings.worker);
+            jassert(processor != nullptr);
+
+            buffer.setSize(2, settings.maxBlockSize);
+
+            // Each instance plays a different part of the signal, like separate tracks
+            inputPosition = random.nextInt(juce::jmax(1, signal.getNumSamples() - settings.maxBlockSize));
+
+            // Host automation goes through the parameter objects, never by name
+            auto& apvts = processor->apvts;
+            ramps[0].param = apvts.getParameter("WET");
+            ramps[1].param = apvts.getParameter("DECAY");
+            ramps[2].param = apvts.getParameter("WIDTH");
+            switches[0] = apvts.getParameter("AUTO");
+            switches[1] = apvts.getParameter("ENGINE");
+
+            for (auto& ramp : ramps)
+            {
+                ramp.value = random.nextFloat();
+                ramp.target = random.nextFloat();
+                setFromHost(ramp.param, ramp.value);
+            }
+        }
+
+        void process(int numSamples, const Settings& settings)
+        {
+            automate(numSamples, settings);
+
+            buffer.setSize(2, numSamples, false, false, true);
+
+            if (inputPosition + numSamples > signal.getNumSamples())
+                inputPosition = 0;
+
+            for (int ch = 0; ch < 2; ++ch)
+                buffer.copyFrom(ch, 0, signal, ch, inputPosition, numSamples);
+
+            inputPosition += numSamples;
+
+            processor->processBlock(buffer, midi);
+        }
+
+        int getNumLateBlocks() const { return processor->getNumMissedWorkerDeadlines(); }
+
+    private:
+        struct Ramp
+        {
+            juce::RangedAudioParameter* param = nullptr;
+            float value = 0.0f, target = 0.0f;
+        };
+
+        void automate(int numSamples, const Settings& settings)
+        {
+            const double blockSeconds = numSamples / settings.sampleRate;
+
+            // Sweeps cover the whole range in about two seconds
+            const float step = (float)(blockSeconds * 0.5);
+
+            for (auto& ramp : ramps)
+            {
+                if (std::abs(ramp.target - ramp.value) <= step)
+                {
+                    ramp.value = ramp.target;
+                    ramp.target = random.nextFloat();
+                }
+                else
+                {
+                    ramp.value += ramp.target > ramp.value ? step : -step;
+                }
+
+                setFromHost(ramp.param, ramp.value);
+            }
+
+            if (random.nextDouble() < settings.switchesPerSecond * blockSeconds)
+            {
+                auto* param = switches[random.nextInt(2)];
+                setFromHost(param, param->getValue() > 0.5f ? 0.0f : 1.0f);
+            }
+        }
+
+        // What the plugin wrappers do when the host automates a parameter
+        static void setFromHost(juce::RangedAudioParameter* param, float normalisedValue)
+        {
+            param->setValue(normalisedValue);
+            param->sendValueChangedMessageToListeners(normalisedValue);
+        }
+
+        juce::Random random;
+        std::unique_ptr<LusionSmartReverbAudioProcessor> processor;
+        juce::AudioBuffer<float> buffer;
+        juce::MidiBuffer midi;
+
+        const juce::AudioBuffer<float>& signal;
+        int inputPosition = 0;
+
+        Ramp ramps[3];
+        juce::RangedAudioParameter* switches[2] = {};
+
+        JUCE_DECLARE_NON_COPYABLE(Instance)
+    };
+
+    //==============================================================================
+    // One audio thread's share of the instances. Group 0 runs on the host
+    // thread itself; the others wait for each callback on their own thread.
+    class InstanceGroup : public juce::Thread
+    {
+    public:
+        explicit InstanceGroup(const Settings& s) : juce::Thread("Load test audio"), settings(s) {}
+
+        ~InstanceGroup() override
+        {
+            signalThreadShouldExit();
+            start.signal();
+            stopThread(1000);
+        }
+
+        void add(Instance* instance) { instances.push_back(instance); }
+
+        void startWorker(double periodMs)
+        {
+            if (!startRealtimeThread(juce::Thread::RealtimeOptions{}.withPeriodMs(periodMs)))
+                startThread(juce::Thread::Priority::highest);
+
+            // Counters are per thread, so wait for the worker to open its own
+            ready.wait();
+        }
+
+        // Called on the host thread
+        void beginCallback(int numSamples)
+        {
+            blockSize = numSamples;
+            start.signal();
+        }
+
+        void endCallback()
+        {
+            done.wait();
+        }
+
+        void processOnCurrentThread(int numSamples)
+        {
+            if (counter == nullptr)
+                counter = std::make_unique<CacheMissCounter>();
+
+            processInstances(numSamples);
+        }
+
+        bool hasCacheCounters() const { return counter != nullptr && counter->isAvailable(); }
+
+        juce::uint64 getCacheMisses() const     { return cacheMisses.load(); }
+        juce::uint64 getCacheReferences() const { return cacheReferences.load(); }
+
+        void run() override
+        {
+            counter = std::make_unique<CacheMissCounter>();
+            ready.signal();
+
+            for (;;)
+            {
+                start.wait();
+
+                if (threadShouldExit())
+                    break;
+
+                processInstances(blockSize);
+                done.signal();
+            }
+        }
+
+    private:
+        void processInstances(int numSamples)
+        {
+            const auto missesBefore = counter->getMisses();
+            const auto referencesBefore = counter->getReferences();
+
+            for (auto* instance : instances)
+                instance->process(numSamples, settings);
+
+            cacheMisses += counter->getMisses() - missesBefore;
+            cacheReferences += counter->getReferences() - referencesBefore;
+        }
+
+        const Settings& settings;
+        std::vector<Instance*> instances;
+        std::unique_ptr<CacheMissCounter> counter;
+
+        juce::WaitableEvent start, done, ready;
+        std::atomic<int> blockSize{ 0 };
+        std::atomic<juce::uint64> cacheMisses{ 0 }, cacheReferences{ 0 };
+    };
+
+    //==============================================================================
+    struct LoadResult
+    {
+        int numInstances = 0;
+        int numCallbacks = 0;
+        std::vector<double> latenciesMs;    // sorted
+        int deadlineMisses = 0;
+        double worstOverrunMs = 0.0;
+        double meanLoad = 0.0;              // processing time / period
+        double nsPerInstanceSample = 0.0;
+        int lateWorkerBlocks = 0;           // all instances, with --worker
+
+        bool hasCacheCounters = false;
+        double cacheMissesPerCallback = 0.0;
+        double cacheMissRate = 0.0;
+
+        double getMissPercent() const
+        {
+            return numCallbacks > 0 ? 100.0 * deadlineMisses / numCallbacks : 0.0;
+        }
+    };
+
+    class SimulatedHost : private juce::Thread
+    {
+    public:
+        SimulatedHost(const Settings& s, int numInstances, const juce::AudioBuffer<float>& signal)
+            : juce::Thread("Load test host"), settings(s)
+        {
+            for (int i = 0; i < numInstances; ++i)
+                instances.add(new Instance(i, settings, signal));
+
+            const int numGroups = juce::jlimit(1, juce::jmax(1, numInstances), settings.numThreads);
+
+            for (int g = 0; g < numGroups; ++g)
+                groups.add(new InstanceGroup(settings));
+
+            for (int i = 0; i < numInstances; ++i)
+                groups[i % numGroups]->add(instances[i]);
+        }
+
+        LoadResult measure()
+        {
+            const double periodMs = 1000.0 * settings.maxBlockSize / settings.sampleRate;
+
+            for (int g = 1; g < groups.size(); ++g)
+                groups[g]->startWorker(periodMs);
+
+            if (!startRealtimeThread(juce::Thread::RealtimeOptions{}.withPeriodMs(periodMs)))
+                startThread(juce::Thread::Priority::highest);
+
+            finished.wait();
+            stopThread(1000);
+
+            return result;
+        }
+
+    private:
+        void run() override
+        {
+            juce::Random random(12345);
+
+            const double averageBlock = settings.maxBlockSize * (1.0 - settings.variableFraction * 0.5);
+            const int numCallbacks = juce::jmax(1, (int)(settings.seconds * settings.sampleRate / averageBlock));
+
+            result.numInstances = instances.size();
+            result.numCallbacks = numCallbacks;
+            result.latenciesMs.reserve((size_t)numCallbacks);
+
+            const auto msNow = [] { return juce::Time::getMillisecondCounterHiRes(); };
+
+            double totalProcessMs = 0.0, loadSum = 0.0;
+            juce::int64 totalSamples = 0;
+
+            // Warm up every instance once, outside the measurement
+            processCallback(settings.maxBlockSize);
+
+            juce::uint64 missesBefore = 0, referencesBefore = 0;
+            int lateBlocksBefore = 0;
+
+            for (auto* instance : instances)
+                lateBlocksBefore += instance->getNumLateBlocks();
+
+            for (auto* group : groups)
+            {
+                missesBefore += group->getCacheMisses();
+                referencesBefore += group->getCacheReferences();
+            }
+
+            double due = msNow();
+
+            for (int i = 0; i < numCallbacks && !threadShouldExit(); ++i)
+            {
+                const int numSamples = random.nextDouble() < settings.variableFraction
+                    ? 1 + random.nextInt(settings.maxBlockSize)
+                    : settings.maxBlockSize;
+
+                const double periodMs = 1000.0 * numSamples / settings.sampleRate;
+
+                if (settings.paced)
+                    waitUntil(due + random.nextDouble() * settings.jitter * periodMs);
+
+                const double started = msNow();
+                processCallback(numSamples);
+                const double ended = msNow();
+
+                const double latency = ended - started;
+                const double overrun = (settings.paced ? ended - due : latency) - periodMs;
+
+                result.latenciesMs.push_back(latency);
+                totalProcessMs += latency;
+                loadSum += latency / periodMs;
+                totalSamples += numSamples;
+
+                if (overrun > 0.0)
+                {
+                    ++result.deadlineMisses;
+                    result.worstOverrunMs = juce::jmax(result.worstOverrunMs, overrun);
+                }
+
+                // A host that falls behind drops the lost time and starts the
+                // next period from now, rather than running late forever
+                due = juce::jmax(due + periodMs, ended);
+            }
+
+            std::sort(result.latenciesMs.begin(), result.latenciesMs.end());
+
+            for (auto* instance : instances)
+                result.lateWorkerBlocks += instance->getNumLateBlocks();
+
+            result.lateWorkerBlocks -= lateBlocksBefore;
+
+            const auto measured = (double)result.latenciesMs.size();
+            result.meanLoad = measured > 0 ? loadSum / measured : 0.0;
+            result.nsPerInstanceSample = totalSamples > 0
+                ? totalProcessMs * 1.0e6 / ((double)totalSamples * juce::jmax(1, instances.size()))
+                : 0.0;
+
+            juce::uint64 misses = 0, references = 0;
+            result.hasCacheCounters = true;
+
+            for (auto* group : groups)
+            {
+                result.hasCacheCounters = result.hasCacheCounters && group->hasCacheCounters();
+                misses += group->getCacheMisses();
+                references += group->getCacheReferences();
+            }
+
+            misses -= missesBefore;
+            references -= referencesBefore;
+
+            if (result.hasCacheCounters && measured > 0)
+            {
+                result.cacheMissesPerCallback = (double)misses / measured;
+                result.cacheMissRate = references > 0 ? (double)misses / (double)references : 0.0;
+            }
+
+            finished.signal();
+        }
+
+        void processCallback(int numSamples)
+        {
+            for (int g = 1; g < groups.size(); ++g)
+                groups[g]->beginCallback(numSamples);
+
+            groups[0]->processOnCurrentThread(numSamples);
+
+            for (int g = 1; g < groups.size(); ++g)
+                groups[g]->endCallback();
+        }
+
+        static void waitUntil(double targetMs)
+        {
+            for (;;)
+            {
+                const double remaining = targetMs - juce::Time::getMillisecondCounterHiRes();
+
+                if (remaining <= 0.0)
+                    return;
+
+                if (remaining > 2.0)
+                    juce::Thread::sleep((int)(remaining - 1.0));
+                else
+                    juce::Thread::yield();
+            }
+        }
+
+        const Settings& settings;
+        juce::OwnedArray<Instance> instances;
+        juce::OwnedArray<InstanceGroup> groups;
+
+        LoadResult result;
+        juce::WaitableEvent finished;
+    };
+
+    //==============================================================================
+    juce::var toJson(const LoadResult& r, double nominalPeriodMs, double baselineNs)
+    {
+        auto entry = std::make_unique<juce::DynamicObject>();
+
+        entry->setProperty("instances", r.numInstances);
+        entry->setProperty("callbacks", r.numCallbacks);
+
+        auto latency = std::make_unique<juce::DynamicObject>();
+        latency->setProperty("p50", BenchmarkSupport::getPercentile(r.latenciesMs, 50.0));
+        latency->setProperty("p90", BenchmarkSupport::getPercentile(r.latenciesMs, 90.0));
+        latency->setProperty("p99", BenchmarkSupport::getPercentile(r.latenciesMs, 99.0));
+        latency->setProperty("p99_9", BenchmarkSupport::getPercentile(r.latenciesMs, 99.9));
+        latency->setProperty("max", r.latenciesMs.empty() ? 0.0 : r.latenciesMs.back());
+        entry->setProperty("latencyMs", juce::var(latency.release()));
+
+        entry->setProperty("p99PeriodPercent", 100.0 * BenchmarkSupport::getPercentile(r.latenciesMs, 99.0) / nominalPeriodMs);
+        entry->setProperty("meanLoadPercent", r.meanLoad * 100.0);
+        entry->setProperty("deadlineMisses", r.deadlineMisses);
+        entry->setProperty("deadlineMissPercent", r.getMissPercent());
+        entry->setProperty("worstOverrunMs", r.worstOverrunMs);
+        entry->setProperty("nsPerInstanceSample", r.nsPerInstanceSample);
+        entry->setProperty("costRelativeToSingle", baselineNs > 0.0 ? r.nsPerInstanceSample / baselineNs : 1.0);
+        entry->setProperty("lateWorkerBlocks", r.lateWorkerBlocks);
+
+        if (r.hasCacheCounters)
+        {
+            entry->setProperty("cacheMissesPerCallback", r.cacheMissesPerCallback);
+            entry->setProperty("cacheMissRate", r.cacheMissRate);
+        }
+        else
+        {
+            entry->setProperty("cacheMissesPerCallback", juce::var());
+            entry->setProperty("cacheMissRate", juce::var());
+        }
+
+        return juce::var(entry.release());
+    }
+
+    void printUsage()
+    {
+        std::cout << "Usage: LusionLoadTest [--instances=N,N,...] [--rate=N] [--block=N] [--variable=<0-1>]\n"
+                     "                      [--jitter=<0-1>] [--seconds=N] [--threads=N] [--switch-rate=<per second>]\n"
+                     "                      [--free-run] [--tolerance=<miss percent>] [--worker] [--isa=<name>]\n"
+                     "                      [--out=<json>] [--label=<text>]\n"
+                     "Kernel instruction sets on this machine: " << BenchmarkSupport::getAvailableIsaNames() << "\n";
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;
+    juce::ArgumentList args(argc, argv);
+
+    return juce::ConsoleApplication::invokeCatchingFailures([&]
+    {
+        if (args.containsOption("--help|-h"))
+        {
+            printUsage();
+            return 0;
+        }
+
+        const auto option = [&](const char* name, const juce::String& fallback)
+            {
+                return args.containsOption(name) ? args.getValueForOption(name) : fallback;
+            };
+
+        Settings settings;
+        settings.sampleRate = option("--rate", "48000").getDoubleValue();
+        settings.maxBlockSize = option("--block", "256").getIntValue();
+        settings.variableFraction = juce::jlimit(0.0, 1.0, option("--variable", "0.3").getDoubleValue());
+        settings.jitter = juce::jlimit(0.0, 1.0, option("--jitter", "0.1").getDoubleValue());
+        settings.seconds = juce::jmax(0.1, option("--seconds", "10").getDoubleValue());
+        settings.numThreads = juce::jmax(1, option("--threads", "1").getIntValue());
+        settings.switchesPerSecond = juce::jmax(0.0, option("--switch-rate", "0.02").getDoubleValue());
+        settings.paced = !args.containsOption("--free-run");
+        settings.worker = args.containsOption("--worker");
+
+        const double tolerance = juce::jmax(0.0, option("--tolerance", "0").getDoubleValue());
+        const auto instanceCounts = BenchmarkSupport::parseIntList(option("--instances", "1,2,4,8,16,32,64,128,256,512"));
+
+        if (settings.sampleRate <= 0.0 || settings.maxBlockSize < 1)
+            juce::ConsoleApplication::fail("Sample rate and block size must be positive");
+
+        for (auto n : instanceCounts)
+            if (n < 1)
+                juce::ConsoleApplication::fail("Instance counts must be at least 1");
+
+        if (args.containsOption("--isa"))
+        {
+            DspKernels::Isa isa;
+
+            if (!BenchmarkSupport::parseIsa(option("--isa", ""), isa))
+                juce::ConsoleApplication::fail("Instruction set " + option("--isa", "") + " is not available (have "
+                                               + BenchmarkSupport::getAvailableIsaNames() + ")");
+
+            DspKernels::setActiveIsa(isa);
+        }
+
+        const double nominalPeriodMs = 1000.0 * settings.maxBlockSize / settings.sampleRate;
+
+        juce::AudioBuffer<float> signal(2, (int)(settings.sampleRate * 8.0) + settings.maxBlockSize);
+        BenchmarkSupport::fillTestSignal(signal, settings.sampleRate, 1);
+
+        const auto machine = BenchmarkSupport::describeMachine();
+
+        std::cout << machine["cpu"].toString() << ", " << machine["build"].toString() << " build, "
+                  << machine["isa"].toString() << " kernels, " << settings.maxBlockSize << " samples at " << settings.sampleRate << " Hz ("
+                  << juce::String(nominalPeriodMs, 2) << " ms), " << settings.numThreads << " audio thread(s)"
+                  << (settings.paced ? "" : ", free running") << (settings.worker ? ", worker pool" : "") << "\n\n";
+
+       #if JUCE_DEBUG
+        std::cout << "Warning: debug build, numbers are not representative\n\n";
+       #endif
+
+        std::cout << "instances     p50 ms     p99 ms   p99.9 ms     max ms   misses    ns/inst.smp  vs 1   cache misses/cb"
+                  << (settings.worker ? "   late blocks" : "") << "\n";
+
+        juce::Array<juce::var> results;
+        double baselineNs = 0.0;
+        int maxWithinTolerance = 0;
+        bool countersReported = false;
+
+        for (auto n : instanceCounts)
+        {
+            LoadResult r;
+
+            {
+                SimulatedHost host(settings, n, signal);
+                r = host.measure();
+            }
+
+            if (baselineNs <= 0.0)
+                baselineNs = r.nsPerInstanceSample;
+
+            const double relative = baselineNs > 0.0 ? r.nsPerInstanceSample / baselineNs : 1.0;
+
+            if (r.getMissPercent() <= tolerance)
+                maxWithinTolerance = juce::jmax(maxWithinTolerance, n);
+
+            if (!r.hasCacheCounters && !countersReported)
+            {
+                std::cerr << "Hardware cache counters unavailable; reporting relative cost only\n";
+                countersReported = true;
+            }
+
+            std::cout << juce::String(n).paddedLeft(' ', 9)
+                      << juce::String(BenchmarkSupport::getPercentile(r.latenciesMs, 50.0), 3).paddedLeft(' ', 11)
+                      << juce::String(BenchmarkSupport::getPercentile(r.latenciesMs, 99.0), 3).paddedLeft(' ', 11)
+                      << juce::String(BenchmarkSupport::getPercentile(r.latenciesMs, 99.9), 3).paddedLeft(' ', 11)
+                      << juce::String(r.latenciesMs.empty() ? 0.0 : r.latenciesMs.back(), 3).paddedLeft(' ', 11)
+                      << (juce::String(r.getMissPercent(), 2) + "%").paddedLeft(' ', 9)
+                      << juce::String(r.nsPerInstanceSample, 1).paddedLeft(' ', 15)
+                      << juce::String(relative, 2).paddedLeft(' ', 6)
+                      << (r.hasCacheCounters ? juce::String((juce::int64)r.cacheMissesPerCallback) : juce::String("-")).paddedLeft(' ', 18)
+                      << (settings.worker ? juce::String(r.lateWorkerBlocks).paddedLeft(' ', 14) : juce::String())
+                      << "\n";
+
+            results.add(toJson(r, nominalPeriodMs, baselineNs));
+        }
+
+        std::cout << "\nMost instances with at most " << tolerance << "% deadline misses: " << maxWithinTolerance << "\n";
+
+        if (args.containsOption("--out"))
+        {
+            auto config = std::make_unique<juce::DynamicObject>();
+            config->setProperty("sampleRate", settings.sampleRate);
+            config->setProperty("blockSize", settings.maxBlockSize);
+            config->setProperty("variableFraction", settings.variableFraction);
+            config->setProperty("jitter", settings.jitter);
+            config->setProperty("seconds", settings.seconds);
+            config->setProperty("threads", settings.numThreads);
+            config->setProperty("switchesPerSecond", settings.switchesPerSecond);
+            config->setProperty("paced", settings.paced);
+            config->setProperty("worker", settings.worker);
+            config->setProperty("tolerancePercent", tolerance);
+
+            auto report = std::make_unique<juce::DynamicObject>();
+            report->setProperty("tool", "LusionLoadTest");
+            report->setProperty("formatVersion", 1);
+            report->setProperty("label", option("--label", juce::Time::getCurrentTime().toISO8601(true)));
+            report->setProperty("machine", machine);
+            report->setProperty("config", juce::var(config.release()));
+            report->setProperty("results", results);
+            report->setProperty("maxInstancesWithinTolerance", maxWithinTolerance);
+
+            const auto out = args.getFileForOption("--out");
+
+            if (!BenchmarkSupport::writeJson(juce::var(report.release()), out))
+                juce::ConsoleApplication::fail("Can't write " + out.getFullPathName());
+
+            std::cout << "Wrote " << out.getFullPathName() << "\n";
+        }
+
+        return 0;
+    });
+}
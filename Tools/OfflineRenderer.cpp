@@ -0,0 +1,560 @@
+#include "OfflineRenderer.h"
+
+namespace
+{
+    // The wet path can peak above the input (wet gain up to 2.4 plus tank
+    // resonance), so tails are followed this much further than the floor
+    constexpr float tailHeadroomDb = 20.0f;
+
+    constexpr double silenceDb = -300.0;
+
+    // Files in a layout the plugin supports keep every channel; any other
+    // count is cut down to its first one or two, as a host would
+    int getRenderChannelCount(int fileChannels)
+    {
+        if (!LusionSmartReverbAudioProcessor::getLayoutForChannelCount(fileChannels).isDisabled())
+            return fileChannels;
+
+        return juce::jlimit(1, 2, fileChannels);
+    }
+
+    void readBlock(juce::AudioFormatReader& reader, juce::AudioBuffer<float>& block, juce::int64 pos)
+    {
+        if (pos < reader.lengthInSamples)
+            reader.read(&block, 0, block.getNumSamples(), pos, true, block.getNumChannels() > 1);
+        else
+            block.clear();
+    }
+
+    void interleave(const juce::AudioBuffer<float>& block, float* dest)
+    {
+        const int numChannels = block.getNumChannels();
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const float* src = block.getReadPointer(ch);
+
+            for (int i = 0; i < block.getNumSamples(); ++i)
+                dest[i * numChannels + ch] = src[i];
+        }
+    }
+
+    void deinterleave(const float* src, juce::AudioBuffer<float>& buffer, int numSamples)
+    {
+        const int numChannels = buffer.getNumChannels();
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            float* dest = buffer.getWritePointer(ch);
+
+            for (int i = 0; i < numSamples; ++i)
+                dest[i] = src[i * numChannels + ch];
+        }
+    }
+
+    float getMaxDifference(const juce::AudioBuffer<float>& a, int startA,
+                           const juce::AudioBuffer<float>& b, int startB, int numSamples)
+    {
+        float maxDiff = 0.0f;
+
+        for (int ch = 0; ch < a.getNumChannels(); ++ch)
+        {
+            const float* x = a.getReadPointer(ch, startA);
+            const float* y = b.getReadPointer(ch, startB);
+
+            for (int i = 0; i < numSamples; ++i)
+                maxDiff = juce::jmax(maxDiff, std::abs(x[i] - y[i]));
+        }
+
+        return maxDiff;
+    }
+}
+
+//==============================================================================
+// Chunks are whole numbers of blocks from the start of the file, so every
+// block AUTO analyses is the same one a serial render would see
+struct OfflineRenderer::ChunkPlan
+{
+    int numChannels = 0;
+    double sampleRate = 0.0;
+    int blockSize = 0;
+
+    juce::int64 totalLength = 0;
+    juce::int64 prerollSamples = 0;
+    juce::int64 controlPrerollSamples = 0;
+    int seamLength = 0;
+};
+
+struct OfflineRenderer::Chunk
+{
+    Chunk(const juce::File& output, int index)
+        : temp(output.getSiblingFile(output.getFileNameWithoutExtension() + "_chunk" + juce::String(index) + ".raw"))
+    {
+    }
+
+    juce::int64 start = 0, end = 0;
+
+    // Rendered audio as raw interleaved floats, stitched once all chunks are done
+    juce::TemporaryFile temp;
+
+    // First seamLength samples of this chunk, and the seamLength samples
+    // rendered past its end, to compare with the neighbours
+    juce::AudioBuffer<float> head, overrun;
+
+    bool ok = false;
+    juce::String error;
+};
+
+OfflineRenderer::OfflineRenderer(const RenderOptions& o)
+    : options(o)
+{
+    options.blockSize = juce::jlimit(1, 65536, options.blockSize);
+    options.tailSeconds = juce::jmax(0.0, options.tailSeconds);
+
+    formatManager.registerBasicFormats();
+}
+
+//==============================================================================
+std::unique_ptr<LusionSmartReverbAudioProcessor> OfflineRenderer::createProcessor(int numChannels, double sampleRate) const
+{
+    auto processor = std::make_unique<LusionSmartReverbAudioProcessor>();
+
+    const auto set = LusionSmartReverbAudioProcessor::getLayoutForChannelCount(numChannels);
+
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(set);
+    layout.outputBuses.add(set);
+
+    if (!processor->setBusesLayout(layout))
+        return nullptr;
+
+    processor->setNonRealtime(true);
+
+    if (options.presetXml.isNotEmpty())
+        processor->loadPresetFromXml(options.presetXml);
+
+    // Eco mode saves CPU live; renders always run the tanks at full rate,
+    // which also keeps them free of latency
+    if (auto* eco = processor->apvts.getParameter("ECO"))
+        eco->setValueNotifyingHost(0.0f);
+
+    // Likewise the worker pool: a render has nobody to wait for, and the
+    // processing snapshots need the state on this thread
+    if (auto* worker = processor->apvts.getParameter("WORKER"))
+        worker->setValueNotifyingHost(0.0f);
+
+    processor->setRateAndBufferSizeDetails(sampleRate, options.blockSize);
+    processor->prepareToPlay(sampleRate, options.blockSize);
+
+    // A host would start playing while the IR loads; a render must not
+    while (processor->isImpulseResponseLoading())
+        juce::Thread::sleep(2);
+
+    return processor;
+}
+
+std::unique_ptr<juce::AudioFormatReader> OfflineRenderer::createReader(const juce::File& input) const
+{
+    return std::unique_ptr<juce::AudioFormatReader>(formatManager.createReaderFor(input));
+}
+
+std::unique_ptr<juce::AudioFormatWriter> OfflineRenderer::createWriter(const juce::File& output, double sampleRate,
+                                                                       int numChannels, int sourceBitsPerSample) const
+{
+    auto* format = formatManager.findFormatForFileExtension(output.getFileExtension());
+
+    if (format == nullptr || (numChannels > 1 && !format->canDoStereo()))
+        return nullptr;
+
+    // Highest supported depth that doesn't exceed the requested one
+    const int wanted = options.bitsPerSample > 0 ? options.bitsPerSample : sourceBitsPerSample;
+    const auto depths = format->getPossibleBitDepths();
+
+    if (depths.isEmpty())
+        return nullptr;
+
+    int bits = depths.getFirst();
+    for (auto d : depths)
+        if (d <= wanted)
+            bits = juce::jmax(bits, d);
+
+    std::unique_ptr<juce::OutputStream> stream = output.createOutputStream();
+
+    if (stream == nullptr)
+        return nullptr;
+
+    return format->createWriterFor(stream, juce::AudioFormatWriterOptions{}
+                                               .withSampleRate(sampleRate)
+                                               .withNumChannels(numChannels)
+                                               .withBitsPerSample(bits));
+}
+
+//==============================================================================
+RenderResult OfflineRenderer::render(const juce::File& input, const juce::File& output) const
+{
+    RenderResult result;
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    auto reader = createReader(input);
+
+    if (reader == nullptr)
+    {
+        result.error = "can't read " + input.getFullPathName();
+        return result;
+    }
+
+    const int numChannels = getRenderChannelCount((int)reader->numChannels);
+    const double sampleRate = reader->sampleRate;
+    const int blockSize = options.blockSize;
+
+    auto processor = createProcessor(numChannels, sampleRate);
+
+    if (processor == nullptr)
+    {
+        result.error = "unsupported channel layout";
+        return result;
+    }
+
+    // Written next to the target and moved into place at the end, so an
+    // interrupted run never leaves a truncated file behind
+    juce::TemporaryFile temp(output);
+    auto writer = createWriter(temp.getFile(), sampleRate, numChannels, (int)reader->bitsPerSample);
+
+    if (writer == nullptr)
+    {
+        result.error = "can't write " + output.getFullPathName();
+        return result;
+    }
+
+    const juce::int64 inputLength = reader->lengthInSamples;
+    const juce::int64 totalLength = inputLength + (juce::int64)std::ceil(options.tailSeconds * sampleRate);
+
+    juce::AudioBuffer<float> buffer(numChannels, blockSize);
+    juce::MidiBuffer midi;
+
+    for (juce::int64 pos = 0; pos < totalLength; pos += blockSize)
+    {
+        const int n = (int)juce::jmin((juce::int64)blockSize, totalLength - pos);
+
+        // Views the first n samples, so processBlock sees the real block length
+        juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), numChannels, n);
+
+        readBlock(*reader, block, pos);
+        processor->processBlock(block, midi);
+
+        if (!writer->writeFromAudioSampleBuffer(block, 0, n))
+        {
+            result.error = "write failed for " + output.getFullPathName();
+            return result;
+        }
+    }
+
+    writer.reset();
+
+    if (!temp.overwriteTargetFileWithTemporary())
+    {
+        result.error = "can't replace " + output.getFullPathName();
+        return result;
+    }
+
+    result.ok = true;
+    result.numSamples = totalLength;
+    result.sampleRate = sampleRate;
+    result.wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+    return result;
+}
+
+//==============================================================================
+RenderResult OfflineRenderer::renderChunked(const juce::File& input, const juce::File& output, juce::ThreadPool& pool) const
+{
+    auto reader = createReader(input);
+
+    if (options.numChunks <= 1 || reader == nullptr || reader->lengthInSamples <= 0)
+        return render(input, output);
+
+    RenderResult result;
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    ChunkPlan plan;
+    plan.numChannels = getRenderChannelCount((int)reader->numChannels);
+    plan.sampleRate = reader->sampleRate;
+    plan.blockSize = options.blockSize;
+    plan.totalLength = reader->lengthInSamples + (juce::int64)std::ceil(options.tailSeconds * plan.sampleRate);
+
+    const int sourceBits = (int)reader->bitsPerSample;
+    reader.reset();
+
+    // Ask a processor with the preset applied how long its memory is
+    {
+        auto probe = createProcessor(plan.numChannels, plan.sampleRate);
+
+        if (probe == nullptr)
+        {
+            result.error = "unsupported channel layout";
+            return result;
+        }
+
+        const float attenuationDb = -options.errorFloorDb + tailHeadroomDb;
+
+        const auto toBlocks = [&plan](double seconds)
+            {
+                return (juce::int64)std::ceil(seconds * plan.sampleRate / plan.blockSize) * plan.blockSize;
+            };
+
+        plan.prerollSamples = toBlocks(probe->getTailSeconds(attenuationDb));
+        plan.controlPrerollSamples = juce::jmax((juce::int64)0,
+                                                toBlocks(probe->getControlSettleSeconds(attenuationDb)) - plan.prerollSamples);
+    }
+
+    const juce::int64 totalBlocks = (plan.totalLength + plan.blockSize - 1) / plan.blockSize;
+    const juce::int64 blocksPerChunk = (totalBlocks + options.numChunks - 1) / options.numChunks;
+    const int numChunks = (int)((totalBlocks + blocksPerChunk - 1) / juce::jmax((juce::int64)1, blocksPerChunk));
+
+    plan.seamLength = (int)juce::jmin(blocksPerChunk * plan.blockSize,
+                                      (juce::int64)std::ceil(options.seamCheckSeconds * plan.sampleRate));
+
+    juce::OwnedArray<Chunk> chunks;
+
+    for (int i = 0; i < numChunks; ++i)
+    {
+        auto* chunk = chunks.add(new Chunk(output, i));
+        chunk->start = i * blocksPerChunk * plan.blockSize;
+        chunk->end = juce::jmin(plan.totalLength, chunk->start + blocksPerChunk * plan.blockSize);
+    }
+
+    // Render every chunk on the pool and wait for all of them
+    std::atomic<int> numRemaining{ numChunks };
+    juce::WaitableEvent allDone;
+
+    for (auto* chunk : chunks)
+    {
+        pool.addJob([this, chunk, &plan, &input, &numRemaining, &allDone]
+            {
+                renderChunk(*chunk, plan, input);
+
+                if (--numRemaining == 0)
+                    allDone.signal();
+            });
+    }
+
+    allDone.wait();
+
+    for (auto* chunk : chunks)
+    {
+        if (!chunk->ok)
+        {
+            result.error = chunk->error;
+            return result;
+        }
+    }
+
+    // Measure every seam: the previous chunk's overrun was rendered with the
+    // full history, the next chunk's head only with its preroll
+    float seamDeviation = 0.0f;
+
+    for (int i = 1; i < numChunks; ++i)
+    {
+        const auto& before = *chunks[i - 1];
+        const auto& after = *chunks[i];
+        const int n = juce::jmin(before.overrun.getNumSamples(), after.head.getNumSamples());
+
+        seamDeviation = juce::jmax(seamDeviation, getMaxDifference(before.overrun, 0, after.head, 0, n));
+    }
+
+    // Stitch the chunks into the real output format
+    juce::TemporaryFile temp(output);
+    auto writer = createWriter(temp.getFile(), plan.sampleRate, plan.numChannels, sourceBits);
+
+    if (writer == nullptr)
+    {
+        result.error = "can't write " + output.getFullPathName();
+        return result;
+    }
+
+    juce::AudioBuffer<float> buffer(plan.numChannels, plan.blockSize);
+    juce::HeapBlock<float> interleaved((size_t)(plan.numChannels * plan.blockSize));
+
+    for (auto* chunk : chunks)
+    {
+        juce::FileInputStream in(chunk->temp.getFile());
+
+        for (juce::int64 pos = chunk->start; pos < chunk->end; pos += plan.blockSize)
+        {
+            const int n = (int)juce::jmin((juce::int64)plan.blockSize, chunk->end - pos);
+            const int bytes = n * plan.numChannels * (int)sizeof(float);
+
+            if (in.read(interleaved, bytes) != bytes)
+            {
+                result.error = "lost chunk data for " + output.getFullPathName();
+                return result;
+            }
+
+            deinterleave(interleaved, buffer, n);
+
+            if (!writer->writeFromAudioSampleBuffer(buffer, 0, n))
+            {
+                result.error = "write failed for " + output.getFullPathName();
+                return result;
+            }
+        }
+    }
+
+    writer.reset();
+
+    if (!temp.overwriteTargetFileWithTemporary())
+    {
+        result.error = "can't replace " + output.getFullPathName();
+        return result;
+    }
+
+    result.ok = true;
+    result.numSamples = plan.totalLength;
+    result.sampleRate = plan.sampleRate;
+    result.numChunks = numChunks;
+    result.prerollSeconds = plan.prerollSamples / plan.sampleRate;
+    result.controlPrerollSeconds = plan.controlPrerollSamples / plan.sampleRate;
+    result.seamDeviationDb = juce::Decibels::gainToDecibels((double)seamDeviation, silenceDb);
+    result.wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+    double worstDb = result.seamDeviationDb;
+
+    if (options.verifyAgainstSerial)
+    {
+        result.serialVerified = true;
+        result.serialDeviationDb = compareWithSerial(input, plan, chunks);
+        worstDb = juce::jmax(worstDb, result.serialDeviationDb);
+    }
+
+    if (worstDb > options.errorFloorDb)
+    {
+        result.ok = false;
+        result.error = "stitched output deviates by " + juce::String(worstDb, 1) + " dBFS, above the "
+                     + juce::String(options.errorFloorDb, 1) + " dBFS floor (file kept)";
+    }
+
+    return result;
+}
+
+void OfflineRenderer::renderChunk(Chunk& chunk, const ChunkPlan& plan, const juce::File& input) const
+{
+    auto reader = createReader(input);
+    auto processor = createProcessor(plan.numChannels, plan.sampleRate);
+
+    if (reader == nullptr || processor == nullptr)
+    {
+        chunk.error = "can't open " + input.getFullPathName();
+        return;
+    }
+
+    auto out = chunk.temp.getFile().createOutputStream();
+
+    if (out == nullptr)
+    {
+        chunk.error = "can't write " + chunk.temp.getFile().getFullPathName();
+        return;
+    }
+
+    const bool isLast = chunk.end == plan.totalLength;
+
+    const juce::int64 audioStart = juce::jmax((juce::int64)0, chunk.start - plan.prerollSamples);
+    const juce::int64 controlStart = juce::jmax((juce::int64)0, audioStart - plan.controlPrerollSamples);
+    const juce::int64 renderEnd = isLast ? chunk.end : juce::jmin(plan.totalLength, chunk.end + plan.seamLength);
+
+    chunk.head.setSize(plan.numChannels, (int)juce::jmin((juce::int64)plan.seamLength, chunk.end - chunk.start));
+    chunk.overrun.setSize(plan.numChannels, (int)(renderEnd - chunk.end));
+
+    juce::AudioBuffer<float> buffer(plan.numChannels, plan.blockSize);
+    juce::HeapBlock<float> interleaved((size_t)(plan.numChannels * plan.blockSize));
+    juce::MidiBuffer midi;
+
+    for (juce::int64 pos = controlStart; pos < renderEnd; pos += plan.blockSize)
+    {
+        const int n = (int)juce::jmin((juce::int64)plan.blockSize, renderEnd - pos);
+        juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), plan.numChannels, n);
+
+        readBlock(*reader, block, pos);
+
+        // Long before the chunk only the cheap level detector has memory left
+        if (pos < audioStart)
+        {
+            processor->advanceWithoutAudio(block);
+            continue;
+        }
+
+        processor->processBlock(block, midi);
+
+        if (pos < chunk.start)
+            continue;
+
+        if (pos < chunk.end)
+        {
+            interleave(block, interleaved);
+
+            if (!out->write(interleaved, (size_t)(n * plan.numChannels) * sizeof(float)))
+            {
+                chunk.error = "write failed for " + chunk.temp.getFile().getFullPathName();
+                return;
+            }
+
+            const int headOffset = (int)(pos - chunk.start);
+            const int numHead = juce::jmin(n, chunk.head.getNumSamples() - headOffset);
+
+            for (int ch = 0; ch < plan.numChannels && numHead > 0; ++ch)
+                chunk.head.copyFrom(ch, headOffset, block, ch, 0, numHead);
+        }
+        else
+        {
+            for (int ch = 0; ch < plan.numChannels; ++ch)
+                chunk.overrun.copyFrom(ch, (int)(pos - chunk.end), block, ch, 0, n);
+        }
+    }
+
+    out->flush();
+    chunk.ok = out->getStatus().wasOk();
+
+    if (!chunk.ok)
+        chunk.error = "write failed for " + chunk.temp.getFile().getFullPathName();
+}
+
+double OfflineRenderer::compareWithSerial(const juce::File& input, const ChunkPlan& plan,
+                                          const juce::OwnedArray<Chunk>& chunks) const
+{
+    auto reader = createReader(input);
+    auto processor = createProcessor(plan.numChannels, plan.sampleRate);
+
+    // A check that can't run counts as a full-scale mismatch
+    if (reader == nullptr || processor == nullptr)
+        return 0.0;
+
+    juce::AudioBuffer<float> buffer(plan.numChannels, plan.blockSize);
+    juce::AudioBuffer<float> stitched(plan.numChannels, plan.blockSize);
+    juce::HeapBlock<float> interleaved((size_t)(plan.numChannels * plan.blockSize));
+    juce::MidiBuffer midi;
+
+    float maxDiff = 0.0f;
+
+    for (auto* chunk : chunks)
+    {
+        juce::FileInputStream in(chunk->temp.getFile());
+
+        for (juce::int64 pos = chunk->start; pos < chunk->end; pos += plan.blockSize)
+        {
+            const int n = (int)juce::jmin((juce::int64)plan.blockSize, chunk->end - pos);
+            const int bytes = n * plan.numChannels * (int)sizeof(float);
+
+            juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), plan.numChannels, n);
+            readBlock(*reader, block, pos);
+            processor->processBlock(block, midi);
+
+            if (in.read(interleaved, bytes) != bytes)
+                return 0.0;
+
+            deinterleave(interleaved, stitched, n);
+
+            maxDiff = juce::jmax(maxDiff, getMaxDifference(block, 0, stitched, 0, n));
+        }
+    }
+
+    return juce::Decibels::gainToDecibels((double)maxDiff, silenceDb);
+}
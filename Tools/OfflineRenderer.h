@@ -0,0 +1,93 @@
+#pragma once
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+//==============================================================================
+// Renders audio files through LusionSmartReverbAudioProcessor without an
+// audio device. Files are streamed block by block, so memory use does not
+// depend on their length, and the full processBlock runs (AUTO, MODE,
+// ducking), exactly as in a host.
+//
+// One renderer can be shared by any number of worker threads: render() only
+// reads the options and creates its own processor, reader and writer.
+//
+// renderChunked() splits one long file into time chunks rendered in
+// parallel. Each chunk starts early enough for everything the plugin
+// remembers (reverb tail, level detector, duck envelope) to have forgotten
+// the missing history, to within errorFloorDb. The seams are then checked
+// by letting every chunk render a little past its end and comparing that
+// with the start of the next chunk.
+//==============================================================================
+struct RenderOptions
+{
+    juce::String presetXml;     // state as written by getStateAsXmlString(); empty = defaults
+    int blockSize = 512;        // host block size to simulate
+    double tailSeconds = 0.0;   // extra output after the input ends
+    int bitsPerSample = 0;      // 0 = same as the source (clamped to what the format supports)
+
+    // Chunked rendering
+    int numChunks = 1;
+    float errorFloorDb = -100.0f;       // allowed deviation from a serial render, dBFS
+    double seamCheckSeconds = 0.5;      // overlap compared at every seam
+    bool verifyAgainstSerial = false;   // also run a full serial render and compare
+};
+
+struct RenderResult
+{
+    bool ok = false;
+    juce::String error;
+
+    juce::int64 numSamples = 0; // samples written per channel
+    double sampleRate = 0.0;
+    double wallSeconds = 0.0;
+
+    // Chunked renders only
+    int numChunks = 1;
+    double prerollSeconds = 0.0;            // full processing before each chunk
+    double controlPrerollSeconds = 0.0;     // level detector only, before that
+    double seamDeviationDb = -300.0;        // worst seam mismatch, dBFS
+    bool serialVerified = false;
+    double serialDeviationDb = -300.0;      // worst mismatch against a serial render, dBFS
+
+    double getRealtimeFactor() const
+    {
+        return wallSeconds > 0.0 ? numSamples / sampleRate / wallSeconds : 0.0;
+    }
+};
+
+class OfflineRenderer
+{
+public:
+    explicit OfflineRenderer(const RenderOptions& options);
+
+    RenderResult render(const juce::File& input, const juce::File& output) const;
+
+    // Renders options.numChunks pieces of one file on the given pool and
+    // stitches them. Must not be called from one of the pool's own jobs.
+    RenderResult renderChunked(const juce::File& input, const juce::File& output, juce::ThreadPool& pool) const;
+
+    // Creates a processor with the preset applied, prepared for the given
+    // format and with any convolution IR fully loaded
+    std::unique_ptr<LusionSmartReverbAudioProcessor> createProcessor(int numChannels, double sampleRate) const;
+
+    std::unique_ptr<juce::AudioFormatReader> createReader(const juce::File& input) const;
+    std::unique_ptr<juce::AudioFormatWriter> createWriter(const juce::File& output, double sampleRate,
+                                                          int numChannels, int sourceBitsPerSample) const;
+
+    const RenderOptions& getOptions() const noexcept { return options; }
+
+private:
+    struct Chunk;
+    struct ChunkPlan;
+
+    void renderChunk(Chunk& chunk, const ChunkPlan& plan, const juce::File& input) const;
+    double compareWithSerial(const juce::File& input, const ChunkPlan& plan,
+                             const juce::OwnedArray<Chunk>& chunks) const;
+
+    RenderOptions options;
+    // Only its format list is read after construction, which is safe from
+    // several workers at once
+    mutable juce::AudioFormatManager formatManager;
+
+    JUCE_DECLARE_NON_COPYABLE(OfflineRenderer)
+};